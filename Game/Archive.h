@@ -0,0 +1,910 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define CHECKERS_ARCHIVE_MMAP
+#endif
+
+#include "../Models/Notation.h"
+#include "../Models/Project_path.h"
+#include "Logic.h"
+
+/**
+ * Архив партий: компактный двоичный файл, в который партии дописывает игра и инструменты самоигры,
+ * и индекс позиций к нему — «все партии, где встретилась позиция, и чем они кончились» без просмотра архива.
+ *
+ * Архив (<"ArchiveFile">_<вариант>.cga) — заголовок archive_header и партии подряд: заголовок archive_record
+ * с контрольной суммой, затем, если партия начата не с начальной расстановки, позиция (маски тёмных клеток),
+ * затем ходы. Ход — номер в списке допустимых ходов, упорядоченном канонически (archive_order), в
+ * ceil(log2(число ходов)) битах: вынужденный ход не занимает места, обычный — 3-5 бит. Партия пишется одним
+ * write в конец файла (O_APPEND), так что в один архив могут писать несколько процессов; оборванная падением
+ * партия в конце файла отбрасывается при открытии.
+ *
+ * Индекс (<архив>.idx) строит checkers_archive index: смещения партий и пары (хеш позиции, номер партии),
+ * отсортированные по хешу, с таблицей начал по старшим kArchiveFenceBits битам хеша. Файлы читаются через mmap
+ * (на других системах — в память целиком); запрос — двоичный поиск внутри одного отрезка таблицы.
+ * Партии, дописанные после построения индекса, при открытии разбираются в память — индекс стоит
+ * перестраивать, когда их много (перестройка сливает старый индекс с новыми партиями).
+ */
+struct archive_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t board; // клеток в ряду доски
+    uint64_t reserved[2];
+};
+static_assert(sizeof(archive_header) == 32, "archive_header layout");
+
+// заголовок партии; за ним — bytes байт: начальная позиция (флаг START) и биты ходов
+struct archive_record
+{
+    uint16_t check;
+    uint16_t bytes;
+    uint16_t plies;
+    uint8_t result; // как у Game::play: 0 — ничья, 1 — победа белых, 2 — победа чёрных
+    uint8_t flags;
+
+    static constexpr uint8_t START = 1;       // своя начальная позиция: три маски по 8 байт (белые, чёрные, дамки)
+    static constexpr uint8_t BLACK_FIRST = 2; // первыми ходят чёрные
+};
+static_assert(sizeof(archive_record) == 8, "archive_record layout");
+
+struct archive_index_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t fence_bits;
+    uint64_t games;      // партий в индексе — первые games партий архива
+    uint64_t data_bytes; // байт архива, которые они занимают (с заголовком архива)
+    uint64_t entries;
+    uint64_t reserved;
+};
+static_assert(sizeof(archive_index_header) == 48, "archive_index_header layout");
+
+// позиция hash встретилась в партии game (хеш — тремя словами, чтобы запись была 12 байт)
+struct archive_entry
+{
+    uint32_t lo, hi, game;
+
+    uint64_t hash() const
+    {
+        return uint64_t(hi) << 32 | lo;
+    }
+
+    bool operator<(const archive_entry &other) const
+    {
+        return hash() != other.hash() ? hash() < other.hash() : game < other.game;
+    }
+};
+static_assert(sizeof(archive_entry) == 12, "archive_entry layout");
+
+inline constexpr char kArchiveMagic[8] = {'C', 'H', 'K', 'G', 'A', 'M', 'E', 'S'};
+inline constexpr char kArchiveIndexMagic[8] = {'C', 'H', 'K', 'G', 'I', 'D', 'X', '1'};
+constexpr uint32_t kArchiveVersion = 1;
+constexpr uint32_t kArchiveFenceBits = 16;
+
+/**
+ * Файл архива для варианта variant по "Game" → "ArchiveFile" ("" — архив выключен).
+ */
+inline string archive_path(const Config &config, const string &variant)
+{
+    const string name = config("Game", "ArchiveFile");
+    return name.empty() ? "" : project_path + name + "_" + variant + ".cga";
+}
+
+// канонический порядок ходов: не зависит от перемешивания в find_turns
+inline bool archive_order(const move_pos &a, const move_pos &b)
+{
+    if (a.x != b.x || a.y != b.y)
+        return a.x != b.x ? a.x < b.x : a.y < b.y;
+    if (a.x2 != b.x2 || a.y2 != b.y2)
+        return a.x2 != b.x2 ? a.x2 < b.x2 : a.y2 < b.y2;
+    return a.captured != b.captured ? a.captured < b.captured : a.crown < b.crown;
+}
+
+// бит на ход при n допустимых ходах
+inline int archive_bits(const size_t n)
+{
+    int bits = 0;
+    while ((size_t(1) << bits) < n)
+        ++bits;
+    return bits;
+}
+
+inline uint16_t archive_checksum(const archive_record &r, const uint8_t *payload)
+{
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ (uint64_t(r.bytes) | uint64_t(r.plies) << 16 | uint64_t(r.result) << 32 |
+                                          uint64_t(r.flags) << 40);
+    h *= 0xBF58476D1CE4E5B9ull;
+    for (size_t i = 0; i < r.bytes; ++i)
+        h = (h ^ payload[i]) * 0x100000001B3ull;
+    h ^= h >> 29;
+    return uint16_t(h ^ h >> 16 ^ h >> 32 ^ h >> 48) | 1;
+}
+
+/**
+ * Файл только для чтения: mmap или копия в памяти.
+ */
+class archive_file
+{
+  public:
+    archive_file() = default;
+    archive_file(const archive_file &) = delete;
+    archive_file &operator=(const archive_file &) = delete;
+
+    ~archive_file()
+    {
+        close();
+    }
+
+    bool open(const string &path)
+    {
+        close();
+#ifdef CHECKERS_ARCHIVE_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        length = size_t(st.st_size);
+        if (length)
+        {
+            void *p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            mapping = p;
+        }
+        ::close(fd);
+        bytes = static_cast<const uint8_t *>(mapping);
+#else
+        ifstream fin(path, ios_base::binary | ios_base::ate);
+        if (!fin)
+            return false;
+        copy.resize(size_t(fin.tellg()));
+        fin.seekg(0);
+        fin.read(reinterpret_cast<char *>(copy.data()), streamsize(copy.size()));
+        length = copy.size();
+        bytes = copy.data();
+#endif
+        return true;
+    }
+
+    void close()
+    {
+#ifdef CHECKERS_ARCHIVE_MMAP
+        if (mapping)
+            munmap(mapping, length);
+        mapping = nullptr;
+#endif
+        copy.clear();
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const uint8_t *data() const
+    {
+        return bytes;
+    }
+
+    size_t size() const
+    {
+        return length;
+    }
+
+  private:
+    const uint8_t *bytes = nullptr;
+    size_t length = 0;
+#ifdef CHECKERS_ARCHIVE_MMAP
+    void *mapping = nullptr;
+#endif
+    vector<uint8_t> copy;
+};
+
+/**
+ * Конец последней целой партии архива data (size байт), начиная с партии по смещению from;
+ * on_game(смещение) — для каждой целой партии.
+ */
+template <class OnGame> uint64_t archive_scan(const uint8_t *data, const uint64_t size, uint64_t from, OnGame &&on_game)
+{
+    while (from + sizeof(archive_record) <= size)
+    {
+        archive_record r;
+        memcpy(&r, data + from, sizeof(r));
+        if (from + sizeof(r) + r.bytes > size || r.check != archive_checksum(r, data + from + sizeof(r)))
+            break;
+        on_game(from);
+        from += sizeof(r) + r.bytes;
+    }
+    return from;
+}
+
+// партия из архива
+struct archived_game
+{
+    vector<vector<POS_T>> start;
+    bool color = false; // кто ходит первым
+    int result = 0;     // как у Game::play
+    vector<move_pos> moves;
+};
+
+/**
+ * Кодирование партий: ходы — номера в каноническом списке допустимых ходов.
+ * Не потокобезопасно (общий генератор ходов).
+ */
+template <class Rules> class BasicArchiveCodec
+{
+  public:
+    static constexpr int N = Rules::size;
+
+    explicit BasicArchiveCodec(Config *config) : logic(config, make_shared<TranspositionTable>(0))
+    {
+    }
+
+    // допустимые ходы в каноническом порядке
+    const vector<move_pos> &moves(const bool color, const vector<vector<POS_T>> &mtx)
+    {
+        logic.find_turns(color, mtx);
+        sort(logic.turns.begin(), logic.turns.end(), archive_order);
+        return logic.turns;
+    }
+
+    vector<vector<POS_T>> make_turn(const vector<vector<POS_T>> &mtx, const move_pos &turn) const
+    {
+        return logic.make_turn(mtx, turn);
+    }
+
+    /**
+     * Запись партии (заголовок и данные) в out. false — ход не из допустимых или партия слишком длинная.
+     */
+    bool encode(const vector<vector<POS_T>> &start, const bool color, const vector<move_pos> &turns, const int result,
+                vector<uint8_t> &out)
+    {
+        archive_record r{};
+        r.result = uint8_t(result);
+        r.flags = uint8_t(color ? archive_record::BLACK_FIRST : 0);
+        out.assign(sizeof(r), 0);
+        if (start != start_position(N))
+        {
+            r.flags |= archive_record::START;
+            uint64_t masks[3] = {};
+            for (POS_T i = 0; i < N; ++i)
+                for (POS_T j = 0; j < N; ++j)
+                    if (start[i][j])
+                    {
+                        const uint64_t bit = uint64_t(1) << ((i * N + j) / 2);
+                        masks[start[i][j] % 2 ? 0 : 1] |= bit;
+                        if (start[i][j] > 2)
+                            masks[2] |= bit;
+                    }
+            out.insert(out.end(), reinterpret_cast<const uint8_t *>(masks), reinterpret_cast<const uint8_t *>(masks + 3));
+        }
+        vector<vector<POS_T>> mtx = start;
+        bool side = color;
+        uint32_t acc = 0;
+        int filled = 0;
+        for (const auto &turn : turns)
+        {
+            const auto &legal = moves(side, mtx);
+            const auto it = find(legal.begin(), legal.end(), turn);
+            if (it == legal.end())
+                return false;
+            const int bits = archive_bits(legal.size());
+            acc |= uint32_t(it - legal.begin()) << filled;
+            filled += bits;
+            while (filled >= 8)
+            {
+                out.push_back(uint8_t(acc));
+                acc >>= 8;
+                filled -= 8;
+            }
+            mtx = logic.make_turn(mtx, *it);
+            side = !side;
+        }
+        if (filled)
+            out.push_back(uint8_t(acc));
+        if (turns.size() > 0xFFFF || out.size() - sizeof(r) > 0xFFFF)
+            return false;
+        r.plies = uint16_t(turns.size());
+        r.bytes = uint16_t(out.size() - sizeof(r));
+        r.check = archive_checksum(r, out.data() + sizeof(r));
+        memcpy(out.data(), &r, sizeof(r));
+        return true;
+    }
+
+    /**
+     * Разыгрывает партию по смещению offset архива data: visit(номер полухода, позиция, кто ходит, хеш)
+     * для начальной позиции и после каждого хода. Партия — в game, если он не nullptr.
+     */
+    template <class Visit> bool replay(const uint8_t *data, const uint64_t offset, Visit &&visit, archived_game *game = nullptr)
+    {
+        archive_record r;
+        memcpy(&r, data + offset, sizeof(r));
+        const uint8_t *p = data + offset + sizeof(r), *end = p + r.bytes;
+        vector<vector<POS_T>> mtx = start_position(N);
+        if (r.flags & archive_record::START)
+        {
+            uint64_t masks[3];
+            if (end - p < ptrdiff_t(sizeof(masks)))
+                return false;
+            memcpy(masks, p, sizeof(masks));
+            p += sizeof(masks);
+            mtx.assign(N, vector<POS_T>(N, 0));
+            for (int s = 0; s < N * N / 2; ++s)
+            {
+                const uint64_t bit = uint64_t(1) << s;
+                const int i = 2 * s / N, j = 2 * s % N + ((2 * s / N + 2 * s % N) % 2 == 0);
+                if (masks[0] & bit)
+                    mtx[i][j] = (masks[2] & bit) ? 3 : 1;
+                else if (masks[1] & bit)
+                    mtx[i][j] = (masks[2] & bit) ? 4 : 2;
+            }
+        }
+        const auto &zobrist = BasicZobrist<N>::get();
+        bool side = (r.flags & archive_record::BLACK_FIRST) != 0;
+        if (game)
+        {
+            game->start = mtx;
+            game->color = side;
+            game->result = r.result;
+            game->moves.clear();
+        }
+        uint64_t hash = zobrist.hash(mtx, side);
+        visit(0, mtx, side, hash);
+        uint32_t acc = 0;
+        int filled = 0;
+        for (int ply = 1; ply <= r.plies; ++ply)
+        {
+            const auto &legal = moves(side, mtx);
+            const int bits = archive_bits(legal.size());
+            while (filled < bits)
+            {
+                if (p == end)
+                    return false;
+                acc |= uint32_t(*p++) << filled;
+                filled += 8;
+            }
+            const uint32_t k = acc & ((uint32_t(1) << bits) - 1);
+            acc >>= bits;
+            filled -= bits;
+            if (k >= legal.size())
+                return false;
+            const move_pos turn = legal[k];
+            if (game)
+                game->moves.push_back(turn);
+            hash = zobrist.after(hash, mtx, turn) ^ zobrist.side;
+            mtx = logic.make_turn(mtx, turn);
+            side = !side;
+            visit(ply, mtx, side, hash);
+        }
+        return true;
+    }
+
+  private:
+    BasicLogic<Rules> logic;
+};
+
+/**
+ * Запись в архив. append можно вызывать из нескольких потоков.
+ */
+template <class Rules> class BasicArchiveWriter
+{
+  public:
+    explicit BasicArchiveWriter(Config *config) : codec(config)
+    {
+    }
+
+    BasicArchiveWriter(const BasicArchiveWriter &) = delete;
+    BasicArchiveWriter &operator=(const BasicArchiveWriter &) = delete;
+
+    ~BasicArchiveWriter()
+    {
+        close();
+    }
+
+    /**
+     * Открывает (или создаёт) архив path на дозапись; оборванная партия в конце отбрасывается.
+     * false — файл не открыть или это не архив этого варианта.
+     */
+    bool open(const string &path)
+    {
+        close();
+        uint64_t from = sizeof(archive_header);
+        {
+            ifstream fin(path, ios_base::binary);
+            if (!fin)
+            {
+                ofstream fout(path, ios_base::binary | ios_base::trunc);
+                const archive_header h = make_header();
+                fout.write(reinterpret_cast<const char *>(&h), sizeof(h));
+                if (!fout)
+                    return false;
+            }
+            else
+            {
+                archive_header h{};
+                if (!fin.read(reinterpret_cast<char *>(&h), sizeof(h)) || memcmp(h.magic, kArchiveMagic, 8) ||
+                    h.version != kArchiveVersion || h.board != uint32_t(Rules::size))
+                    return false;
+                // партии под индексом уже проверены при его построении
+                archive_index_header ih{};
+                ifstream fidx(path + ".idx", ios_base::binary);
+                if (fidx.read(reinterpret_cast<char *>(&ih), sizeof(ih)) && !memcmp(ih.magic, kArchiveIndexMagic, 8))
+                    from = ih.data_bytes;
+            }
+        }
+        archive_file file;
+        if (!file.open(path))
+            return false;
+        if (from > file.size())
+            from = sizeof(archive_header);
+        const uint64_t valid = archive_scan(file.data(), file.size(), from, [](uint64_t) {});
+        const bool torn = (valid < file.size());
+        file.close();
+        if (torn)
+            truncate_tail(path, valid);
+#ifdef CHECKERS_ARCHIVE_MMAP
+        fd = ::open(path.c_str(), O_WRONLY | O_APPEND);
+        return fd >= 0;
+#else
+        out = fopen(path.c_str(), "ab");
+        return out != nullptr;
+#endif
+    }
+
+    bool is_open() const
+    {
+#ifdef CHECKERS_ARCHIVE_MMAP
+        return fd >= 0;
+#else
+        return out != nullptr;
+#endif
+    }
+
+    void close()
+    {
+#ifdef CHECKERS_ARCHIVE_MMAP
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+#else
+        if (out)
+            fclose(out);
+        out = nullptr;
+#endif
+    }
+
+    /**
+     * Партия из позиции start (первым ходит color) ходами turns (полные серии) с итогом result (как у Game::play).
+     */
+    bool append(const vector<vector<POS_T>> &start, const bool color, const vector<move_pos> &turns, const int result)
+    {
+        lock_guard<mutex> lock(m);
+        if (!is_open() || !codec.encode(start, color, turns, result, buffer))
+            return false;
+#ifdef CHECKERS_ARCHIVE_MMAP
+        return ::write(fd, buffer.data(), buffer.size()) == ssize_t(buffer.size());
+#else
+        const bool ok = fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+        fflush(out);
+        return ok;
+#endif
+    }
+
+    /**
+     * Партия по позициям: positions[0] — начальная (первым ходит color), каждая следующая — после одного хода.
+     */
+    bool append_positions(const vector<vector<vector<POS_T>>> &positions, bool color, const int result)
+    {
+        if (positions.empty())
+            return false;
+        vector<move_pos> turns;
+        {
+            lock_guard<mutex> lock(m);
+            bool side = color;
+            for (size_t k = 1; k < positions.size(); ++k, side = !side)
+            {
+                const auto &legal = codec.moves(side, positions[k - 1]);
+                const auto it = find_if(legal.begin(), legal.end(), [&](const move_pos &turn) {
+                    return codec.make_turn(positions[k - 1], turn) == positions[k];
+                });
+                if (it == legal.end())
+                    return false;
+                turns.push_back(*it);
+            }
+        }
+        return append(positions[0], color, turns, result);
+    }
+
+  private:
+    static archive_header make_header()
+    {
+        archive_header h{};
+        memcpy(h.magic, kArchiveMagic, sizeof(h.magic));
+        h.version = kArchiveVersion;
+        h.board = uint32_t(Rules::size);
+        return h;
+    }
+
+    // отбрасывает партию, оборванную падением процесса, чтобы новые не легли за ней
+    static void truncate_tail(const string &path, const uint64_t valid_size)
+    {
+#ifdef CHECKERS_ARCHIVE_MMAP
+        if (::truncate(path.c_str(), off_t(valid_size)) != 0)
+            return;
+#else
+        ifstream fin(path, ios_base::binary);
+        vector<char> data(size_t(valid_size));
+        fin.read(data.data(), streamsize(data.size()));
+        fin.close();
+        ofstream fout(path, ios_base::binary | ios_base::trunc);
+        fout.write(data.data(), streamsize(data.size()));
+#endif
+    }
+
+    BasicArchiveCodec<Rules> codec;
+    mutex m;
+    vector<uint8_t> buffer;
+#ifdef CHECKERS_ARCHIVE_MMAP
+    int fd = -1;
+#else
+    FILE *out = nullptr;
+#endif
+};
+
+/**
+ * Чтение архива и поиск партий по позиции. Не потокобезопасно.
+ */
+template <class Rules> class BasicArchive
+{
+  public:
+    explicit BasicArchive(Config *config) : codec(config)
+    {
+    }
+
+    /**
+     * Открывает архив path и его индекс (если он есть и подходит). Партии после индекса разбираются в память,
+     * если index_tail (построению индекса это не нужно). false — файл не открыть или это не архив.
+     */
+    bool open(const string &path, const bool index_tail = true)
+    {
+        close();
+        archive_header h{};
+        if (!data.open(path) || data.size() < sizeof(h))
+            return false;
+        memcpy(&h, data.data(), sizeof(h));
+        if (memcmp(h.magic, kArchiveMagic, 8) || h.version != kArchiveVersion || h.board != uint32_t(Rules::size))
+            return false;
+        uint64_t from = sizeof(h);
+        archive_index_header ih{};
+        if (index.open(path + ".idx") && index.size() >= sizeof(ih))
+        {
+            memcpy(&ih, index.data(), sizeof(ih));
+            const uint64_t fences = (uint64_t(1) << ih.fence_bits) + 1;
+            if (!memcmp(ih.magic, kArchiveIndexMagic, 8) && ih.version == kArchiveVersion &&
+                ih.fence_bits == kArchiveFenceBits && ih.data_bytes <= data.size() &&
+                index.size() == sizeof(ih) + 8 * (ih.games + fences) + sizeof(archive_entry) * ih.entries)
+            {
+                indexed = size_t(ih.games);
+                offsets = reinterpret_cast<const uint64_t *>(index.data() + sizeof(ih));
+                fence = offsets + ih.games;
+                entries = reinterpret_cast<const archive_entry *>(fence + fences);
+                entry_count = size_t(ih.entries);
+                from = ih.data_bytes;
+            }
+            else
+            {
+                stale = true;
+                index.close();
+            }
+        }
+        end = archive_scan(data.data(), data.size(), from, [&](const uint64_t offset) { tail.push_back(offset); });
+        if (index_tail)
+            for (size_t k = 0; k < tail.size(); ++k)
+            {
+                vector<uint64_t> hashes;
+                codec.replay(data.data(), tail[k], [&](int, const vector<vector<POS_T>> &, bool, const uint64_t hash) {
+                    hashes.push_back(hash);
+                });
+                sort(hashes.begin(), hashes.end());
+                hashes.erase(unique(hashes.begin(), hashes.end()), hashes.end());
+                for (const uint64_t hash : hashes)
+                    recent[hash].push_back(uint32_t(indexed + k));
+            }
+        return true;
+    }
+
+    void close()
+    {
+        data.close();
+        index.close();
+        indexed = entry_count = 0;
+        offsets = fence = nullptr;
+        entries = nullptr;
+        tail.clear();
+        recent.clear();
+        stale = false;
+        end = 0;
+    }
+
+    size_t games() const
+    {
+        return indexed + tail.size();
+    }
+
+    // партий под индексом (остальные разобраны при открытии)
+    size_t indexed_games() const
+    {
+        return indexed;
+    }
+
+    // индекс есть, но к архиву не подходит (архив заменён или обрезан) — его нужно перестроить
+    bool index_stale() const
+    {
+        return stale;
+    }
+
+    // байт архива с целыми партиями
+    uint64_t data_bytes() const
+    {
+        return end;
+    }
+
+    const uint8_t *bytes() const
+    {
+        return data.data();
+    }
+
+    uint64_t offset(const size_t game) const
+    {
+        return game < indexed ? offsets[game] : tail[game - indexed];
+    }
+
+    archive_record record(const size_t game) const
+    {
+        archive_record r;
+        memcpy(&r, data.data() + offset(game), sizeof(r));
+        return r;
+    }
+
+    bool game(const size_t id, archived_game &out)
+    {
+        return codec.replay(data.data(), offset(id), [](int, const vector<vector<POS_T>> &, bool, uint64_t) {}, &out);
+    }
+
+    // разыгрывает партию id, см. BasicArchiveCodec::replay
+    template <class Visit> bool replay(const size_t id, Visit &&visit, archived_game *out = nullptr)
+    {
+        return codec.replay(data.data(), offset(id), visit, out);
+    }
+
+    /**
+     * Номера партий, в которых встретилась позиция с хешем hash (Zobrist::hash с учётом стороны хода), по возрастанию.
+     */
+    vector<uint32_t> find(const uint64_t hash) const
+    {
+        vector<uint32_t> res;
+        if (entries)
+        {
+            const uint64_t bucket = hash >> (64 - kArchiveFenceBits);
+            const archive_entry *first = entries + fence[bucket], *last = entries + fence[bucket + 1];
+            const archive_entry key{uint32_t(hash), uint32_t(hash >> 32), 0};
+            for (auto it = lower_bound(first, last, key); it != last && it->hash() == hash; ++it)
+                res.push_back(it->game);
+        }
+        const auto it = recent.find(hash);
+        if (it != recent.end())
+            res.insert(res.end(), it->second.begin(), it->second.end());
+        return res;
+    }
+
+    // записи индекса (по возрастанию хеша) — для его перестройки
+    const archive_entry *index_entries() const
+    {
+        return entries;
+    }
+
+    size_t index_size() const
+    {
+        return entry_count;
+    }
+
+  private:
+    BasicArchiveCodec<Rules> codec;
+    archive_file data, index;
+    size_t indexed = 0, entry_count = 0;
+    const uint64_t *offsets = nullptr, *fence = nullptr;
+    const archive_entry *entries = nullptr;
+    // партии после индекса: смещения и позиции
+    vector<uint64_t> tail;
+    unordered_map<uint64_t, vector<uint32_t>> recent;
+    bool stale = false;
+    uint64_t end = 0;
+};
+
+/**
+ * Строит индекс архива path (<path>.idx): старый индекс сливается с позициями новых партий.
+ * Позиции копятся в памяти по memory_mb мегабайт, сортируются и сбрасываются во временные файлы,
+ * затем все части сливаются в новый индекс, который атомарно подменяет старый. progress(партий разобрано).
+ */
+template <class Rules, class Progress>
+bool build_archive_index(Config *config, const string &path, const size_t memory_mb, Progress &&progress)
+{
+    BasicArchive<Rules> archive(config);
+    if (!archive.open(path, false))
+        return false;
+    const size_t chunk = max<size_t>(1 << 16, memory_mb * 1024 * 1024 / sizeof(archive_entry));
+
+    // отсортированные части: новые позиции во временных файлах
+    vector<string> runs;
+    vector<archive_entry> buffer;
+    uint64_t total = archive.index_size();
+    auto flush = [&]() {
+        if (buffer.empty())
+            return true;
+        sort(buffer.begin(), buffer.end());
+        runs.push_back(path + ".run" + to_string(runs.size()));
+        ofstream fout(runs.back(), ios_base::binary | ios_base::trunc);
+        fout.write(reinterpret_cast<const char *>(buffer.data()), streamsize(buffer.size() * sizeof(archive_entry)));
+        total += buffer.size();
+        buffer.clear();
+        return bool(fout);
+    };
+    auto remove_runs = [&]() {
+        for (const auto &run : runs)
+            remove(run.c_str());
+    };
+    vector<uint64_t> hashes;
+    for (size_t g = archive.indexed_games(); g < archive.games(); ++g)
+    {
+        hashes.clear();
+        archive.replay(g, [&](int, const vector<vector<POS_T>> &, bool, const uint64_t hash) { hashes.push_back(hash); });
+        sort(hashes.begin(), hashes.end());
+        hashes.erase(unique(hashes.begin(), hashes.end()), hashes.end());
+        for (const uint64_t hash : hashes)
+            buffer.push_back(archive_entry{uint32_t(hash), uint32_t(hash >> 32), uint32_t(g)});
+        if (buffer.size() >= chunk && !flush())
+        {
+            remove_runs();
+            return false;
+        }
+        if ((g + 1) % 100000 == 0)
+            progress(g + 1);
+    }
+    if (!flush())
+    {
+        remove_runs();
+        return false;
+    }
+
+    // слияние: старый индекс и части, чтение частей блоками
+    struct run_reader
+    {
+        ifstream in;
+        vector<archive_entry> block;
+        size_t pos = 0;
+
+        bool next(archive_entry &e)
+        {
+            if (pos == block.size())
+            {
+                block.resize(1 << 16);
+                in.read(reinterpret_cast<char *>(block.data()), streamsize(block.size() * sizeof(archive_entry)));
+                block.resize(size_t(in.gcount()) / sizeof(archive_entry));
+                pos = 0;
+                if (block.empty())
+                    return false;
+            }
+            e = block[pos++];
+            return true;
+        }
+    };
+    vector<run_reader> readers(runs.size());
+    using head = pair<archive_entry, size_t>; // запись и её источник (runs.size() — старый индекс)
+    auto later = [](const head &a, const head &b) { return b.first < a.first; };
+    priority_queue<head, vector<head>, decltype(later)> heads(later);
+    for (size_t k = 0; k < runs.size(); ++k)
+    {
+        readers[k].in.open(runs[k], ios_base::binary);
+        archive_entry e;
+        if (readers[k].next(e))
+            heads.push({e, k});
+    }
+    const archive_entry *old = archive.index_entries();
+    size_t old_pos = 0;
+    if (old_pos < archive.index_size())
+        heads.push({old[old_pos++], runs.size()});
+
+    const string tmp = path + ".idx.tmp";
+    const uint64_t fences = (uint64_t(1) << kArchiveFenceBits) + 1;
+    vector<uint64_t> fence(fences, 0);
+    {
+        ofstream fout(tmp, ios_base::binary | ios_base::trunc);
+        archive_index_header h{};
+        memcpy(h.magic, kArchiveIndexMagic, sizeof(h.magic));
+        h.version = kArchiveVersion;
+        h.fence_bits = kArchiveFenceBits;
+        h.games = archive.games();
+        h.data_bytes = archive.data_bytes();
+        h.entries = total;
+        fout.write(reinterpret_cast<const char *>(&h), sizeof(h));
+        for (size_t g = 0; g < archive.games(); ++g)
+        {
+            const uint64_t offset = archive.offset(g);
+            fout.write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+        }
+        const auto fence_pos = fout.tellp();
+        fout.write(reinterpret_cast<const char *>(fence.data()), streamsize(fence.size() * sizeof(uint64_t)));
+        vector<archive_entry> out;
+        out.reserve(1 << 16);
+        uint64_t written = 0;
+        size_t next_bucket = 0;
+        while (!heads.empty())
+        {
+            const head top = heads.top();
+            heads.pop();
+            const size_t bucket = size_t(top.first.hash() >> (64 - kArchiveFenceBits));
+            while (next_bucket <= bucket)
+                fence[next_bucket++] = written;
+            out.push_back(top.first);
+            ++written;
+            if (out.size() == out.capacity())
+            {
+                fout.write(reinterpret_cast<const char *>(out.data()), streamsize(out.size() * sizeof(archive_entry)));
+                out.clear();
+            }
+            archive_entry e;
+            if (top.second == runs.size())
+            {
+                if (old_pos < archive.index_size())
+                    heads.push({old[old_pos++], top.second});
+            }
+            else if (readers[top.second].next(e))
+                heads.push({e, top.second});
+        }
+        fout.write(reinterpret_cast<const char *>(out.data()), streamsize(out.size() * sizeof(archive_entry)));
+        while (next_bucket < fences)
+            fence[next_bucket++] = written;
+        fout.seekp(fence_pos);
+        fout.write(reinterpret_cast<const char *>(fence.data()), streamsize(fence.size() * sizeof(uint64_t)));
+        fout.flush();
+        if (!fout || written != total)
+        {
+            remove_runs();
+            remove(tmp.c_str());
+            return false;
+        }
+    }
+    readers.clear();
+    remove_runs();
+    archive.close();
+#ifndef CHECKERS_ARCHIVE_MMAP
+    // rename в Windows не заменяет существующий файл
+    remove((path + ".idx").c_str());
+#endif
+    return rename(tmp.c_str(), (path + ".idx").c_str()) == 0;
+}
+
+using ArchiveWriter = BasicArchiveWriter<russian_rules>;
+using Archive = BasicArchive<russian_rules>;
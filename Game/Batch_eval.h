@@ -0,0 +1,244 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "Simd.h"
+#include "Weights.h"
+
+/**
+ * Пакет позиций для одновременной оценки (structure-of-arrays).
+ * Каждая позиция — четыре 32-битные маски по тёмным клеткам (номер i * 4 + j / 2):
+ * белые шашки, белые дамки, чёрные шашки, чёрные дамки.
+ */
+struct leaf_batch
+{
+    std::vector<uint32_t> wm, wk, bm, bk;
+
+    size_t size() const
+    {
+        return wm.size();
+    }
+
+    void clear()
+    {
+        wm.clear();
+        wk.clear();
+        bm.clear();
+        bk.clear();
+    }
+
+    void push(const uint32_t w_men, const uint32_t w_kings, const uint32_t b_men, const uint32_t b_kings)
+    {
+        wm.push_back(w_men);
+        wk.push_back(w_kings);
+        bm.push_back(b_men);
+        bk.push_back(b_kings);
+    }
+};
+
+/**
+ * Оценка материала в фиксированной точке (Q16) сразу для пакета позиций.
+ *
+ * Сила стороны: сумма по рядам man[продвижение] × число шашек в ряду + king × число дамок.
+ * Число шашек в ряду — popcount полубайта маски (в ряду 4 тёмные клетки), что на AVX2/SSE4.1
+ * считается через pshufb по таблице из 16 значений для 8/4 позиций за инструкцию; ядро выбирается
+ * во время выполнения (Simd.h), так что работает и в сборке без -march=native.
+ * Результат совпадает с прежним calc_score: отношение силы «числителя» к силе «знаменателя»,
+ * только в целых Q16 вместо double.
+ */
+class BatchEval
+{
+  public:
+    static constexpr int kShift = 16;
+    static constexpr int64_t kOne = int64_t(1) << kShift;
+
+    BatchEval() = default;
+
+    /**
+     * potential = false — режим "NumberOnly" (шашка 1, дамка 4), иначе веса из weights.
+     */
+    BatchEval(const EvalWeights &weights, const bool potential)
+    {
+        for (int row = 0; row < 8; ++row)
+        {
+            white_row[row] = int32_t(potential ? lround(weights.man[7 - row] * kOne) : kOne);
+            black_row[row] = int32_t(potential ? lround(weights.man[row] * kOne) : kOne);
+        }
+        king = int32_t(potential ? lround(weights.king * kOne) : 4 * kOne);
+    }
+
+    /**
+     * Упаковывает матрицу доски в четыре маски.
+     */
+    static void pack(const std::vector<std::vector<POS_T>> &mtx, uint32_t &wm, uint32_t &wk, uint32_t &bm, uint32_t &bk)
+    {
+        wm = wk = bm = bk = 0;
+        for (POS_T i = 0; i < 8; ++i)
+        {
+            for (POS_T j = 1 - i % 2; j < 8; j += 2)
+            {
+                const uint32_t bit = 1u << (i * 4 + j / 2);
+                switch (mtx[i][j])
+                {
+                case 1: wm |= bit; break;
+                case 2: bm |= bit; break;
+                case 3: wk |= bit; break;
+                case 4: bk |= bit; break;
+                default: break;
+                }
+            }
+        }
+    }
+
+    /**
+     * Оценивает все позиции пакета. out[k] — отношение в Q16 (чем больше, тем лучше для «числителя»),
+     * INF_Q16 — у «знаменателя» нет фигур, 0 — у «числителя» нет фигур.
+     * first_bot_color == true: числитель — чёрные, знаменатель — белые (как в calc_score).
+     */
+    void evaluate(const leaf_batch &batch, const bool first_bot_color, std::vector<int64_t> &out) const
+    {
+        const size_t n = batch.size();
+        white.resize(n);
+        black.resize(n);
+        size_t k = 0;
+        const simd_level simd = cpu_simd();
+#if defined(CHECKERS_SIMD_AVX2)
+        if (simd == simd_level::AVX2)
+            k = strength_avx2(batch);
+#endif
+#if defined(CHECKERS_SIMD_SSE41)
+        if (simd == simd_level::SSE41)
+            k = strength_sse41(batch);
+#endif
+        for (; k < n; ++k)
+        {
+            white[k] = strength(batch.wm[k], batch.wk[k], white_row);
+            black[k] = strength(batch.bm[k], batch.bk[k], black_row);
+        }
+        out.resize(n);
+        for (k = 0; k < n; ++k)
+            out[k] = first_bot_color ? ratio(black[k], white[k]) : ratio(white[k], black[k]);
+    }
+
+    /**
+     * Оценка одной позиции тем же способом (скалярный путь).
+     */
+    int64_t evaluate(const uint32_t wm, const uint32_t wk, const uint32_t bm, const uint32_t bk,
+                     const bool first_bot_color) const
+    {
+        const int32_t w = strength(wm, wk, white_row), b = strength(bm, bk, black_row);
+        return first_bot_color ? ratio(b, w) : ratio(w, b);
+    }
+
+    static constexpr int64_t INF_Q16 = int64_t(1e9) << kShift;
+
+  private:
+    static int64_t ratio(const int32_t num, const int32_t den)
+    {
+        if (den == 0)
+            return INF_Q16;
+        if (num == 0)
+            return 0;
+        return (int64_t(num) << kShift) / den;
+    }
+
+    static int popcount4(const uint32_t v)
+    {
+        static const uint8_t count[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+        return count[v & 15];
+    }
+
+    int32_t strength(const uint32_t men, const uint32_t kings, const int32_t *row_value) const
+    {
+        int32_t res = 0;
+        for (int row = 0; row < 8; ++row)
+            res += row_value[row] * popcount4(men >> (4 * row));
+        int kings_count = 0;
+        for (uint32_t v = kings; v; v >>= 4)
+            kings_count += popcount4(v);
+        return res + kings_count * king;
+    }
+
+#if defined(CHECKERS_SIMD_AVX2)
+    // сила сторон пакета по 8 позиций; возвращает, сколько позиций посчитано (остаток — скалярно)
+    CHECKERS_TARGET_AVX2 size_t strength_avx2(const leaf_batch &batch) const
+    {
+        size_t k = 0;
+        for (; k + 8 <= batch.size(); k += 8)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(&white[k]),
+                                strength8(&batch.wm[k], &batch.wk[k], white_row));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(&black[k]),
+                                strength8(&batch.bm[k], &batch.bk[k], black_row));
+        }
+        return k;
+    }
+
+    CHECKERS_TARGET_AVX2 __m256i strength8(const uint32_t *men_ptr, const uint32_t *kings_ptr,
+                                           const int32_t *row_value) const
+    {
+        const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1,
+                                             2, 2, 3, 2, 3, 3, 4);
+        const __m256i nibble = _mm256_set1_epi32(15);
+        const __m256i men = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(men_ptr));
+        const __m256i kings = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(kings_ptr));
+        __m256i res = _mm256_setzero_si256();
+        for (int row = 0; row < 8; ++row)
+        {
+            const __m256i cnt = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi32(men, 4 * row), nibble));
+            res = _mm256_add_epi32(res, _mm256_mullo_epi32(cnt, _mm256_set1_epi32(row_value[row])));
+        }
+        // popcount дамок: счёт по байтам через два полубайта, затем сумма байтов умножением на 0x01010101
+        const __m256i low = _mm256_set1_epi8(15);
+        __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(kings, low)),
+                                        _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi32(kings, 4), low)));
+        __m256i kcnt = _mm256_srli_epi32(_mm256_mullo_epi32(bytes, _mm256_set1_epi32(0x01010101)), 24);
+        return _mm256_add_epi32(res, _mm256_mullo_epi32(kcnt, _mm256_set1_epi32(king)));
+    }
+#endif
+
+#if defined(CHECKERS_SIMD_SSE41)
+    // то же по 4 позиции
+    CHECKERS_TARGET_SSE41 size_t strength_sse41(const leaf_batch &batch) const
+    {
+        size_t k = 0;
+        for (; k + 4 <= batch.size(); k += 4)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&white[k]), strength4(&batch.wm[k], &batch.wk[k], white_row));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&black[k]), strength4(&batch.bm[k], &batch.bk[k], black_row));
+        }
+        return k;
+    }
+
+    CHECKERS_TARGET_SSE41 __m128i strength4(const uint32_t *men_ptr, const uint32_t *kings_ptr,
+                                            const int32_t *row_value) const
+    {
+        const __m128i lut = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m128i nibble = _mm_set1_epi32(15);
+        const __m128i men = _mm_loadu_si128(reinterpret_cast<const __m128i *>(men_ptr));
+        const __m128i kings = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kings_ptr));
+        __m128i res = _mm_setzero_si128();
+        for (int row = 0; row < 8; ++row)
+        {
+            const __m128i cnt = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi32(men, 4 * row), nibble));
+            res = _mm_add_epi32(res, _mm_mullo_epi32(cnt, _mm_set1_epi32(row_value[row])));
+        }
+        const __m128i low = _mm_set1_epi8(15);
+        __m128i bytes = _mm_add_epi8(_mm_shuffle_epi8(lut, _mm_and_si128(kings, low)),
+                                     _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi32(kings, 4), low)));
+        __m128i kcnt = _mm_srli_epi32(_mm_mullo_epi32(bytes, _mm_set1_epi32(0x01010101)), 24);
+        return _mm_add_epi32(res, _mm_mullo_epi32(kcnt, _mm_set1_epi32(king)));
+    }
+#endif
+
+    // стоимость шашки в Q16 по рядам доски (ряд 0 — верх) для белых и чёрных
+    int32_t white_row[8] = {};
+    int32_t black_row[8] = {};
+    // стоимость дамки в Q16
+    int32_t king = 0;
+
+    // рабочие буферы (сила сторон по позициям пакета)
+    mutable std::vector<int32_t> white, black;
+};
@@ -0,0 +1,495 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "Batch_eval.h"
+#include "Diagonals.h"
+#include "Simd.h"
+#include "Variant.h"
+
+/**
+ * Ходы пакета позиций (leaf_batch) — для задач, где позиций много и они независимы:
+ * perft, разыгрывания, построение баз, пакетный анализ.
+ *
+ * Позиции пакета — маски тёмных клеток 8x8 (номер i * 4 + j / 2, как в BatchEval и move_pos::captured),
+ * сторона хода у всех одна (позиции с разной стороной хода — разными пакетами).
+ * Тихие ходы считаются битбордами сразу для 8 (AVX2) / 4 (SSE4.1) позиций: сдвиг маски —
+ * шаг по диагонали для всех фигур, popcount по полубайтам через pshufb — число ходов.
+ * Ширина ядра выбирается во время выполнения по процессору (cpu_simd, Simd.h).
+ * Для каждого направления клетки, куда можно пойти, у разных фигур не совпадают
+ * (луч дамки упирается в первую фигуру), поэтому сумма popcount по направлениям — точное число ходов.
+ * Там же определяется, есть ли взятие; серии взятий в таких позициях перебираются по одной позиции
+ * тоже на масках — по тем же правилам, что BasicLogic::find_turns (турецкий удар, превращение по ходу серии,
+ * одинаковые по результату пути — один ход).
+ * Списки ходов — в том же виде, что BasicLogic::turns (полные серии), порядок ходов может отличаться.
+ */
+struct move_batch
+{
+    // число ходов позиции k
+    std::vector<uint32_t> count;
+    // ходы позиции k — moves[first[k] .. first[k] + count[k]) (только если списки запрошены)
+    std::vector<uint32_t> first;
+    std::vector<move_pos> moves;
+};
+
+template <class Rules> class BasicBatchMoveGen
+{
+    static_assert(Rules::size == 8, "batch move generation uses 32-bit masks of the 8x8 board");
+
+  public:
+    /**
+     * Ходы стороны color во всех позициях batch: out.count, а при lists == true — и списки.
+     */
+    void generate(const leaf_batch &batch, const bool color, move_batch &out, const bool lists = true)
+    {
+        const size_t n = batch.size();
+        out.count.resize(n);
+        captures.resize(n);
+        size_t k = 0;
+        const simd_level simd = cpu_simd();
+#if defined(CHECKERS_SIMD_AVX2)
+        if (simd == simd_level::AVX2)
+            k = kernels_avx2(batch, color, out.count.data(), captures.data());
+#endif
+#if defined(CHECKERS_SIMD_SSE41)
+        if (simd == simd_level::SSE41)
+            k = kernels_sse41(batch, color, out.count.data(), captures.data());
+#endif
+        for (; k < n; ++k)
+            kernel<scalar_lanes>(batch, k, color, out.count.data(), captures.data());
+
+        out.first.clear();
+        out.moves.clear();
+        if (lists)
+            out.first.resize(n);
+        for (k = 0; k < n; ++k)
+        {
+            if (lists)
+                out.first[k] = uint32_t(out.moves.size());
+            if (captures[k])
+            {
+                series.clear();
+                capture_moves(batch.wm[k], batch.wk[k], batch.bm[k], batch.bk[k], color, series);
+                out.count[k] = uint32_t(series.size());
+                if (lists)
+                    out.moves.insert(out.moves.end(), series.begin(), series.end());
+            }
+            else if (lists)
+                quiet_moves(batch.wm[k], batch.wk[k], batch.bm[k], batch.bk[k], color, out.moves);
+        }
+    }
+
+    /**
+     * Число листьев дерева ходов глубины depth из всех позиций batch (perft): позиции каждого
+     * уровня собираются в пакеты по kChunk, на последнем уровне ходы только считаются.
+     */
+    uint64_t perft(const leaf_batch &batch, const bool color, const int depth)
+    {
+        if (depth <= 0)
+            return batch.size();
+        move_batch out;
+        generate(batch, color, out, depth > 1);
+        uint64_t total = 0;
+        if (depth == 1)
+        {
+            for (const uint32_t c : out.count)
+                total += c;
+            return total;
+        }
+        leaf_batch next;
+        for (size_t k = 0; k < batch.size(); ++k)
+        {
+            for (uint32_t m = out.first[k]; m < out.first[k] + out.count[k]; ++m)
+            {
+                uint32_t wm = batch.wm[k], wk = batch.wk[k], bm = batch.bm[k], bk = batch.bk[k];
+                play(wm, wk, bm, bk, color, out.moves[m]);
+                next.push(wm, wk, bm, bk);
+            }
+            if (next.size() >= kChunk)
+            {
+                total += perft(next, !color, depth - 1);
+                next.clear();
+            }
+        }
+        return total + perft(next, !color, depth - 1);
+    }
+
+    /**
+     * Маски позиции после хода turn стороны color (как make_turn): побитые снимаются, превращение — по turn.crown.
+     */
+    static void play(uint32_t &wm, uint32_t &wk, uint32_t &bm, uint32_t &bk, const bool color, const move_pos &turn)
+    {
+        uint32_t &men = (color ? bm : wm), &kings = (color ? bk : wk);
+        uint32_t &enemy_men = (color ? wm : bm), &enemy_kings = (color ? wk : bk);
+        const uint32_t from = uint32_t(square_bit<8>(turn.x, turn.y)), to = uint32_t(square_bit<8>(turn.x2, turn.y2));
+        const uint32_t captured = uint32_t(turn.captured);
+        const bool king = (kings & from) != 0;
+        men &= ~from;
+        kings &= ~from;
+        (king || turn.crown ? kings : men) |= to;
+        enemy_men &= ~captured;
+        enemy_kings &= ~captured;
+    }
+
+  private:
+    // позиций в пакете одного уровня perft
+    static constexpr size_t kChunk = 4096;
+
+    // тёмные клетки чётных (0, 2, 4, 6) и нечётных рядов
+    static constexpr uint32_t kEven = 0x0F0F0F0Fu, kOdd = 0xF0F0F0F0u;
+
+    // shift и kernel с векторными L встраиваются целиком (CHECKERS_INLINE, CHECKERS_FLATTEN) в kernels_avx2 /
+    // kernels_sse41, вызовов с векторами между функциями с разным target не остаётся — предупреждение GCC
+    // о смене ABI здесь ложное. Шаг сдвигает маску на месте: на функцию, возвращающую вектор, GCC предупреждает
+    // уже в конце единицы трансляции, вне действия pragma
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+    /**
+     * Шаг по диагонали для всех фигур маски сразу. Направления: 0 — (-1, -1), 1 — (-1, +1), 2 — (+1, -1), 3 — (+1, +1).
+     * В чётном ряду клетка j = 2c + 1, в нечётном j = 2c, поэтому сдвиг зависит от чётности ряда;
+     * маски отбрасывают фигуры, которым некуда шагнуть (край доски).
+     */
+    template <int dir, class L> CHECKERS_INLINE static void shift(typename L::type &m)
+    {
+        if constexpr (dir == 0)
+            m = L::bor(L::template shr<4>(L::band(m, L::set1(kEven & 0xFFFFFFF0u))),
+                       L::template shr<5>(L::band(m, L::set1(kOdd & 0xEEEEEEEEu))));
+        else if constexpr (dir == 1)
+            m = L::bor(L::template shr<3>(L::band(m, L::set1(kEven & 0x77777770u))),
+                       L::template shr<4>(L::band(m, L::set1(kOdd))));
+        else if constexpr (dir == 2)
+            m = L::bor(L::template shl<4>(L::band(m, L::set1(kEven))),
+                       L::template shl<3>(L::band(m, L::set1(kOdd & 0x0EEEEEEEu))));
+        else
+            m = L::bor(L::template shl<5>(L::band(m, L::set1(kEven & 0x77777777u))),
+                       L::template shl<4>(L::band(m, L::set1(kOdd & 0x0FFFFFFFu))));
+    }
+
+    // шаг маски одной позиции
+    template <int dir> static uint32_t step(uint32_t m)
+    {
+        shift<dir, scalar_lanes>(m);
+        return m;
+    }
+
+    /**
+     * Число тихих ходов и клетки, куда можно бить (0 — взятий нет), для позиций k .. k + L::width - 1.
+     */
+    template <class L>
+    CHECKERS_INLINE static void kernel(const leaf_batch &b, const size_t k, const bool color, uint32_t *count,
+                                       uint32_t *captures)
+    {
+        using V = typename L::type;
+        const V wm = L::load(&b.wm[k]), wk = L::load(&b.wk[k]), bm = L::load(&b.bm[k]), bk = L::load(&b.bk[k]);
+        const V men = (color ? bm : wm), kings = (color ? bk : wk);
+        const V enemy = (color ? L::bor(wm, wk) : L::bor(bm, bk));
+        const V empty = L::bxor(L::bor(L::bor(wm, wk), L::bor(bm, bk)), L::set1(0xFFFFFFFFu));
+        const bool any_kings = L::any(kings);
+        V quiet = L::set1(0), caps = L::set1(0);
+        auto direction = [&](auto dir_tag) CHECKERS_INLINE {
+            constexpr int dir = decltype(dir_tag)::value;
+            // белые идут вверх (направления 0, 1), чёрные — вниз (2, 3)
+            const bool forward = (color ? dir >= 2 : dir < 2);
+            V s = men, jump;
+            shift<dir, L>(s);
+            if (forward)
+                quiet = L::add(quiet, L::popcount(L::band(s, empty)));
+            if (forward || Rules::men_capture_backwards)
+            {
+                shift<dir, L>(jump = L::band(s, enemy));
+                caps = L::bor(caps, L::band(jump, empty));
+            }
+            if (!any_kings)
+                return;
+            V ray = kings;
+            shift<dir, L>(ray);
+            if constexpr (Rules::flying_kings)
+            {
+                // луч идёт по пустым клеткам; первая фигура соперника на нём — кандидат на взятие
+                V hits = L::set1(0);
+                for (int len = 0; len < 7; ++len)
+                {
+                    quiet = L::add(quiet, L::popcount(L::band(ray, empty)));
+                    hits = L::bor(hits, L::band(ray, enemy));
+                    shift<dir, L>(ray = L::band(ray, empty));
+                }
+                shift<dir, L>(hits);
+                caps = L::bor(caps, L::band(hits, empty));
+            }
+            else
+            {
+                quiet = L::add(quiet, L::popcount(L::band(ray, empty)));
+                shift<dir, L>(jump = L::band(ray, enemy));
+                caps = L::bor(caps, L::band(jump, empty));
+            }
+        };
+        direction(std::integral_constant<int, 0>{});
+        direction(std::integral_constant<int, 1>{});
+        direction(std::integral_constant<int, 2>{});
+        direction(std::integral_constant<int, 3>{});
+        L::store(count + k, quiet);
+        L::store(captures + k, caps);
+    }
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+    /**
+     * Тихие ходы позиции без взятий — как их записывает BasicLogic (превращение на последнем ряду).
+     */
+    static void quiet_moves(const uint32_t wm, const uint32_t wk, const uint32_t bm, const uint32_t bk,
+                            const bool color, std::vector<move_pos> &out)
+    {
+        const uint32_t men = (color ? bm : wm), kings = (color ? bk : wk);
+        const uint32_t empty = ~(wm | wk | bm | bk);
+        const uint32_t last_row = (color ? 0xF0000000u : 0x0000000Fu);
+        auto add = [&](const uint32_t from, const uint32_t to, const bool crown) {
+            const int f = lowest_bit(from), t = lowest_bit(to);
+            move_pos turn(POS_T(f / 4), POS_T(f % 4 * 2 + (f / 4 % 2 == 0)), POS_T(t / 4),
+                          POS_T(t % 4 * 2 + (t / 4 % 2 == 0)));
+            turn.crown = crown;
+            out.push_back(turn);
+        };
+        auto direction = [&](auto dir_tag) {
+            constexpr int dir = decltype(dir_tag)::value;
+            if (color ? dir >= 2 : dir < 2)
+                for (uint32_t m = men; m; m &= m - 1)
+                {
+                    const uint32_t from = m & (0u - m), to = step<dir>(from) & empty;
+                    if (to)
+                        add(from, to, (to & last_row) != 0);
+                }
+            for (uint32_t m = kings; m; m &= m - 1)
+            {
+                const uint32_t from = m & (0u - m);
+                for (uint32_t to = step<dir>(from) & empty; to; to = step<dir>(to) & empty)
+                {
+                    add(from, to, false);
+                    if (!Rules::flying_kings)
+                        break;
+                }
+            }
+        };
+        direction(std::integral_constant<int, 0>{});
+        direction(std::integral_constant<int, 1>{});
+        direction(std::integral_constant<int, 2>{});
+        direction(std::integral_constant<int, 3>{});
+    }
+
+    // клетка маски (один бит) — координаты доски
+    static POS_T row_of(const uint32_t bit)
+    {
+        return POS_T(lowest_bit(bit) / 4);
+    }
+
+    static POS_T col_of(const uint32_t bit)
+    {
+        const int sq = lowest_bit(bit);
+        return POS_T(sq % 4 * 2 + (sq / 4 % 2 == 0));
+    }
+
+    // шаг одной клетки по направлению dir, выбранному во время выполнения
+    static uint32_t step_to(const int dir, const uint32_t bit)
+    {
+        switch (dir)
+        {
+        case 0: return step<0>(bit);
+        case 1: return step<1>(bit);
+        case 2: return step<2>(bit);
+        default: return step<3>(bit);
+        }
+    }
+
+    /**
+     * Все серии взятий стороны color (позиция, где бить есть чем) — как BasicLogic::capture_series
+     * для каждой фигуры; одинаковые по результату серии одной фигуры — один ход.
+     */
+    static void capture_moves(const uint32_t wm, const uint32_t wk, const uint32_t bm, const uint32_t bk,
+                              const bool color, std::vector<move_pos> &out)
+    {
+        const uint32_t men = (color ? bm : wm), kings = (color ? bk : wk);
+        const uint32_t enemy = (color ? wm | wk : bm | bk), occupied = wm | wk | bm | bk;
+        for (uint32_t m = men | kings; m; m &= m - 1)
+        {
+            const uint32_t origin = m & (0u - m);
+            const size_t begin = out.size();
+            series_state st{origin, occupied & ~origin, enemy, color ? 0xF0000000u : 0x0000000Fu, color, begin, out};
+            extend(st, origin, (kings & origin) != 0, 0, false, -1, -1);
+        }
+    }
+
+    // неизменное в пределах серии одной фигуры: клетка начала (свободна), занятые клетки, фигуры соперника
+    struct series_state
+    {
+        uint32_t origin, occupied, enemy, last_row;
+        bool color;
+        size_t begin;
+        std::vector<move_pos> &out;
+    };
+
+    /**
+     * Шаг серии, как BasicLogic::extend_series: фигура (king — дамка) на клетке at, побиты captured
+     * (остаются на доске до конца серии), crowned — превратилась по ходу серии, (xb, yb) — первая побитая.
+     * Возвращает true, если есть хотя бы один прыжок.
+     */
+    static bool extend(series_state &st, const uint32_t at, const bool king, const uint32_t captured,
+                       const bool crowned, const POS_T xb, const POS_T yb)
+    {
+        bool found = false;
+        const auto jump = [&](const uint32_t over, const uint32_t to) {
+            found = true;
+            const uint32_t now = captured | over;
+            const POS_T first_x = (xb == -1 ? row_of(over) : xb), first_y = (xb == -1 ? col_of(over) : yb);
+            const bool last_row = (!king && (to & st.last_row));
+            bool ended = true;
+            if (last_row && Rules::crown == crowning::continue_as_king)
+                ended = !extend(st, to, true, now, true, first_x, first_y);
+            else if (!last_row || Rules::crown == crowning::at_series_end)
+                ended = !extend(st, to, king, now, crowned, first_x, first_y);
+            if (!ended)
+                return;
+            move_pos turn(row_of(st.origin), col_of(st.origin), row_of(to), col_of(to), first_x, first_y);
+            turn.captured = now;
+            turn.crown = (crowned || last_row);
+            if (find(st.out.begin() + ptrdiff_t(st.begin), st.out.end(), turn) == st.out.end())
+                st.out.push_back(turn);
+        };
+        const uint32_t prey = st.enemy & ~captured;
+        for (int dir = 0; dir < 4; ++dir)
+        {
+            if (!king && !Rules::men_capture_backwards && (st.color ? dir < 2 : dir >= 2))
+                continue;
+            if (!king || !Rules::flying_kings)
+            {
+                const uint32_t over = step_to(dir, at), to = step_to(dir, over);
+                if ((over & prey) && to && !(to & st.occupied))
+                    jump(over, to);
+                continue;
+            }
+            // дальнобойная дамка: до первой фигуры на луче, её бьём, если можно, и встаём за ней
+            uint32_t over = step_to(dir, at);
+            while (over && !(over & st.occupied))
+                over = step_to(dir, over);
+            if (!(over & prey))
+                continue;
+            for (uint32_t to = step_to(dir, over); to && !(to & st.occupied); to = step_to(dir, to))
+                jump(over, to);
+        }
+        return found;
+    }
+
+    // операции над «дорожками»: по одной позиции, 4 (SSE4.1) или 8 (AVX2) за инструкцию
+    struct scalar_lanes
+    {
+        using type = uint32_t;
+        static constexpr int width = 1;
+        static type load(const uint32_t *p) { return *p; }
+        static void store(uint32_t *p, const type v) { *p = v; }
+        static type set1(const uint32_t v) { return v; }
+        static type band(const type a, const type b) { return a & b; }
+        static type bor(const type a, const type b) { return a | b; }
+        static type bxor(const type a, const type b) { return a ^ b; }
+        static type add(const type a, const type b) { return a + b; }
+        template <int n> static type shl(const type a) { return a << n; }
+        template <int n> static type shr(const type a) { return a >> n; }
+        static type popcount(const type a) { return type(bit_count(a)); }
+        static bool any(const type a) { return a != 0; }
+    };
+
+#if defined(CHECKERS_SIMD_AVX2)
+    // ядро по 8 позиций для всего пакета; возвращает, сколько позиций посчитано (остаток — скалярно)
+    CHECKERS_TARGET_AVX2 CHECKERS_FLATTEN static size_t kernels_avx2(const leaf_batch &b, const bool color,
+                                                                     uint32_t *count, uint32_t *captures)
+    {
+        size_t k = 0;
+        for (; k + 8 <= b.size(); k += 8)
+            kernel<avx2_lanes>(b, k, color, count, captures);
+        return k;
+    }
+
+    struct avx2_lanes
+    {
+        using type = __m256i;
+        static constexpr int width = 8;
+        CHECKERS_TARGET_AVX2 static type load(const uint32_t *p)
+        {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        }
+        CHECKERS_TARGET_AVX2 static void store(uint32_t *p, const type v)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+        }
+        CHECKERS_TARGET_AVX2 static type set1(const uint32_t v) { return _mm256_set1_epi32(int(v)); }
+        CHECKERS_TARGET_AVX2 static type band(const type a, const type b) { return _mm256_and_si256(a, b); }
+        CHECKERS_TARGET_AVX2 static type bor(const type a, const type b) { return _mm256_or_si256(a, b); }
+        CHECKERS_TARGET_AVX2 static type bxor(const type a, const type b) { return _mm256_xor_si256(a, b); }
+        CHECKERS_TARGET_AVX2 static type add(const type a, const type b) { return _mm256_add_epi32(a, b); }
+        template <int n> CHECKERS_TARGET_AVX2 static type shl(const type a) { return _mm256_slli_epi32(a, n); }
+        template <int n> CHECKERS_TARGET_AVX2 static type shr(const type a) { return _mm256_srli_epi32(a, n); }
+        // popcount 32-битных слов: полубайты по таблице (pshufb), затем сумма байтов умножением на 0x01010101
+        CHECKERS_TARGET_AVX2 static type popcount(const type a)
+        {
+            const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3,
+                                                 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m256i low = _mm256_set1_epi8(15);
+            const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(a, low)),
+                                                  _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi32(a, 4), low)));
+            return _mm256_srli_epi32(_mm256_mullo_epi32(bytes, _mm256_set1_epi32(0x01010101)), 24);
+        }
+        CHECKERS_TARGET_AVX2 static bool any(const type a) { return !_mm256_testz_si256(a, a); }
+    };
+#endif
+#if defined(CHECKERS_SIMD_SSE41)
+    CHECKERS_TARGET_SSE41 CHECKERS_FLATTEN static size_t kernels_sse41(const leaf_batch &b, const bool color,
+                                                                       uint32_t *count, uint32_t *captures)
+    {
+        size_t k = 0;
+        for (; k + 4 <= b.size(); k += 4)
+            kernel<sse_lanes>(b, k, color, count, captures);
+        return k;
+    }
+
+    struct sse_lanes
+    {
+        using type = __m128i;
+        static constexpr int width = 4;
+        CHECKERS_TARGET_SSE41 static type load(const uint32_t *p)
+        {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        }
+        CHECKERS_TARGET_SSE41 static void store(uint32_t *p, const type v)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+        }
+        CHECKERS_TARGET_SSE41 static type set1(const uint32_t v) { return _mm_set1_epi32(int(v)); }
+        CHECKERS_TARGET_SSE41 static type band(const type a, const type b) { return _mm_and_si128(a, b); }
+        CHECKERS_TARGET_SSE41 static type bor(const type a, const type b) { return _mm_or_si128(a, b); }
+        CHECKERS_TARGET_SSE41 static type bxor(const type a, const type b) { return _mm_xor_si128(a, b); }
+        CHECKERS_TARGET_SSE41 static type add(const type a, const type b) { return _mm_add_epi32(a, b); }
+        template <int n> CHECKERS_TARGET_SSE41 static type shl(const type a) { return _mm_slli_epi32(a, n); }
+        template <int n> CHECKERS_TARGET_SSE41 static type shr(const type a) { return _mm_srli_epi32(a, n); }
+        CHECKERS_TARGET_SSE41 static type popcount(const type a)
+        {
+            const __m128i lut = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m128i low = _mm_set1_epi8(15);
+            const __m128i bytes = _mm_add_epi8(_mm_shuffle_epi8(lut, _mm_and_si128(a, low)),
+                                               _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi32(a, 4), low)));
+            return _mm_srli_epi32(_mm_mullo_epi32(bytes, _mm_set1_epi32(0x01010101)), 24);
+        }
+        CHECKERS_TARGET_SSE41 static bool any(const type a) { return !_mm_testz_si128(a, a); }
+    };
+#endif
+
+    // клетки, куда можно бить, по позициям пакета
+    std::vector<uint32_t> captures;
+    // серии взятий одной позиции
+    std::vector<move_pos> series;
+};
+
+// пакетный генератор ходов русских шашек
+using BatchMoveGen = BasicBatchMoveGen<russian_rules>;
@@ -1,10 +1,14 @@
 #pragma once
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <vector>
 
 #include "../Models/Move.h"
+#include "../Models/Notation.h"
 #include "../Models/Project_path.h"
+#include "../Models/Trace.h"
 
 #ifdef __APPLE__
     #include <SDL2/SDL.h>
@@ -14,20 +18,29 @@
     #include <SDL_image.h>
 #endif
 
+// Текстуры, встроенные при сборке (checkers_embed_textures, опция CHECKERS_EMBED_TEXTURES)
+#ifdef CHECKERS_EMBEDDED_TEXTURES
+    #include "Embedded_textures.h"
+#endif
+
 using namespace std;
 
 /**
  * Класс Board инкапсулирует:
  *  - состояние доски (матрица фигур, выделения, активная клетка, история),
- *  - ресурсы SDL (окно, рендерер, текстуры),
- *  - полный цикл перерисовки (rerender) при любом изменении состояния,
+ *  - ресурсы SDL (окно, рендерер, текстуры и их копии под текущий размер окна),
+ *  - отрисовку кадра (update): перерисовываются только клетки, изменившиеся с прошлого кадра,
+ *    и не чаще частоты обновления дисплея,
  *  - утилиты: подсветка клеток, перемещение фигур, откат хода, показ результата.
+ *
+ * Изменение состояния (move_piece, highlight_cells, ...) ничего не рисует и не ждёт дисплей;
+ * кадр рисует update(), его вызывают циклы ожидания ввода (Hand).
  */
 class Board
 {
 public:
     Board() = default;
-    Board(const unsigned int W, const unsigned int H) : W(W), H(H) {}
+    Board(const unsigned int W, const unsigned int H, const int N = 8) : W(W), H(H), N(N) {}
 
     /**
      * Стартовая инициализация окна/рендерера/текстур и отрисовка начальной позиции.
@@ -35,6 +48,7 @@ public:
      */
     int start_draw()
     {
+        TRACE_SCOPE("Board::start_draw");
         if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
         {
             print_exception("SDL_Init can't init SDL2 lib");
@@ -62,41 +76,49 @@ public:
             print_exception("SDL_CreateWindow can't create window");
             return 1;
         }
-        ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        // без VSYNC: Present не блокирует, частоту кадров ограничивает update()
+        ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+        if (ren == nullptr)
+            ren = SDL_CreateRenderer(win, -1, 0);
         if (ren == nullptr)
         {
             print_exception("SDL_CreateRenderer can't create renderer");
             return 1;
         }
 
-        // Загрузка текстур (доска, шашки, дамки, кнопки «назад» и «повтор»)
-        board  = IMG_LoadTexture(ren, board_path.c_str());
-        w_piece= IMG_LoadTexture(ren, piece_white_path.c_str());
-        b_piece= IMG_LoadTexture(ren, piece_black_path.c_str());
-        w_queen= IMG_LoadTexture(ren, queen_white_path.c_str());
-        b_queen= IMG_LoadTexture(ren, queen_black_path.c_str());
-        back   = IMG_LoadTexture(ren, back_path.c_str());
-        replay = IMG_LoadTexture(ren, replay_path.c_str());
-        if (!board || !w_piece || !b_piece || !w_queen || !b_queen || !back || !replay)
+        // Загрузка текстур (доска, шашки, дамки, кнопки, картинки результата) — один раз за запуск
+        for (int k = 0; k < TEXTURES; ++k)
         {
-            print_exception("IMG_LoadTexture can't load main textures from " + textures_path);
-            return 1;
+            textures[k] = load_texture(k);
+            if (!textures[k])
+            {
+                print_exception("IMG_LoadTexture can't load texture " + textures_path + texture_files[k]);
+                return 1;
+            }
         }
 
+        // Частота обновления дисплея окна (60 Гц, если драйвер её не сообщает)
+        SDL_DisplayMode mode;
+        const int refresh_rate = (SDL_GetWindowDisplayMode(win, &mode) == 0 && mode.refresh_rate > 0)
+                                     ? mode.refresh_rate
+                                     : 60;
+        frame_interval = chrono::microseconds(1000000 / refresh_rate);
+
         // Синхронизируем W/H с реальным размером рендерера
         SDL_GetRendererOutputSize(ren, &W, &H);
 
-        // Сформировать стартовую матрицу фигур и перерисовать
+        // Сформировать стартовую матрицу фигур и нарисовать первый кадр
         make_start_mtx();
-        rerender();
+        update();
         return 0;
     }
 
     /**
-     * Полный сброс состояния партии к началу и перерисовка.
+     * Полный сброс состояния партии к началу.
      */
     void redraw()
     {
+        TRACE_SCOPE("Board::redraw");
         game_results = -1;
         history_mtx.clear();
         history_beat_series.clear();
@@ -108,23 +130,25 @@ public:
     /**
      * Перемещение с учётом возможного снятия побитой фигуры (если xb/yb != -1).
      * beat_series — длина текущей серии взятий (для истории).
+     * crown = false — не превращать в дамку на последней линии (правило варианта, см. move_pos::crown).
      */
-    void move_piece(move_pos turn, const int beat_series = 0)
+    void move_piece(move_pos turn, const int beat_series = 0, const bool crown = true)
     {
         if (turn.xb != -1)
         {
             mtx[turn.xb][turn.yb] = 0; // убрать побитую фигуру
         }
-        move_piece(turn.x, turn.y, turn.x2, turn.y2, beat_series);
+        move_piece(turn.x, turn.y, turn.x2, turn.y2, beat_series, crown);
     }
 
     /**
      * Базовый перенос фигуры из (i,j) в (i2,j2).
      * Бросает исключение, если клетка «куда» занята или «откуда» пуста.
-     * Автоматически превращает в дамку при достижении последней линии.
+     * Автоматически превращает в дамку при достижении последней линии (если crown).
      * Добавляет снимок в историю.
      */
-    void move_piece(const POS_T i, const POS_T j, const POS_T i2, const POS_T j2, const int beat_series = 0)
+    void move_piece(const POS_T i, const POS_T j, const POS_T i2, const POS_T j2, const int beat_series = 0,
+                    const bool crown = true)
     {
         if (mtx[i2][j2])
         {
@@ -136,22 +160,21 @@ public:
         }
 
         // Автоповышение в дамки (1→3, 2→4)
-        if ((mtx[i][j] == 1 && i2 == 0) || (mtx[i][j] == 2 && i2 == 7))
+        if (crown && ((mtx[i][j] == 1 && i2 == 0) || (mtx[i][j] == 2 && i2 == N - 1)))
             mtx[i][j] += 2;
 
         // Перенос фигуры
         mtx[i2][j2] = mtx[i][j];
-        drop_piece(i, j);    // обнуляем исходную клетку и перерисовываем
+        drop_piece(i, j);    // обнуляем исходную клетку
         add_history(beat_series);
     }
 
     /**
-     * Удаляет фигуру с клетки (i,j) и перерисовывает доску.
+     * Удаляет фигуру с клетки (i,j).
      */
     void drop_piece(const POS_T i, const POS_T j)
     {
         mtx[i][j] = 0;
-        rerender();
     }
 
     /**
@@ -164,7 +187,6 @@ public:
             throw runtime_error("can't turn into queen in this position");
         }
         mtx[i][j] += 2;
-        rerender();
     }
 
     /**
@@ -177,7 +199,7 @@ public:
     }
 
     /**
-     * Подсветить набор клеток (x,y) и перерисовать.
+     * Подсветить набор клеток (x,y).
      */
     void highlight_cells(vector<pair<POS_T, POS_T>> cells)
     {
@@ -186,39 +208,35 @@ public:
             POS_T x = pos.first, y = pos.second;
             is_highlighted_[x][y] = 1;
         }
-        rerender();
     }
 
     /**
-     * Очистить всю подсветку и перерисовать.
+     * Очистить всю подсветку.
      */
     void clear_highlight()
     {
-        for (POS_T i = 0; i < 8; ++i)
+        for (POS_T i = 0; i < N; ++i)
         {
-            is_highlighted_[i].assign(8, 0);
+            is_highlighted_[i].assign(N, 0);
         }
-        rerender();
     }
 
     /**
-     * Сделать клетку активной (красная рамка) и перерисовать.
+     * Сделать клетку активной (красная рамка).
      */
     void set_active(const POS_T x, const POS_T y)
     {
         active_x = x;
         active_y = y;
-        rerender();
     }
 
     /**
-     * Снять активную клетку и перерисовать.
+     * Снять активную клетку.
      */
     void clear_active()
     {
         active_x = -1;
         active_y = -1;
-        rerender();
     }
 
     /**
@@ -253,16 +271,61 @@ public:
     void show_final(const int res)
     {
         game_results = res;
-        rerender();
     }
 
     /**
-     * Если окно ресайзят — синхронизировать размеры и перерисовать.
+     * Если окно ресайзят — синхронизировать размеры; текстуры под новый размер
+     * пересоздаются при следующем кадре.
      */
     void reset_window_size()
     {
         SDL_GetRendererOutputSize(ren, &W, &H);
-        rerender();
+        cache_valid = false;
+    }
+
+    /**
+     * Меняет размер окна на w x h (бенчмарк отрисовки; в игре размер меняет пользователь).
+     */
+    void resize_window(const int w, const int h)
+    {
+        SDL_SetWindowSize(win, w, h);
+        SDL_PumpEvents();
+        reset_window_size();
+    }
+
+    /**
+     * Наименьший промежуток между кадрами update(): после start_draw — период обновления дисплея,
+     * 0 — без ограничения (бенчмарк отрисовки).
+     */
+    void set_frame_interval(const chrono::steady_clock::duration interval)
+    {
+        frame_interval = interval;
+    }
+
+    /**
+     * Рисует кадр, если картинка на экране отстала от состояния доски.
+     * Перерисовываются только изменившиеся клетки (фигура, подсветка, активная клетка) —
+     * в постоянную текстуру кадра, которая затем выводится целиком.
+     * Кадры выводятся не чаще частоты обновления дисплея: если с прошлого кадра прошло меньше,
+     * ничего не рисует и возвращает, через сколько миллисекунд можно вызвать снова.
+     * 0 — на экране актуальная картинка.
+     */
+    int update()
+    {
+        if (!ren)
+            return 0;
+        bool changed = !cache_valid || full_redraw || shown_results != game_results;
+        for (POS_T i = 0; i < N && !changed; ++i)
+            for (POS_T j = 0; j < N && !changed; ++j)
+                changed = cell_changed(i, j);
+        if (!changed)
+            return 0;
+        const auto now = chrono::steady_clock::now();
+        if (now < last_frame + frame_interval)
+            return max(1, int(chrono::duration_cast<chrono::milliseconds>(last_frame + frame_interval - now).count()));
+        draw_frame();
+        last_frame = now;
+        return 0;
     }
 
     /**
@@ -270,13 +333,13 @@ public:
      */
     void quit()
     {
-        SDL_DestroyTexture(board);
-        SDL_DestroyTexture(w_piece);
-        SDL_DestroyTexture(b_piece);
-        SDL_DestroyTexture(w_queen);
-        SDL_DestroyTexture(b_queen);
-        SDL_DestroyTexture(back);
-        SDL_DestroyTexture(replay);
+        drop_cache();
+        for (auto &t : textures)
+        {
+            if (t)
+                SDL_DestroyTexture(t);
+            t = nullptr;
+        }
         SDL_DestroyRenderer(ren);
         SDL_DestroyWindow(win);
         SDL_Quit();
@@ -299,129 +362,242 @@ private:
     }
 
     /**
-     * Заполнить стартовую расстановку шашек (классическая 8x8).
+     * Заполнить стартовую расстановку шашек (см. start_position: 8x8 — по 3 ряда, 10x10 — по 4).
      * Белые (1) снизу, чёрные (2) сверху, только на тёмных клетках.
      */
     void make_start_mtx()
     {
-        for (POS_T i = 0; i < 8; ++i)
+        mtx = start_position(N);
+        add_history();
+    }
+
+    /**
+     * Прямоугольник клетки (i,j) в пикселях: доска — сетка (N+2)x(N+2), клетки 1..N (рамка по краям).
+     */
+    SDL_Rect cell_rect(const int i, const int j) const
+    {
+        const int grid = N + 2;
+        const int x = W * (j + 1) / grid, y = H * (i + 1) / grid;
+        return SDL_Rect{x, y, W * (j + 2) / grid - x, H * (i + 2) / grid - y};
+    }
+
+    /**
+     * Отличается ли клетка (i,j) от нарисованной в прошлом кадре.
+     */
+    bool cell_changed(const POS_T i, const POS_T j) const
+    {
+        const bool active = (active_x == i && active_y == j), was_active = (shown_active_x == i && shown_active_y == j);
+        return mtx[i][j] != shown_mtx[i][j] || is_highlighted_[i][j] != shown_highlighted[i][j] || active != was_active;
+    }
+
+    /**
+     * Текстура номер id: из встроенных в программу пикселей, если они есть, иначе из PNG в Textures/.
+     * Встроенные пиксели уже в формате ARGB8888 — их остаётся только развернуть из серий и загрузить.
+     */
+    SDL_Texture *load_texture(const int id)
+    {
+        TRACE_SCOPE("Board::load_texture");
+#ifdef CHECKERS_EMBEDDED_TEXTURES
+        for (const auto &embedded : embedded_textures)
         {
-            for (POS_T j = 0; j < 8; ++j)
-            {
-                mtx[i][j] = 0;
-                if (i < 3 && (i + j) % 2 == 1)
-                    mtx[i][j] = 2; // чёрные вверху
-                if (i > 4 && (i + j) % 2 == 1)
-                    mtx[i][j] = 1; // белые внизу
-            }
+            if (string(embedded.name) != texture_files[id])
+                continue;
+            vector<uint32_t> pixels(size_t(embedded.w) * embedded.h);
+            auto out = pixels.begin();
+            for (size_t k = 0; k + 1 < embedded.runs_size; k += 2)
+                out = fill_n(out, embedded.runs[k], embedded.runs[k + 1]);
+            SDL_Texture *res =
+                SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, embedded.w, embedded.h);
+            if (!res)
+                return nullptr;
+            SDL_UpdateTexture(res, NULL, pixels.data(), embedded.w * int(sizeof(uint32_t)));
+            SDL_SetTextureBlendMode(res, SDL_BLENDMODE_BLEND);
+            return res;
         }
-        add_history();
+#endif
+        return IMG_LoadTexture(ren, (textures_path + texture_files[id]).c_str());
     }
 
     /**
-     * Полная перерисовка кадра:
-     *  - фон-доска
-     *  - фигуры (с масштабированием под текущие W/H)
-     *  - подсветка возможных ходов (зелёные рамки)
-     *  - активная клетка (красная рамка)
-     *  - кнопки «назад» и «повтор»
-     *  - окончательный результат (если задан)
-     *
-     * В конце — Present, небольшой delay (особенно для macOS) и очистка очереди событий.
+     * Копия текстуры src размером w x h (масштабирование один раз, а не в каждом кадре).
+     * Если рендерер не умеет рисовать в текстуру — nullptr (тогда масштабируется src при выводе).
      */
-    void rerender()
+    SDL_Texture *make_scaled(SDL_Texture *src, const int w, const int h)
     {
-        // фон: доска
+        if (!SDL_RenderTargetSupported(ren) || w <= 0 || h <= 0)
+            return nullptr;
+        SDL_Texture *res = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+        if (!res)
+            return nullptr;
+        SDL_SetTextureBlendMode(res, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderTarget(ren, res);
+        SDL_SetRenderDrawColor(ren, 0, 0, 0, 0);
         SDL_RenderClear(ren);
-        SDL_RenderCopy(ren, board, NULL, NULL);
+        // копируем пиксели вместе с прозрачностью как есть, без смешивания с пустым фоном
+        SDL_BlendMode mode;
+        SDL_GetTextureBlendMode(src, &mode);
+        SDL_SetTextureBlendMode(src, SDL_BLENDMODE_NONE);
+        SDL_RenderCopy(ren, src, NULL, NULL);
+        SDL_SetTextureBlendMode(src, mode);
+        SDL_SetRenderTarget(ren, nullptr);
+        return res;
+    }
 
-        // фигуры
-        for (POS_T i = 0; i < 8; ++i)
+    /**
+     * Пересоздаёт текстуры под текущий размер окна: кадр и масштабированные копии.
+     */
+    void build_cache()
+    {
+        TRACE_SCOPE("Board::build_cache");
+        drop_cache();
+        const int pw = piece_size(W), ph = piece_size(H);
+        const int sizes[TEXTURES][2] = {
+            {W, H},                                                 // доска
+            {pw, ph}, {pw, ph}, {pw, ph}, {pw, ph},                 // фигуры
+            {button_size(W), button_size(H)}, {button_size(W), button_size(H)}, // кнопки
+            {W * 3 / 5, H * 2 / 5}, {W * 3 / 5, H * 2 / 5}, {W * 3 / 5, H * 2 / 5}, // результат
+        };
+        for (int k = 0; k < TEXTURES; ++k)
+            scaled[k] = make_scaled(textures[k], sizes[k][0], sizes[k][1]);
+        if (SDL_RenderTargetSupported(ren))
+            frame = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, W, H);
+        cache_valid = true;
+        full_redraw = true;
+    }
+
+    void drop_cache()
+    {
+        for (auto &t : scaled)
         {
-            for (POS_T j = 0; j < 8; ++j)
-            {
-                if (!mtx[i][j]) { continue; }
+            if (t)
+                SDL_DestroyTexture(t);
+            t = nullptr;
+        }
+        if (frame)
+            SDL_DestroyTexture(frame);
+        frame = nullptr;
+    }
 
-                // позиция и размер спрайта по сетке 10x10 (рамки/отступы учитываются)
-                int wpos = W * (j + 1) / 10 + W / 120;
-                int hpos = H * (i + 1) / 10 + H / 120;
-                SDL_Rect rect{ wpos, hpos, W / 12, H / 12 };
+    // размер спрайта фигуры и кнопки по стороне окна side (для 8x8 — side / 12 и side / 15)
+    int piece_size(const int side) const
+    {
+        return side * 10 / (12 * (N + 2));
+    }
 
-                // выбор текстуры по типу фигуры
-                SDL_Texture* piece_texture;
-                if (mtx[i][j] == 1) { piece_texture = w_piece; }
-                else if (mtx[i][j] == 2) { piece_texture = b_piece; }
-                else if (mtx[i][j] == 3) { piece_texture = w_queen; }
-                else { piece_texture = b_queen; }
+    int button_size(const int side) const
+    {
+        return side * 2 / (3 * (N + 2));
+    }
 
-                SDL_RenderCopy(ren, piece_texture, NULL, &rect);
-            }
-        }
+    // текстура для вывода: масштабированная копия или (если её нет) исходная
+    SDL_Texture *texture(const int id) const
+    {
+        return scaled[id] ? scaled[id] : textures[id];
+    }
 
-        // подсветка (зелёные рамки) — рисуем в увеличенном масштабе для толщины линий
-        SDL_SetRenderDrawColor(ren, 0, 255, 0, 0);
-        const double scale = 2.5;
-        SDL_RenderSetScale(ren, scale, scale);
-        for (POS_T i = 0; i < 8; ++i)
+    /**
+     * Клетка (i,j) целиком: фон доски под ней, фигура, подсветка (зелёная рамка),
+     * активная клетка (красная рамка). Рисование ограничено клеткой.
+     */
+    void draw_cell(const POS_T i, const POS_T j)
+    {
+        const SDL_Rect cell = cell_rect(i, j);
+        SDL_RenderSetClipRect(ren, &cell);
+        if (N != 8)
+        {
+            // рисунок доски — 8x8; другие доски рисуются заливкой клеток
+            if ((i + j) % 2)
+                SDL_SetRenderDrawColor(ren, 118, 78, 46, 255);
+            else
+                SDL_SetRenderDrawColor(ren, 238, 214, 176, 255);
+            SDL_RenderFillRect(ren, &cell);
+        }
+        else if (scaled[BOARD])
+            SDL_RenderCopy(ren, scaled[BOARD], &cell, &cell);
+        else
         {
-            for (POS_T j = 0; j < 8; ++j)
+            // исходная доска другого размера: берём соответствующую часть
+            int tw, th;
+            SDL_QueryTexture(textures[BOARD], NULL, NULL, &tw, &th);
+            const SDL_Rect src{cell.x * tw / W, cell.y * th / H, cell.w * tw / W, cell.h * th / H};
+            SDL_RenderCopy(ren, textures[BOARD], &src, &cell);
+        }
+        if (mtx[i][j])
+        {
+            // позиция и размер спрайта по сетке (N+2)x(N+2) (рамки/отступы учитываются)
+            SDL_Rect rect{cell.x + W / (12 * (N + 2)), cell.y + H / (12 * (N + 2)), piece_size(W), piece_size(H)};
+            SDL_RenderCopy(ren, texture(W_PIECE + mtx[i][j] - 1), NULL, &rect);
+        }
+        // рамки толщиной в 3 пикселя по краю клетки
+        auto draw_frame_rect = [&](const Uint8 r, const Uint8 g) {
+            SDL_SetRenderDrawColor(ren, r, g, 0, 255);
+            for (int k = 0; k < 3; ++k)
             {
-                if (!is_highlighted_[i][j]) { continue; }
-                SDL_Rect cell{
-                    int(W * (j + 1) / 10 / scale),
-                    int(H * (i + 1) / 10 / scale),
-                    int(W / 10 / scale),
-                    int(H / 10 / scale)
-                };
-                SDL_RenderDrawRect(ren, &cell);
+                const SDL_Rect border{cell.x + k, cell.y + k, cell.w - 2 * k, cell.h - 2 * k};
+                SDL_RenderDrawRect(ren, &border);
             }
-        }
+        };
+        if (is_highlighted_[i][j])
+            draw_frame_rect(0, 255);
+        if (active_x == i && active_y == j)
+            draw_frame_rect(255, 0);
+        SDL_RenderSetClipRect(ren, nullptr);
+    }
 
-        // активная клетка (красная рамка)
-        if (active_x != -1)
+    /**
+     * Кадр: в текстуру кадра перерисовываются изменившиеся клетки (после изменения размера окна —
+     * всё: доска, клетки, кнопки «назад» и «повтор»), затем кадр выводится на экран и поверх —
+     * картинка результата партии (если задан). Без текстуры кадра каждый кадр рисуется целиком.
+     */
+    void draw_frame()
+    {
+        TRACE_SCOPE("Board::draw_frame");
+        if (!cache_valid)
+            build_cache();
+        const bool full = full_redraw || !frame;
+        SDL_SetRenderTarget(ren, frame);
+        if (full)
         {
-            SDL_SetRenderDrawColor(ren, 255, 0, 0, 0);
-            SDL_Rect active_cell{
-                int(W * (active_y + 1) / 10 / scale),
-                int(H * (active_x + 1) / 10 / scale),
-                int(W / 10 / scale),
-                int(H / 10 / scale)
-            };
-            SDL_RenderDrawRect(ren, &active_cell);
+            if (N == 8)
+                SDL_RenderCopy(ren, texture(BOARD), NULL, NULL);
+            else
+            {
+                SDL_SetRenderDrawColor(ren, 74, 44, 22, 255);
+                SDL_RenderClear(ren);
+            }
+            // кнопки — в угловых клетках рамки: (-1, -1) и (-1, N)
+            const int grid = N + 2;
+            SDL_Rect rect_left{W / (4 * grid), H / (4 * grid), button_size(W), button_size(H)};
+            SDL_RenderCopy(ren, texture(BACK), NULL, &rect_left);
+            SDL_Rect replay_rect{W * (12 * (N + 1) + 1) / (12 * grid), H / (4 * grid), button_size(W), button_size(H)};
+            SDL_RenderCopy(ren, texture(REPLAY), NULL, &replay_rect);
         }
-        SDL_RenderSetScale(ren, 1, 1); // вернуть масштаб по умолчанию
-
-        // кнопки управления
-        SDL_Rect rect_left{ W / 40, H / 40, W / 15, H / 15 };
-        SDL_RenderCopy(ren, back, NULL, &rect_left);
-        SDL_Rect replay_rect{ W * 109 / 120, H / 40, W / 15, H / 15 };
-        SDL_RenderCopy(ren, replay, NULL, &replay_rect);
+        for (POS_T i = 0; i < N; ++i)
+            for (POS_T j = 0; j < N; ++j)
+                if (full || cell_changed(i, j))
+                    draw_cell(i, j);
+        SDL_SetRenderTarget(ren, nullptr);
+        if (frame)
+            SDL_RenderCopy(ren, frame, NULL, NULL);
 
         // картинка результата партии (при наличии)
         if (game_results != -1)
         {
-            string result_path = draw_path;
-            if (game_results == 1) { result_path = white_path; }
-            else if (game_results == 2) { result_path = black_path; }
-
-            SDL_Texture* result_texture = IMG_LoadTexture(ren, result_path.c_str());
-            if (result_texture == nullptr)
-            {
-                print_exception("IMG_LoadTexture can't load game result picture from " + result_path);
-                return;
-            }
-            SDL_Rect res_rect{ W / 5, H * 3 / 10, W * 3 / 5, H * 2 / 5 };
-            SDL_RenderCopy(ren, result_texture, NULL, &res_rect);
-            SDL_DestroyTexture(result_texture);
+            const int id = (game_results == 1 ? WHITE_WINS : game_results == 2 ? BLACK_WINS : DRAW_RESULT);
+            SDL_Rect res_rect{W / 5, H * 3 / 10, W * 3 / 5, H * 2 / 5};
+            SDL_RenderCopy(ren, texture(id), NULL, &res_rect);
+        }
+        {
+            TRACE_SCOPE("Board::present");
+            SDL_RenderPresent(ren);
         }
 
-        // показать кадр
-        SDL_RenderPresent(ren);
-
-        // небольшой «дыхательный» зазор и обработка «хвоста» событий (особенно для macOS)
-        SDL_Delay(10);
-        SDL_Event windowEvent;
-        SDL_PollEvent(&windowEvent);
+        shown_mtx = mtx;
+        shown_highlighted = is_highlighted_;
+        shown_active_x = active_x;
+        shown_active_y = active_y;
+        shown_results = game_results;
+        full_redraw = false;
     }
 
     /**
@@ -438,6 +614,9 @@ private:
     int W = 0;
     int H = 0;
 
+    // Клеток в ряду доски (8 или 10 — по варианту правил)
+    int N = 8;
+
     // История состояний доски по ходам (снимки mtx)
     vector<vector<vector<POS_T>>> history_mtx;
 
@@ -446,27 +625,45 @@ private:
     SDL_Window *win = nullptr;
     SDL_Renderer *ren = nullptr;
 
-    // Текстуры доски/фигур/кнопок
-    SDL_Texture *board = nullptr;
-    SDL_Texture *w_piece = nullptr;
-    SDL_Texture *b_piece = nullptr;
-    SDL_Texture *w_queen = nullptr;
-    SDL_Texture *b_queen = nullptr;
-    SDL_Texture *back = nullptr;
-    SDL_Texture *replay = nullptr;
+    // Текстуры доски/фигур/кнопок/результата (фигуры — в порядке значений mtx 1..4)
+    enum
+    {
+        BOARD,
+        W_PIECE,
+        B_PIECE,
+        W_QUEEN,
+        B_QUEEN,
+        BACK,
+        REPLAY,
+        WHITE_WINS,
+        BLACK_WINS,
+        DRAW_RESULT,
+        TEXTURES
+    };
+    SDL_Texture *textures[TEXTURES] = {};
+
+    // Копии текстур под текущий размер окна и постоянная текстура кадра (см. update)
+    SDL_Texture *scaled[TEXTURES] = {};
+    SDL_Texture *frame = nullptr;
+    bool cache_valid = false;
 
     // Пути к текстурам
-    const string textures_path     = project_path + "Textures/";
-    const string board_path        = textures_path + "board.png";
-    const string piece_white_path  = textures_path + "piece_white.png";
-    const string piece_black_path  = textures_path + "piece_black.png";
-    const string queen_white_path  = textures_path + "queen_white.png";
-    const string queen_black_path  = textures_path + "queen_black.png";
-    const string white_path        = textures_path + "white_wins.png";
-    const string black_path        = textures_path + "black_wins.png";
-    const string draw_path         = textures_path + "draw.png";
-    const string back_path         = textures_path + "back.png";
-    const string replay_path       = textures_path + "replay.png";
+    const string textures_path = project_path + "Textures/";
+    const char *const texture_files[TEXTURES] = {"board.png",      "piece_white.png", "piece_black.png",
+                                                 "queen_white.png", "queen_black.png", "back.png",
+                                                 "replay.png",     "white_wins.png",  "black_wins.png",
+                                                 "draw.png"};
+
+    // Что нарисовано в последнем кадре (для перерисовки только изменившихся клеток)
+    vector<vector<POS_T>> shown_mtx = vector<vector<POS_T>>(N, vector<POS_T>(N, 0));
+    vector<vector<bool>> shown_highlighted = vector<vector<bool>>(N, vector<bool>(N, 0));
+    int shown_active_x = -1, shown_active_y = -1;
+    int shown_results = -1;
+    bool full_redraw = true;
+
+    // Ограничение частоты кадров частотой обновления дисплея
+    chrono::steady_clock::duration frame_interval = chrono::milliseconds(16);
+    chrono::steady_clock::time_point last_frame;
 
     // Активная (выделенная красным) клетка
     int active_x = -1, active_y = -1;
@@ -475,10 +672,10 @@ private:
     int game_results = -1;
 
     // Матрица подсветки возможных ходов
-    vector<vector<bool>> is_highlighted_ = vector<vector<bool>>(8, vector<bool>(8, 0));
+    vector<vector<bool>> is_highlighted_ = vector<vector<bool>>(N, vector<bool>(N, 0));
 
     // Матрица фигур: 0 — пусто; 1 — white; 2 — black; 3 — white queen; 4 — black queen
-    vector<vector<POS_T>> mtx = vector<vector<POS_T>>(8, vector<POS_T>(8, 0));
+    vector<vector<POS_T>> mtx = vector<vector<POS_T>>(N, vector<POS_T>(N, 0));
 
     // История длин серий взятий (для корректного отката)
     vector<int> history_beat_series;
@@ -0,0 +1,125 @@
+#pragma once
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../Models/Notation.h"
+#include "Logic.h"
+#include "Zobrist.h"
+
+/**
+ * Дебютная книга: для позиции (хеш Зобриста с учётом стороны хода) — список ходов с весами.
+ *
+ * Файл книги — текст, по варианту в строке: ходы от начальной позиции в нотации
+ * Models/Notation.h ("c3-d4 f6-g5 g3-f4 ..."), строки с '#' — комментарии.
+ * Вес хода — сколько вариантов проходит через него в этой позиции.
+ * После загрузки книга только читается и может использоваться из нескольких потоков.
+ */
+class Book
+{
+  public:
+    struct book_move
+    {
+        std::vector<move_pos> series;
+        int weight = 0;
+    };
+
+    /**
+     * Загружает книгу; logic нужен для проверки ходов по правилам.
+     * Вариант с неверным ходом обрезается на нём. Возвращает false, если файла нет.
+     */
+    bool load(const std::string &path, Logic &logic)
+    {
+        std::ifstream fin(path);
+        if (!fin)
+            return false;
+        std::string line;
+        while (getline(fin, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream in(line);
+            auto mtx = start_position();
+            bool color = false;
+            std::string token;
+            while (in >> token)
+            {
+                const auto series = logic.resolve_series(color, mtx, parse_series(token));
+                if (series.empty())
+                    break;
+                add(Zobrist::get().hash(mtx, color), series);
+                for (const auto &turn : series)
+                    mtx = logic.make_turn(mtx, turn);
+                color = !color;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Ходы книги в позиции mtx (ходит color); пустой список — позиции в книге нет.
+     */
+    const std::vector<book_move> &probe(const std::vector<std::vector<POS_T>> &mtx, const bool color) const
+    {
+        static const std::vector<book_move> none;
+        const auto it = moves.find(Zobrist::get().hash(mtx, color));
+        return it == moves.end() ? none : it->second;
+    }
+
+    /**
+     * Выбирает ход книги: случайно пропорционально весу или (randomize == false) самый частый.
+     * Пустой результат — позиции в книге нет.
+     */
+    template <typename Rng>
+    std::vector<move_pos> choose(const std::vector<std::vector<POS_T>> &mtx, const bool color, Rng &rng,
+                                 const bool randomize) const
+    {
+        const auto &list = probe(mtx, color);
+        if (list.empty())
+            return {};
+        if (!randomize)
+        {
+            size_t best = 0;
+            for (size_t k = 1; k < list.size(); ++k)
+                if (list[k].weight > list[best].weight)
+                    best = k;
+            return list[best].series;
+        }
+        int total = 0;
+        for (const auto &m : list)
+            total += m.weight;
+        int pick = std::uniform_int_distribution<int>(0, total - 1)(rng);
+        for (const auto &m : list)
+        {
+            if (pick < m.weight)
+                return m.series;
+            pick -= m.weight;
+        }
+        return list.back().series;
+    }
+
+    size_t size() const
+    {
+        return moves.size();
+    }
+
+  private:
+    void add(const uint64_t hash, const std::vector<move_pos> &series)
+    {
+        auto &list = moves[hash];
+        for (auto &m : list)
+        {
+            if (m.series.size() == series.size() && equal(m.series.begin(), m.series.end(), series.begin()))
+            {
+                ++m.weight;
+                return;
+            }
+        }
+        list.push_back({series, 1});
+    }
+
+    std::unordered_map<uint64_t, std::vector<book_move>> moves;
+};
@@ -1,9 +1,12 @@
 #pragma once
 #include <fstream>
+#include <string>
 #include <nlohmann/json.hpp>
+using namespace std;
 using json = nlohmann::json;
 
 #include "../Models/Project_path.h"
+#include "../Models/Trace.h"
 
 //// Класс для загрузки и доступа к настройкам из settings.json.
 /// Хранит JSON-объект и предоставляет простой доступ к параметрам по секции/ключу.
@@ -22,6 +25,7 @@ class Config
      */
     void reload()
     {
+        TRACE_SCOPE("Config::reload");
         std::ifstream fin(project_path + "settings.json");
         if (!fin) {
             throw std::runtime_error("Не удалось открыть settings.json");
@@ -43,9 +47,27 @@ class Config
    */
     auto operator()(const string &setting_dir, const string &setting_name) const
     {
+        TRACE_SCOPE("Config::lookup");
         return config[setting_dir][setting_name];
     }
 
+    /*
+     * Есть ли настройка: обращение к отсутствующей через operator() недопустимо.
+     */
+    bool has(const string &setting_dir, const string &setting_name) const
+    {
+        return config.contains(setting_dir) && config[setting_dir].contains(setting_name);
+    }
+
+    /*
+     * Заменяет значение настройки в памяти (файл settings.json не меняется).
+     * Нужно инструментам, которые переопределяют параметры из командной строки / протокола.
+     */
+    void set(const string &setting_dir, const string &setting_name, const json &value)
+    {
+        config[setting_dir][setting_name] = value;
+    }
+
   private:
     json config;
 };
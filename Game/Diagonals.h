@@ -0,0 +1,200 @@
+#pragma once
+#include <cstdint>
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+#include "../Models/Move.h"
+
+/**
+ * Таблицы диагоналей доски N×N, построенные на этапе компиляции.
+ *
+ * Клетка кодируется номером s = x * N + y (x = s / N, y = s % N), -1 — за доской;
+ * для N = 10 номер до 99 помещается в POS_T.
+ * Направления идут в том же порядке, в каком их обходил прежний find_turns:
+ * (-1, -1), (-1, +1), (+1, -1), (+1, +1). Поэтому ходы порождаются в прежнем порядке.
+ */
+template <int N> struct diagonal_tables
+{
+    static constexpr int kSize = N;
+    static constexpr int kSquares = N * N;
+    static constexpr int kDirs = 4;
+    static constexpr int kRay = N;
+
+    // соседняя клетка в направлении d (для взятия шашкой — клетка побиваемой фигуры)
+    POS_T step[kSquares][kDirs];
+    // клетка приземления при взятии шашкой через step[s][d]
+    POS_T jump[kSquares][kDirs];
+    // весь луч от клетки в направлении d, по порядку удаления; заканчивается -1
+    POS_T ray[kSquares][kDirs][kRay];
+    // клетки превращения в дамку: [0] — белые шашки (ряд x == 0), [1] — чёрные (ряд x == N - 1)
+    bool promotion[2][kSquares];
+    // тёмная клетка по номеру бита маски (см. square_bit): dark[s / 2] == s
+    POS_T dark[kSquares / 2];
+};
+
+constexpr POS_T diagonal_dx[4] = {-1, -1, 1, 1};
+constexpr POS_T diagonal_dy[4] = {-1, 1, -1, 1};
+
+template <int N = 8> constexpr POS_T square_x(const POS_T s)
+{
+    return POS_T(uint8_t(s) / N);
+}
+
+template <int N = 8> constexpr POS_T square_y(const POS_T s)
+{
+    return POS_T(uint8_t(s) % N);
+}
+
+/**
+ * Строит таблицы: соседей по направлениям, а прыжки и лучи — цепочками соседей.
+ */
+template <int N> constexpr diagonal_tables<N> build_diagonals()
+{
+    using tables = diagonal_tables<N>;
+    tables t{};
+    for (int s = 0; s < tables::kSquares; ++s)
+    {
+        for (int d = 0; d < tables::kDirs; ++d)
+        {
+            const int x = s / N + diagonal_dx[d], y = s % N + diagonal_dy[d];
+            t.step[s][d] = POS_T((x < 0 || x >= N || y < 0 || y >= N) ? -1 : x * N + y);
+        }
+        t.promotion[0][s] = (s < N);
+        t.promotion[1][s] = (s >= N * (N - 1));
+        if ((s / N + s % N) % 2)
+            t.dark[s / 2] = POS_T(s);
+    }
+    for (int s = 0; s < tables::kSquares; ++s)
+    {
+        for (int d = 0; d < tables::kDirs; ++d)
+        {
+            const POS_T over = t.step[s][d];
+            t.jump[s][d] = (over == -1 ? POS_T(-1) : t.step[over][d]);
+            int len = 0;
+            for (POS_T cur = t.step[s][d]; cur != -1; cur = t.step[cur][d])
+                t.ray[s][d][len++] = cur;
+            for (; len < tables::kRay; ++len)
+                t.ray[s][d][len] = -1;
+        }
+    }
+    return t;
+}
+
+/**
+ * Сверка таблиц с прежним генератором ходов: клетки (x ± 2, y ± 2) с побиваемой ((x + i) / 2, (y + j) / 2),
+ * шаг шашки на (x ∓ 1, y ± 1) и обход луча дамки с проверкой границ на каждом шаге.
+ */
+template <int N> constexpr bool check_diagonals(const diagonal_tables<N> &t)
+{
+    const int last = N - 1;
+    for (int x = 0; x < N; ++x)
+    {
+        for (int y = 0; y < N; ++y)
+        {
+            const int s = x * N + y;
+            int d = 0;
+            for (int i = x - 2; i <= x + 2; i += 4)
+            {
+                for (int j = y - 2; j <= y + 2; j += 4, ++d)
+                {
+                    const bool inside = !(i < 0 || i > last || j < 0 || j > last);
+                    if (inside != (t.jump[s][d] != -1))
+                        return false;
+                    if (inside && (t.jump[s][d] != i * N + j || t.step[s][d] != (x + i) / 2 * N + (y + j) / 2))
+                        return false;
+                }
+            }
+            for (int type = 1; type <= 2; ++type)
+            {
+                const int i = ((type % 2) ? x - 1 : x + 1);
+                d = ((type % 2) ? 0 : 2);
+                for (int j = y - 1; j <= y + 1; j += 2, ++d)
+                {
+                    const bool inside = !(i < 0 || i > last || j < 0 || j > last);
+                    if (t.step[s][d] != (inside ? i * N + j : -1))
+                        return false;
+                }
+                const bool promotes = (type == 1 ? x == 0 : x == last);
+                if (t.promotion[type - 1][s] != promotes)
+                    return false;
+            }
+            if ((x + y) % 2 && t.dark[s / 2] != s)
+                return false;
+            d = 0;
+            for (int i = -1; i <= 1; i += 2)
+            {
+                for (int j = -1; j <= 1; j += 2, ++d)
+                {
+                    int k = 0;
+                    for (int i2 = x + i, j2 = y + j; i2 != N && j2 != N && i2 != -1 && j2 != -1; i2 += i, j2 += j)
+                        if (t.ray[s][d][k++] != i2 * N + j2)
+                            return false;
+                    if (k < diagonal_tables<N>::kRay && t.ray[s][d][k] != -1)
+                        return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template <int N> inline constexpr diagonal_tables<N> board_diagonals = build_diagonals<N>();
+
+// таблицы доски 8x8 (русские и английские шашки, оценка и сеть — только для неё)
+inline constexpr const diagonal_tables<8> &diagonals = board_diagonals<8>;
+
+static_assert(check_diagonals(board_diagonals<8>), "8x8 diagonal tables differ from the coordinate move generator");
+static_assert(check_diagonals(board_diagonals<10>), "10x10 diagonal tables differ from the coordinate move generator");
+
+/**
+ * Становится ли шашка типа type (1 — белая, 2 — чёрная) дамкой, придя на клетку (x, y) доски N×N.
+ */
+template <int N = 8> constexpr bool promotes(const POS_T type, const POS_T x, const POS_T y)
+{
+    return (type == 1 || type == 2) && board_diagonals<N>.promotion[type - 1][x * N + y];
+}
+
+/**
+ * Бит клетки (x, y) в маске побитых фигур move_pos::captured: номер бита — s / 2, у тёмных клеток
+ * он свой для каждой (в ряду они через одну), а тёмных клеток не больше 50 — маска помещается в 64 бита.
+ */
+template <int N = 8> constexpr uint64_t square_bit(const POS_T x, const POS_T y)
+{
+    static_assert(N * N / 2 <= 64, "dark squares don't fit a 64-bit mask");
+    return uint64_t(1) << ((x * N + y) / 2);
+}
+
+// номер младшего единичного бита (mask != 0)
+inline int lowest_bit(const uint64_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return int(index);
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+// число единичных битов (например, побитых фигур серии)
+inline int bit_count(const uint64_t mask)
+{
+#if defined(_MSC_VER)
+    return int(__popcnt64(mask));
+#else
+    return __builtin_popcountll(mask);
+#endif
+}
+
+/**
+ * Вызывает f(x, y) для каждой клетки маски mask (см. square_bit).
+ */
+template <int N = 8, class F> void for_each_square(uint64_t mask, F &&f)
+{
+    for (; mask; mask &= mask - 1)
+    {
+        const POS_T s = board_diagonals<N>.dark[lowest_bit(mask)];
+        f(square_x<N>(s), square_y<N>(s));
+    }
+}
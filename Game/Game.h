@@ -1,49 +1,103 @@
 #pragma once
 #include <chrono>
+#include <future>
 #include <thread>
 
 #include "../Models/Project_path.h"
+#include "../Models/Trace.h"
+#include "Archive.h"
 #include "Board.h"
 #include "Config.h"
 #include "Hand.h"
+#include "Learning.h"
 #include "Logic.h"
+#include "Mcts.h"
 
-class Game
+/**
+ * Партия в окне по правилам варианта Rules (см. Variant.h; выбирается в main по "Game" → "Variant").
+ */
+template <class Rules> class BasicGame
 {
   public:
-    Game() : board(config("WindowSize", "Width"), config("WindowSize", "Hight")), hand(&board), logic(&board, &config)
+    BasicGame()
+        : board(config("WindowSize", "Width"), config("WindowSize", "Hight"), Rules::size), hand(&board),
+          logic(&config), archive(&config)
     {
+        make_mcts();
+        TRACE_SCOPE("Game::log");
         ofstream fout(project_path + "log.txt", ios_base::trunc);
+        if (string(config("Game", "Variant")) != Rules::name)
+            fout << "Error: unknown variant " << string(config("Game", "Variant")) << ", playing " << Rules::name
+                 << "\n";
+        // обучение: свой файл у каждого варианта (у 8x8 вариантов общие ключи Зобриста)
+        const string learn_file = config("Bot", "LearnFile");
+        if (!learn_file.empty() && !learning.open(project_path + learn_file + "_" + Rules::name + ".bin"))
+            fout << "Error: can't open learning file " << learn_file << "_" << Rules::name << ".bin\n";
+        const string archive_file = archive_path(config, Rules::name);
+        if (!archive_file.empty() && !archive.open(archive_file))
+            fout << "Error: can't open game archive " << archive_file << "\n";
         fout.close();
     }
 
     /*
-    * Основной игровой цикл.
-    * Главный игровой цикл: запускает/перезапускает игру, чередует ходы игрока и бота,
-    * учитывает лимит ходов, измеряет длительность партии и показывает итог.
+    * Основной игровой цикл: партии одна за другой, пока игрок просит повтор.
+    * Повтор — следующий виток цикла, а не рекурсивный вызов, так что стек от партии к партии не растёт.
+    * Партии многих игроков без окна — Session.h.
     */
     int play()
+    {
+        while (true)
+        {
+            const int res = play_once();
+            if (!is_replay)
+                return res;
+        }
+    }
+
+  private:
+    /*
+    * Одна партия: запускает/перезапускает игру, чередует ходы игрока и бота,
+    * учитывает лимит ходов, измеряет длительность партии и показывает итог.
+    * Если игрок попросил повтор, is_replay = true.
+    */
+    int play_once()
     {
         auto start = chrono::steady_clock::now();
         if (is_replay)
         {
-            logic = Logic(&board, &config);
+            logic = BasicLogic<Rules>(&config);
             config.reload();
+            make_mcts();
             board.redraw();
         }
         else
         {
             board.start_draw();
+            // время холодного старта: от создания Game до первого показанного кадра
+            TRACE_SCOPE("Game::log");
+            ofstream fout(project_path + "log.txt", ios_base::app);
+            fout << "Startup time: "
+                 << (int)chrono::duration<double, milli>(chrono::steady_clock::now() - launch).count()
+                 << " millisec\n";
         }
         is_replay = false;
 
         int turn_num = -1;
         bool is_quit = false;
+        bool is_draw = false;
         const int Max_turns = config("Game", "MaxNumTurns");
+        const int draw_plies = 2 * int(config("Game", "KingMovesDraw"));
+        positions.clear();
         while (++turn_num < Max_turns)
         {
+            TRACE_SCOPE("Game::turn");
             beat_series = 0;
-            logic.find_turns(turn_num % 2);
+            if (update_history(turn_num, draw_plies))
+            {
+                is_draw = true;
+                break;
+            }
+            logic.find_turns(turn_num % 2, board.get_board());
             if (logic.turns.empty())
                 break;
             logic.Max_depth = config("Bot", string((turn_num % 2) ? "Black" : "White") + string("BotLevel"));
@@ -80,16 +134,17 @@ class Game
                 bot_turn(turn_num % 2);
         }
         auto end = chrono::steady_clock::now();
-        ofstream fout(project_path + "log.txt", ios_base::app);
-        fout << "Game time: " << (int)chrono::duration<double, milli>(end - start).count() << " millisec\n";
-        fout.close();
+        {
+            TRACE_SCOPE("Game::log");
+            ofstream fout(project_path + "log.txt", ios_base::app);
+            fout << "Game time: " << (int)chrono::duration<double, milli>(end - start).count() << " millisec\n";
+            fout.close();
+        }
 
-        if (is_replay)
-            return play();
-        if (is_quit)
+        if (is_replay || is_quit)
             return 0;
         int res = 2;
-        if (turn_num == Max_turns)
+        if (turn_num == Max_turns || is_draw)
         {
             res = 0;
         }
@@ -97,35 +152,120 @@ class Game
         {
             res = 1;
         }
+        learn_outcome(res);
+        archive_game(res, turn_num);
         board.show_final(res);
-        auto resp = hand.wait();
-        if (resp == Response::REPLAY)
+        is_replay = (hand.wait() == Response::REPLAY);
+        return res;
+    }
+
+    /**
+     * Запоминает позицию перед полуходом turn_num и передаёт историю партии в logic
+     * (повторения и счётчик ходов дамками учитываются в поиске).
+     * После отката ходов (Response::BACK) лишние позиции отбрасываются по номеру полухода.
+     * Возвращает true, если наступила ничья: позиция повторилась третий раз или
+     * draw_plies полуходов подряд (draw_plies > 0) сделаны только дамками без взятий.
+     */
+    bool update_history(const int turn_num, const int draw_plies)
+    {
+        TRACE_SCOPE("Game::update_history");
+        positions.resize(turn_num);
+        const auto mtx = board.get_board();
+        const auto &zobrist = BasicZobrist<Rules::size>::get();
+        logic.history.clear();
+        for (int k = 0; k < turn_num; ++k)
+            logic.history.push_back(zobrist.hash(positions[k], k % 2));
+        logic.king_plies = 0;
+        for (int k = turn_num - 1;
+             k >= 0 && BasicLogic<Rules>::is_king_move(positions[k], k + 1 < turn_num ? positions[k + 1] : mtx); --k)
+            ++logic.king_plies;
+        positions.push_back(mtx);
+
+        const uint64_t hash = zobrist.hash(mtx, turn_num % 2);
+        return count(logic.history.begin(), logic.history.end(), hash) >= 2 ||
+               (draw_plies && logic.king_plies >= draw_plies);
+    }
+
+    /**
+     * Ход бота в позиции mtx по прыжкам. Сначала — обучение: позиция, просчитанная на "LearnExtraDepth"
+     * полуходов глубже уровня бота, разыгрывается сразу; просчитанная хотя бы на уровень — ищется
+     * на полуход глубже прежнего, так что частые позиции с каждой встречей углубляются.
+     * Иначе — обычный поиск (alpha-beta или MCTS); результат alpha-beta записывается в обучение.
+     * Позиции, где уже идёт счёт ходов дамками ("KingMovesDraw"), зависят от пути к ним и не запоминаются.
+     * Бот с профилем сложности ("WhiteBotProfile" / "BlackBotProfile") ищет по профилю, без обучения.
+     */
+    vector<move_pos> search_turns(const bool color, const vector<vector<POS_T>> &mtx)
+    {
+        search_profile profile;
+        if (read_profile(config, config("Bot", color ? "BlackBotProfile" : "WhiteBotProfile"), profile))
+            return logic.find_profile_turns(color, mtx, profile);
+        const bool learn = learning.is_open() && logic.king_plies == 0;
+        const uint64_t key = BasicZobrist<Rules::size>::get().hash(mtx, color);
+        const auto known = (learn ? learning.probe(key) : nullopt);
+        // глубина в обучении — полуходов поиска, т. е. уровень + 1
+        const int plies = logic.Max_depth + 1, extra = config("Bot", "LearnExtraDepth");
+        if (known && known->depth && known->depth >= plies + extra)
         {
-            is_replay = true;
-            return play();
+            logic.find_turns(color, mtx);
+            if (find(logic.turns.begin(), logic.turns.end(), known->move) != logic.turns.end())
+                return logic.series_steps(mtx, known->move);
         }
+        if (mcts)
+            return mcts->find_best_turns(color, mtx, logic.king_plies);
+        if (known && known->depth >= plies)
+            logic.Max_depth = known->depth;
+        auto res = logic.find_best_turns(color, mtx);
+        if (learn && !res.empty())
+            learning.store(key, logic.Max_depth + 1, logic.last_score, logic.last_turn);
         return res;
     }
 
-  private:
+    /**
+     * Исход законченной партии (res — как у play: 0 ничья, 1 белые, 2 чёрные) — в обучение для каждой её позиции;
+     * разросшийся журнал обучения сливается с базой.
+     */
+    void learn_outcome(const int res)
+    {
+        if (!learning.is_open())
+            return;
+        const auto &zobrist = BasicZobrist<Rules::size>::get();
+        for (size_t k = 0; k < positions.size(); ++k)
+            learning.add_outcome(zobrist.hash(positions[k], k % 2), res == 0 ? 0 : ((res == 1) == (k % 2 == 0) ? 1 : -1));
+        if (learning.compact_due())
+            learning.compact();
+    }
+
+    /**
+     * Законченная партия (turn_num полуходов, итог res) — в архив партий ("ArchiveFile").
+     * Позиция после последнего хода в positions есть, только если партию закончила проверка перед ходом.
+     */
+    void archive_game(const int res, const int turn_num)
+    {
+        if (!archive.is_open())
+            return;
+        auto played = positions;
+        if (played.size() == size_t(turn_num))
+            played.push_back(board.get_board());
+        archive.append_positions(played, false, res);
+    }
+
     /**
      * Выполняет ход бота заданного цвета.
      *
      * Логика:
      *  1) Фиксируем время начала — для телеметрии.
      *  2) Читаем задержку хода из конфигурации ("BotDelayMS").
-     *  3) Стартуем вспомогательный поток с SDL_Delay, чтобы гарантировать
-     *     минимальную «паузу обдумывания» перед тем, как появится первый ход,
-     *     независимо от времени вычисления best-ходов.
-     *  4) Вычисляем оптимальную последовательность ходов бота (в т.ч. серию взятий)
-     *     через logic.find_best_turns(color).
-     *  5) Дожидаемся завершения «выравнивающей» задержки и применяем ходы по очереди:
-     *       - перед первым ходом задержка уже была (в отдельном потоке),
-     *         перед каждым последующим — делаем ту же паузу вручную,
+     *  3) Вычисляем оптимальную последовательность ходов бота (в т.ч. серию взятий)
+     *     через search_turns (обучение, logic.find_best_turns или MCTS) в отдельном потоке,
+     *     а основной поток тем временем обслуживает окно (hand.idle) — доска
+     *     перерисовывается, и ход появляется не раньше «паузы обдумывания» BotDelayMS.
+     *  4) Применяем ходы по очереди:
+     *       - перед первым ходом задержка уже была (вместе с поиском),
+     *         перед каждым последующим — та же пауза, тоже с обслуживанием окна,
      *       - beat_series увеличиваем на каждый ход со взятием (turn.xb != -1),
      *         чтобы корректно вести историю/визуализацию длин серий,
      *       - board.move_piece(turn, beat_series) обновляет состояние доски и историю.
-     *  6) Логируем затраченное время в log.txt (в миллисекундах).
+     *  5) Логируем затраченное время в log.txt (в миллисекундах).
      *
      * Параметры:
      *   @param color — цвет бота (true/false), используется в поиске хода.
@@ -137,27 +277,36 @@ class Game
      */
     void bot_turn(const bool color)
     {
+        TRACE_SCOPE("Game::bot_turn");
         auto start = chrono::steady_clock::now();
 
-        auto delay_ms = config("Bot", "BotDelayMS");
-        // new thread for equal delay for each turn
-        thread th(SDL_Delay, delay_ms);
-        auto turns = logic.find_best_turns(color);
-        th.join();
+        const chrono::milliseconds delay_ms(int(config("Bot", "BotDelayMS")));
+        // поиск — в отдельном потоке, окно тем временем живёт; пауза одинакова для каждого хода
+        const auto mtx = board.get_board();
+        auto search = async(launch::async, [&]() {
+            TRACE_THREAD("search");
+            auto res = search_turns(color, mtx);
+            Hand::wake();
+            return res;
+        });
+        hand.idle([&]() { return search.wait_for(chrono::seconds(0)) == future_status::ready; },
+                  chrono::steady_clock::now() + delay_ms);
+        auto turns = search.get();
         bool is_first = true;
         // making moves
         for (auto turn : turns)
         {
             if (!is_first)
             {
-                SDL_Delay(delay_ms);
+                hand.idle(nullptr, chrono::steady_clock::now() + delay_ms);
             }
             is_first = false;
             beat_series += (turn.xb != -1);
-            board.move_piece(turn, beat_series);
+            board.move_piece(turn, beat_series, turn.crown);
         }
 
         auto end = chrono::steady_clock::now();
+        TRACE_SCOPE("Game::log");
         ofstream fout(project_path + "log.txt", ios_base::app);
         fout << "Bot turn time: " << (int)chrono::duration<double, milli>(end - start).count() << " millisec\n";
         fout.close();
@@ -167,19 +316,18 @@ class Game
      * Выполняет ход игрока.
      *
      * Алгоритм работы:
-     * 1. Подсвечивает все возможные ходы (взятые из logic.turns).
+     * 1. Подсвечивает фигуры, которыми можно ходить (ходы по прыжкам из logic.find_series).
      * 2. Ждёт, пока игрок выберет клетку:
      *    - если выбрана некорректная клетка, подсветка сбрасывается и цикл выбора продолжается;
      *    - если выбран корректный ход, фигура перемещается.
-     * 3. Если в результате хода возможны взятия (beat), продолжается серия добиваний:
-     *    - после каждого удачного удара снова ищутся возможные добивания;
-     *    - игрок выбирает клетку для следующего удара;
-     *    - серия продолжается, пока есть возможность бить.
+     * 3. Если ход — серия взятий, игрок продолжает её прыжок за прыжком:
+     *    - подсвечиваются клетки следующего прыжка всех путей, совпадающих с уже сделанными прыжками;
+     *    - серия продолжается, пока выбранный путь не закончится.
      * 4. В любой момент, если пользовательский ввод возвращает не Response::CELL 
      *    (например, игрок нажал «выход»), функция завершает работу и возвращает это значение.
      *
      * Параметры:
-     *   @param color — цвет игрока (true/false), пока не используется в логике.
+     *   @param color — цвет игрока (true/false).
      *
      * Возвращает:
      *   Response::OK   — если ход завершён успешно;
@@ -187,14 +335,16 @@ class Game
      */
     Response player_turn(const bool color)
     {
+        TRACE_SCOPE("Game::player_turn");
         // return 1 if quit
+        // ходы по прыжкам: серия взятий выбирается прыжок за прыжком среди путей, которыми её можно сыграть
+        auto series = logic.find_series(color, board.get_board());
         vector<pair<POS_T, POS_T>> cells;
-        for (auto turn : logic.turns)
+        for (const auto &s : series)
         {
-            cells.emplace_back(turn.x, turn.y);
+            cells.emplace_back(s[0].x, s[0].y);
         }
         board.highlight_cells(cells);
-        move_pos pos = {-1, -1, -1, -1};
         POS_T x = -1, y = -1;
         // trying to make first move
         while (true)
@@ -205,21 +355,22 @@ class Game
             pair<POS_T, POS_T> cell{get<1>(resp), get<2>(resp)};
 
             bool is_correct = false;
-            for (auto turn : logic.turns)
+            vector<vector<move_pos>> chosen;
+            for (const auto &s : series)
             {
-                if (turn.x == cell.first && turn.y == cell.second)
+                if (s[0].x == cell.first && s[0].y == cell.second)
                 {
                     is_correct = true;
                     break;
                 }
-                if (turn == move_pos{x, y, cell.first, cell.second})
-                {
-                    pos = turn;
-                    break;
-                }
+                if (s[0].x == x && s[0].y == y && s[0].x2 == cell.first && s[0].y2 == cell.second)
+                    chosen.push_back(s);
             }
-            if (pos.x != -1)
+            if (!is_correct && !chosen.empty())
+            {
+                series = std::move(chosen);
                 break;
+            }
             if (!is_correct)
             {
                 if (x != -1)
@@ -237,32 +388,30 @@ class Game
             board.clear_highlight();
             board.set_active(x, y);
             vector<pair<POS_T, POS_T>> cells2;
-            for (auto turn : logic.turns)
+            for (const auto &s : series)
             {
-                if (turn.x == x && turn.y == y)
+                if (s[0].x == x && s[0].y == y)
                 {
-                    cells2.emplace_back(turn.x2, turn.y2);
+                    cells2.emplace_back(s[0].x2, s[0].y2);
                 }
             }
             board.highlight_cells(cells2);
         }
         board.clear_highlight();
         board.clear_active();
-        board.move_piece(pos, pos.xb != -1);
+        move_pos pos = series[0][0];
+        board.move_piece(pos, pos.xb != -1, pos.crown);
         if (pos.xb == -1)
             return Response::OK;
-        // continue beating while can
+        // continue beating while the chosen series goes on
+        // (пути с общим началом приходят в одну позицию, поэтому продолжаются все или ни один)
         beat_series = 1;
-        while (true)
+        for (size_t k = 1; k < series[0].size(); ++k)
         {
-            logic.find_turns(pos.x2, pos.y2);
-            if (!logic.have_beats)
-                break;
-
             vector<pair<POS_T, POS_T>> cells;
-            for (auto turn : logic.turns)
+            for (const auto &s : series)
             {
-                cells.emplace_back(turn.x2, turn.y2);
+                cells.emplace_back(s[k].x2, s[k].y2);
             }
             board.highlight_cells(cells);
             board.set_active(pos.x2, pos.y2);
@@ -274,23 +423,21 @@ class Game
                     return get<0>(resp);
                 pair<POS_T, POS_T> cell{get<1>(resp), get<2>(resp)};
 
-                bool is_correct = false;
-                for (auto turn : logic.turns)
+                vector<vector<move_pos>> chosen;
+                for (const auto &s : series)
                 {
-                    if (turn.x2 == cell.first && turn.y2 == cell.second)
-                    {
-                        is_correct = true;
-                        pos = turn;
-                        break;
-                    }
+                    if (s[k].x2 == cell.first && s[k].y2 == cell.second)
+                        chosen.push_back(s);
                 }
-                if (!is_correct)
+                if (chosen.empty())
                     continue;
+                series = std::move(chosen);
 
                 board.clear_highlight();
                 board.clear_active();
                 beat_series += 1;
-                board.move_piece(pos, beat_series);
+                pos = series[0][k];
+                board.move_piece(pos, beat_series, pos.crown);
                 break;
             }
         }
@@ -299,10 +446,30 @@ class Game
     }
 
   private:
+    // движок бота из настроек: MCTS создаётся (с ареной узлов) только когда выбран
+    void make_mcts()
+    {
+        if (string(config("Bot", "Engine")) == "MCTS")
+            mcts = make_unique<BasicMcts<Rules>>(&config);
+        else
+            mcts.reset();
+    }
+
+    // момент запуска (объявлен первым, чтобы отсчёт шёл до загрузки настроек и окна)
+    const chrono::steady_clock::time_point launch = chrono::steady_clock::now();
     Config config;
     Board board;
     Hand hand;
-    Logic logic;
+    BasicLogic<Rules> logic;
+    // поиск Монте-Карло вместо alpha-beta ("Bot" → "Engine" = "MCTS"), иначе nullptr
+    unique_ptr<BasicMcts<Rules>> mcts;
+    // результаты поиска и исходы партий между запусками ("LearnFile")
+    Learning learning;
+    // сыгранные партии для поиска по позициям ("ArchiveFile")
+    BasicArchiveWriter<Rules> archive;
     int beat_series;
     bool is_replay = false;
+
+    // позиции партии перед каждым полуходом (индекс — номер полухода)
+    vector<vector<vector<POS_T>>> positions;
 };
@@ -1,8 +1,11 @@
 #pragma once
+#include <chrono>
+#include <functional>
 #include <tuple>
 
 #include "../Models/Move.h"
 #include "../Models/Response.h"
+#include "../Models/Trace.h"
 #include "Board.h"
 
 // Класс Hand обрабатывает действия "руки игрока" (ввода с мыши и окна)
@@ -31,8 +34,9 @@ class Hand
 
         while (true)
         {
-            if (SDL_PollEvent(&windowEvent)) // проверяем очередь событий SDL
+            if (next_event(windowEvent)) // ждём событие SDL, попутно рисуя кадры доски
             {
+                TRACE_SCOPE("Hand::event");
                 switch (windowEvent.type)
                 {
                 case SDL_QUIT:
@@ -43,19 +47,19 @@ class Hand
                     // определяем клетку по координатам мыши
                     x = windowEvent.motion.x;
                     y = windowEvent.motion.y;
-                    xc = int(y / (board->H / 10) - 1);
-                    yc = int(x / (board->W / 10) - 1);
+                    xc = int(y / (board->H / (board->N + 2)) - 1);
+                    yc = int(x / (board->W / (board->N + 2)) - 1);
 
                     // разные реакции в зависимости от зоны клика
                     if (xc == -1 && yc == -1 && board->history_mtx.size() > 1)
                     {
                         resp = Response::BACK; // кнопка "назад"
                     }
-                    else if (xc == -1 && yc == 8)
+                    else if (xc == -1 && yc == board->N)
                     {
                         resp = Response::REPLAY; // кнопка "повтор"
                     }
-                    else if (xc >= 0 && xc < 8 && yc >= 0 && yc < 8)
+                    else if (xc >= 0 && xc < board->N && yc >= 0 && yc < board->N)
                     {
                         resp = Response::CELL; // корректная клетка
                     }
@@ -94,27 +98,29 @@ class Hand
 
         while (true)
         {
-            if (SDL_PollEvent(&windowEvent))
+            if (next_event(windowEvent))
             {
+                TRACE_SCOPE("Hand::event");
                 switch (windowEvent.type)
                 {
                 case SDL_QUIT:
                     resp = Response::QUIT; // закрытие окна
                     break;
 
-                case SDL_WINDOWEVENT_SIZE_CHANGED:
-                    board->reset_window_size();
+                case SDL_WINDOWEVENT:
+                    if (windowEvent.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                        board->reset_window_size();
                     break;
 
                 case SDL_MOUSEBUTTONDOWN: {
                     // определяем клетку, куда кликнули
                     int x = windowEvent.motion.x;
                     int y = windowEvent.motion.y;
-                    int xc = int(y / (board->H / 10) - 1);
-                    int yc = int(x / (board->W / 10) - 1);
+                    int xc = int(y / (board->H / (board->N + 2)) - 1);
+                    int yc = int(x / (board->W / (board->N + 2)) - 1);
 
                     // щёлчок по кнопке "повтор"
-                    if (xc == -1 && yc == 8)
+                    if (xc == -1 && yc == board->N)
                         resp = Response::REPLAY;
                 }
                 break;
@@ -126,6 +132,72 @@ class Hand
         return resp;
     }
 
+    /**
+     * Обслуживает окно, пока игра занята (ход бота): рисует кадры доски и обрабатывает
+     * изменение размера, пока не выполнено done() (nullptr — сразу) и не наступил момент not_before.
+     * Закрытие окна в это время не теряется — событие возвращается в очередь для следующего ожидания ввода.
+     * Из другого потока ожидание прерывается вызовом wake().
+     */
+    void idle(const function<bool()> &done, const chrono::steady_clock::time_point not_before) const
+    {
+        TRACE_SCOPE("Hand::idle");
+        SDL_Event windowEvent;
+        bool quit = false;
+        while (true)
+        {
+            const int frame_ms = board->update();
+            const auto now = chrono::steady_clock::now();
+            const bool ready = !done || done();
+            if (ready && now >= not_before)
+                break;
+            // ждём ближайшего из: следующего кадра, конца паузы, события (в т.ч. wake())
+            int timeout = frame_ms ? frame_ms : -1;
+            if (ready)
+            {
+                const int left = int(chrono::duration_cast<chrono::milliseconds>(not_before - now).count()) + 1;
+                timeout = (timeout == -1 ? left : min(timeout, left));
+            }
+            if (!(timeout == -1 ? SDL_WaitEvent(&windowEvent) : SDL_WaitEventTimeout(&windowEvent, timeout)))
+                continue;
+            if (windowEvent.type == SDL_QUIT)
+                quit = true;
+            else if (windowEvent.type == SDL_WINDOWEVENT && windowEvent.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                board->reset_window_size();
+        }
+        if (quit)
+        {
+            SDL_Event quit_event{};
+            quit_event.type = SDL_QUIT;
+            SDL_PushEvent(&quit_event);
+        }
+    }
+
+    /**
+     * Будит idle() из другого потока (например, когда бот нашёл ход).
+     */
+    static void wake()
+    {
+        SDL_Event event{};
+        event.type = wake_event();
+        SDL_PushEvent(&event);
+    }
+
   private:
+    static Uint32 wake_event()
+    {
+        static const Uint32 type = SDL_RegisterEvents(1);
+        return type;
+    }
+
+    /**
+     * Следующее событие окна. Пока кадр доски не нарисован (ограничение частоты кадров),
+     * ждёт не дольше, чем до следующего кадра, иначе — до события. false — событий нет.
+     */
+    bool next_event(SDL_Event &windowEvent) const
+    {
+        const int frame_ms = board->update();
+        return frame_ms ? SDL_WaitEventTimeout(&windowEvent, frame_ms) : SDL_WaitEvent(&windowEvent);
+    }
+
     Board *board; // ссылка на игровое поле для пересчёта размеров и координат
 };
@@ -0,0 +1,483 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define CHECKERS_LEARNING_MMAP
+#endif
+
+#include "../Models/Move.h"
+#include "../Models/Score.h"
+
+/**
+ * Обучение между партиями и запусками: результаты поиска и исходы партий по хешу позиции на диске.
+ *
+ * Для позиции (хеш Зобриста с учётом стороны хода) хранится глубина, оценка и лучший ход последнего
+ * самого глубокого поиска, а также сколько раз сторона хода из неё выиграла, сыграла вничью и проиграла.
+ * Бот сначала смотрит сюда: позицию, уже просчитанную не мельче нужного, он не ищет заново,
+ * а каждая новая встреча позиции может углубить запись (см. Game::bot_turn, "LearnExtraDepth").
+ *
+ * Файл — заголовок и записи по 32 байта. Первые sorted записей отсортированы по ключу и читаются
+ * через mmap прямо из файла (на других системах — читаются в память целиком), без разбора при старте.
+ * За ними — журнал: каждое изменение дописывается в конец файла отдельной записью-дельтой
+ * (поиск заменяет запись, если не мельче; исходы прибавляются) и сбрасывается на диск сразу.
+ * Запись с контрольной суммой: хвост, оборванный падением процесса, при открытии отбрасывается.
+ * Журнал при открытии читается в хеш-таблицу; когда он разрастается, compact() сливает его
+ * с отсортированной частью в новый файл и атомарно подменяет им старый (rename).
+ */
+class Learning
+{
+  public:
+    struct entry
+    {
+        uint64_t key = 0;
+        SCORE_T score = 0;
+        move_pos move{-1, -1, -1, -1};
+        uint8_t depth = 0; ///< 0 — позиция встречалась в партиях, но не искалась
+        uint32_t wins = 0, draws = 0, losses = 0;
+    };
+
+    Learning() = default;
+    Learning(const Learning &) = delete;
+    Learning &operator=(const Learning &) = delete;
+
+    ~Learning()
+    {
+        close();
+    }
+
+    /**
+     * Открывает (или создаёт) файл path. false — файл не открыть или он не наш; тогда обучение выключено.
+     */
+    bool open(const std::string &path)
+    {
+        close();
+        this->path = path;
+        if (!map_base())
+        {
+            close();
+            return false;
+        }
+        return is_open();
+    }
+
+    bool is_open() const
+    {
+        return log != nullptr;
+    }
+
+    /**
+     * Запись позиции или пустое значение, если позиции нет.
+     */
+    std::optional<entry> probe(const uint64_t key) const
+    {
+        const auto it = recent.find(key);
+        if (it != recent.end())
+            return unpack(it->second);
+        if (const record *r = find_base(key))
+            return unpack(*r);
+        return std::nullopt;
+    }
+
+    /**
+     * Результат поиска позиции key на глубину depth: ход move (полная серия) с оценкой score за сторону хода.
+     * Запись не мельче прежней заменяет её.
+     */
+    void store(const uint64_t key, const int depth, const SCORE_T score, const move_pos &move)
+    {
+        record delta{};
+        delta.key = key;
+        delta.depth = uint8_t(std::clamp(depth, 1, 255));
+        delta.score = score;
+        delta.captured = move.captured;
+        delta.squares = uint16_t((move.x & 0xF) | (move.y & 0xF) << 4 | (move.x2 & 0xF) << 8 | (move.y2 & 0xF) << 12);
+        delta.flags = uint8_t(move.crown);
+        apply(delta);
+    }
+
+    /**
+     * Исход партии для стороны хода в позиции key: 1 — выиграла, 0 — ничья, -1 — проиграла.
+     */
+    void add_outcome(const uint64_t key, const int result)
+    {
+        record delta{};
+        delta.key = key;
+        (result > 0 ? delta.wins : result < 0 ? delta.losses : delta.draws) = 1;
+        apply(delta);
+    }
+
+    /**
+     * Записей в журнале, ещё не слитых с отсортированной частью.
+     */
+    size_t log_size() const
+    {
+        return log_records;
+    }
+
+    /**
+     * Сливает журнал с отсортированной частью: новый файл пишется рядом и подменяет старый.
+     * Вызывать, когда журнал велик по сравнению с базой (compact_due).
+     */
+    bool compact()
+    {
+        if (!is_open())
+            return false;
+        std::vector<record> merged;
+        merged.reserve(base_count + recent.size());
+        std::vector<record> fresh;
+        fresh.reserve(recent.size());
+        for (const auto &kv : recent)
+            fresh.push_back(kv.second);
+        std::sort(fresh.begin(), fresh.end(), [](const record &a, const record &b) { return a.key < b.key; });
+        // слияние двух отсортированных последовательностей; у записей из журнала база уже учтена
+        size_t i = 0, j = 0;
+        while (i < base_count || j < fresh.size())
+        {
+            if (j == fresh.size() || (i < base_count && base[i].key < fresh[j].key))
+                merged.push_back(base[i++]);
+            else
+            {
+                if (i < base_count && base[i].key == fresh[j].key)
+                    ++i;
+                merged.push_back(fresh[j++]);
+            }
+        }
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream fout(tmp, std::ios_base::binary | std::ios_base::trunc);
+            header h = make_header(merged.size());
+            fout.write(reinterpret_cast<const char *>(&h), sizeof(h));
+            for (auto &r : merged)
+            {
+                r.check = checksum(r);
+                fout.write(reinterpret_cast<const char *>(&r), sizeof(r));
+            }
+            fout.flush();
+            if (!fout)
+            {
+                std::remove(tmp.c_str());
+                return false;
+            }
+        }
+        sync_file(tmp);
+        const std::string target = path;
+        close();
+#ifndef CHECKERS_LEARNING_MMAP
+        // rename в Windows не заменяет существующий файл
+        std::remove(target.c_str());
+#endif
+        const bool renamed = (std::rename(tmp.c_str(), target.c_str()) == 0);
+        open(target);
+        return renamed;
+    }
+
+    /**
+     * true, когда журнал пора слить: больше половины базы и не меньше kMinCompact записей.
+     */
+    bool compact_due() const
+    {
+        return log_records >= kMinCompact && log_records > base_count / 2;
+    }
+
+    void close()
+    {
+        if (log)
+            std::fclose(log);
+        log = nullptr;
+#ifdef CHECKERS_LEARNING_MMAP
+        if (mapping)
+            munmap(mapping, mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+#endif
+        base_copy.clear();
+        base = nullptr;
+        base_count = 0;
+        recent.clear();
+        log_records = 0;
+    }
+
+  private:
+    // запись файла: полная (в отсортированной части) или дельта (в журнале)
+    struct record
+    {
+        uint64_t key;
+        uint64_t captured;
+        int32_t score;
+        uint16_t squares; ///< x, y, x2, y2 по 4 бита
+        uint8_t depth;
+        uint8_t flags; ///< бит 0 — превращение
+        uint16_t wins, draws, losses;
+        uint16_t check;
+    };
+    static_assert(sizeof(record) == 32, "record layout");
+
+    struct header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t sorted;
+        uint64_t reserved;
+    };
+    static_assert(sizeof(header) == 32, "header layout");
+
+    static constexpr char kMagic[8] = {'C', 'H', 'K', 'L', 'E', 'A', 'R', 'N'};
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kMinCompact = 4096;
+
+    static header make_header(const uint64_t sorted)
+    {
+        header h{};
+        std::memcpy(h.magic, kMagic, sizeof(kMagic));
+        h.version = kVersion;
+        h.record_size = sizeof(record);
+        h.sorted = sorted;
+        return h;
+    }
+
+    // контрольная сумма записи (нулевая запись — от обнулённого хвоста — не проходит)
+    static uint16_t checksum(const record &r)
+    {
+        uint64_t h = 0x9E3779B97F4A7C15ull;
+        const uint64_t words[4] = {r.key, r.captured,
+                                   uint64_t(uint32_t(r.score)) | uint64_t(r.squares) << 32 | uint64_t(r.depth) << 48 |
+                                       uint64_t(r.flags) << 56,
+                                   uint64_t(r.wins) | uint64_t(r.draws) << 16 | uint64_t(r.losses) << 32};
+        for (const uint64_t w : words)
+        {
+            h = (h ^ w) * 0xBF58476D1CE4E5B9ull;
+            h ^= h >> 31;
+        }
+        return uint16_t(h ^ h >> 16 ^ h >> 32 ^ h >> 48) | 1;
+    }
+
+    static entry unpack(const record &r)
+    {
+        entry e;
+        e.key = r.key;
+        e.score = r.score;
+        e.depth = r.depth;
+        if (r.depth)
+        {
+            e.move.x = POS_T(r.squares & 0xF);
+            e.move.y = POS_T((r.squares >> 4) & 0xF);
+            e.move.x2 = POS_T((r.squares >> 8) & 0xF);
+            e.move.y2 = POS_T((r.squares >> 12) & 0xF);
+            e.move.crown = r.flags & 1;
+            e.move.captured = r.captured;
+        }
+        e.wins = r.wins;
+        e.draws = r.draws;
+        e.losses = r.losses;
+        return e;
+    }
+
+    // дельта поверх записи: поиск — если не мельче, исходы — сложением (при переполнении счётчики делятся пополам)
+    static void merge(record &into, const record &delta)
+    {
+        if (delta.depth && delta.depth >= into.depth)
+        {
+            into.depth = delta.depth;
+            into.score = delta.score;
+            into.captured = delta.captured;
+            into.squares = delta.squares;
+            into.flags = delta.flags;
+        }
+        uint32_t wins = into.wins + delta.wins, draws = into.draws + delta.draws, losses = into.losses + delta.losses;
+        while (wins > 0xFFFF || draws > 0xFFFF || losses > 0xFFFF)
+        {
+            wins /= 2;
+            draws /= 2;
+            losses /= 2;
+        }
+        into.wins = uint16_t(wins);
+        into.draws = uint16_t(draws);
+        into.losses = uint16_t(losses);
+    }
+
+    const record *find_base(const uint64_t key) const
+    {
+        const record *end = base + base_count;
+        const record *it =
+            std::lower_bound(base, end, key, [](const record &r, const uint64_t k) { return r.key < k; });
+        return (it != end && it->key == key) ? it : nullptr;
+    }
+
+    // дельта — в память и в конец файла
+    void apply(record delta)
+    {
+        if (!is_open())
+            return;
+        delta.check = checksum(delta);
+        std::fwrite(&delta, sizeof(delta), 1, log);
+        std::fflush(log);
+        ++log_records;
+        absorb(delta);
+    }
+
+    void absorb(const record &delta)
+    {
+        auto it = recent.find(delta.key);
+        if (it == recent.end())
+        {
+            record start{};
+            start.key = delta.key;
+            if (const record *r = find_base(delta.key))
+                start = *r;
+            it = recent.emplace(delta.key, start).first;
+        }
+        merge(it->second, delta);
+    }
+
+    /**
+     * Открывает файл: проверяет заголовок, отображает отсортированную часть, читает журнал
+     * и обрезает оборванный хвост. Файла нет — создаётся пустой.
+     */
+    bool map_base()
+    {
+        std::vector<record> journal;
+        uint64_t sorted = 0;
+        uint64_t valid_size = sizeof(header);
+        {
+            std::ifstream fin(path, std::ios_base::binary);
+            if (!fin)
+            {
+                std::ofstream fout(path, std::ios_base::binary | std::ios_base::trunc);
+                const header h = make_header(0);
+                fout.write(reinterpret_cast<const char *>(&h), sizeof(h));
+                if (!fout)
+                    return false;
+            }
+            else
+            {
+                header h{};
+                if (!fin.read(reinterpret_cast<char *>(&h), sizeof(h)) ||
+                    std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion ||
+                    h.record_size != sizeof(record))
+                    return false;
+                sorted = h.sorted;
+                // отсортированная часть, которой нет в файле целиком (обрезан, испорчен), — файл не наш:
+                // иначе mmap отобразил бы страницы за концом файла и первый probe упал бы с SIGBUS
+                fin.seekg(0, std::ios_base::end);
+                const uint64_t file_size = uint64_t(fin.tellg());
+                if (!fin || sorted > (file_size - sizeof(header)) / sizeof(record))
+                    return false;
+                if (!fin.seekg(std::streamoff(sizeof(header) + sorted * sizeof(record))))
+                    return false;
+                valid_size += sorted * sizeof(record);
+                record r;
+                while (fin.read(reinterpret_cast<char *>(&r), sizeof(r)) && r.check == checksum(r))
+                {
+                    journal.push_back(r);
+                    valid_size += sizeof(r);
+                }
+            }
+        }
+        if (!map_sorted(sorted))
+            return false;
+        truncate_tail(valid_size);
+        log = std::fopen(path.c_str(), "ab");
+        if (!log)
+            return false;
+        for (const auto &r : journal)
+            absorb(r);
+        log_records = journal.size();
+        return true;
+    }
+
+    // отсортированная часть: mmap или копия в памяти
+    bool map_sorted(const uint64_t sorted)
+    {
+        base_count = size_t(sorted);
+        if (!sorted)
+            return true;
+#ifdef CHECKERS_LEARNING_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        mapping_size = sizeof(header) + size_t(sorted) * sizeof(record);
+        void *p = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+        {
+            mapping_size = 0;
+            return false;
+        }
+        mapping = p;
+        base = reinterpret_cast<const record *>(static_cast<const char *>(p) + sizeof(header));
+#else
+        std::ifstream fin(path, std::ios_base::binary);
+        base_copy.resize(size_t(sorted));
+        fin.seekg(std::streamoff(sizeof(header)));
+        if (!fin.read(reinterpret_cast<char *>(base_copy.data()), std::streamsize(sorted * sizeof(record))))
+            return false;
+        base = base_copy.data();
+#endif
+        return true;
+    }
+
+    // отбрасывает недописанную запись в конце файла, чтобы новые дельты не легли со сдвигом
+    void truncate_tail(const uint64_t valid_size)
+    {
+#ifdef CHECKERS_LEARNING_MMAP
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0 && uint64_t(st.st_size) > valid_size)
+            if (::truncate(path.c_str(), off_t(valid_size)) != 0)
+                return;
+#else
+        std::ifstream fin(path, std::ios_base::binary | std::ios_base::ate);
+        if (uint64_t(fin.tellg()) <= valid_size)
+            return;
+        std::vector<char> data(size_t(valid_size));
+        fin.seekg(0);
+        fin.read(data.data(), std::streamsize(data.size()));
+        fin.close();
+        std::ofstream fout(path, std::ios_base::binary | std::ios_base::trunc);
+        fout.write(data.data(), std::streamsize(data.size()));
+#endif
+    }
+
+    // данные нового файла — на диск до rename, чтобы после сбоя не остаться с пустым файлом
+    static void sync_file(const std::string &file)
+    {
+#ifdef CHECKERS_LEARNING_MMAP
+        const int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            fsync(fd);
+            ::close(fd);
+        }
+#else
+        (void)file;
+#endif
+    }
+
+    std::string path;
+    // журнал, открытый на дозапись
+    FILE *log = nullptr;
+    size_t log_records = 0;
+
+    // отсортированная часть файла
+    const record *base = nullptr;
+    size_t base_count = 0;
+#ifdef CHECKERS_LEARNING_MMAP
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+#endif
+    std::vector<record> base_copy;
+
+    // позиции из журнала — уже слитые с базой
+    std::unordered_map<uint64_t, record> recent;
+};
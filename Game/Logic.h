@@ -1,207 +1,875 @@
 #pragma once
+#include <cmath>
+#include <ctime>
+#include <functional>
+#include <memory>
 #include <random>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 
+#include "../Models/Analysis.h"
 #include "../Models/Move.h"
-#include "Board.h"
+#include "../Models/Score.h"
+#include "../Models/Trace.h"
+#include "../Models/Tree_dump.h"
+#include "Batch_eval.h"
 #include "Config.h"
+#include "Diagonals.h"
+#include "Nnue.h"
+#include "Profile.h"
+#include "Transposition.h"
+#include "Variant.h"
+#include "Weights.h"
+#include "Zobrist.h"
 
-const int INF = 1e9;
-
-class Logic
+/**
+ * Генератор ходов и поиск для варианта правил Rules (см. Variant.h) на доске Rules::size × Rules::size.
+ * Logic — русские шашки 8x8, ею пользуются инструменты (движок, сервер, тюнер, матчи).
+ */
+template <class Rules> class BasicLogic
 {
   public:
-    Logic(Board *board, Config *config) : board(board), config(config)
+    // клеток в ряду доски
+    static constexpr int N = Rules::size;
+
+    // начальная полуширина окна стремления (iterative_search) и его рост после промаха
+    static constexpr SCORE_T kAspirationWindow = SCORE_ONE / 16;
+    static constexpr int kAspirationGrowth = 4;
+
+    /**
+     * shared_tt — общая таблица транспозиций (несколько Logic в разных потоках, сервер движка);
+     * без неё создаётся своя размером "HashMB".
+     */
+    BasicLogic(Config *config, shared_ptr<TranspositionTable> shared_tt = nullptr)
+        : tt(shared_tt ? shared_tt : make_shared<TranspositionTable>((*config)("Bot", "HashMB"))), config(config)
     {
         rand_eng = std::default_random_engine (
             !((*config)("Bot", "NoRandom")) ? unsigned(time(0)) : 0);
         scoring_mode = (*config)("Bot", "BotScoringType");
         optimization = (*config)("Bot", "Optimization");
+        draw_plies = 2 * int((*config)("Game", "KingMovesDraw"));
+        if (scoring_mode == "NumberAndPotential")
+        {
+            const string weights_file = (*config)("Bot", "WeightsFile");
+            if (!weights.load(project_path + weights_file))
+            {
+                ofstream fout(project_path + "log.txt", ios_base::app);
+                fout << "Error: can't load weights from " << weights_file << ", using default weights\n";
+                fout.close();
+            }
+        }
+        batch_eval = BatchEval(weights, scoring_mode == "NumberAndPotential");
+        for (int r = 0; r < N; ++r)
+            man_value[r] = int32_t(scoring_mode == "NumberAndPotential"
+                                       ? lround(weights.man[r * 7 / (N - 1)] * BatchEval::kOne)
+                                       : BatchEval::kOne);
+        king_value = int32_t(scoring_mode == "NumberAndPotential" ? lround(weights.king * BatchEval::kOne)
+                                                                  : 4 * BatchEval::kOne);
+        if (scoring_mode == "NNUE" && N != 8)
+        {
+            ofstream fout(project_path + "log.txt", ios_base::app);
+            fout << "Error: NNUE network is trained for the 8x8 board, using material evaluation\n";
+            fout.close();
+        }
+        else if (scoring_mode == "NNUE")
+        {
+            const string nnue_file = (*config)("Bot", "NnueFile");
+            nnue = Nnue::load(project_path + nnue_file);
+            if (!nnue)
+            {
+                ofstream fout(project_path + "log.txt", ios_base::app);
+                fout << "Error: can't load network from " << nnue_file << ", using built-in material network\n";
+                fout.close();
+                nnue = Nnue::material();
+            }
+        }
+#ifdef CHECKERS_TREE_DUMP
+        const string tree_file = (*config)("Bot", "TreeDumpFile");
+        if (!tree_file.empty())
+        {
+            tree_dump = make_unique<SearchTreeWriter>(project_path + tree_file, N, (*config)("Bot", "TreeDumpNodes"));
+            if (!tree_dump->ok())
+            {
+                ofstream fout(project_path + "log.txt", ios_base::app);
+                fout << "Error: can't write search tree to " << tree_file << "\n";
+                fout.close();
+                tree_dump.reset();
+            }
+        }
+#endif
     }
 
-    vector<move_pos> find_best_turns(bool color) {
-    next_best_state.clear();
-    next_move.clear();
+    /**
+     * Находит лучший ход игрока цвета color в позиции mtx и возвращает его по прыжкам:
+     * серия взятий ищется как один ход, а прыжки нужны для анимации (Game::bot_turn).
+     */
+    vector<move_pos> find_best_turns(const bool color, const vector<vector<POS_T>> &mtx)
+    {
+        TRACE_SCOPE("Logic::find_best_turns");
+        start_search(color, mtx);
+        find_turns(color, mtx);
+        const auto turns_now = turns;
+        const uint64_t hash = zobrist.hash(mtx, color);
+        SCORE_T best_score = -1; // «худшая» стартовая оценка: любой ход, даже проигрыш loss_in(n), лучше
+        const move_pos *best = nullptr;
+        for (const auto &turn : turns_now)
+        {
+            cur_plies = plies_after(mtx, turn);
+            nnue_push(mtx, turn);
+            TREE_CHILD(tree_dump.get(), 0, turn, size_t(&turn - turns_now.data()), false);
+            const SCORE_T score = search_root_move(make_turn(mtx, turn), zobrist.after(hash, mtx, turn) ^ zobrist.side,
+                                                   !color, best != nullptr, best_score, INF + 1);
+            nnue_pop();
+            cur_plies = king_plies;
+            if (stopped)
+                break;
+            if (score > best_score)
+            {
+                best_score = score;
+                best = &turn;
+            }
+        }
+        last_score = best_score;
+        last_turn = (best ? *best : move_pos{-1, -1, -1, -1});
+        return best ? series_steps(mtx, *best) : vector<move_pos>{};
+    }
 
-    // корневое состояние = 0 (x=y=-1 означает "серия добиваний не начата")
-    find_first_best_turn(board->get_board(), color, -1, -1, /*state=*/0);
+    /**
+     * Multi-PV анализ: до n лучших ходов корня с главными вариантами и точными оценками,
+     * отсортированные от лучшего к худшему.
+     *
+     * Ходы корня (полные серии взятий) перебираются по очереди; каждый следующий ищется с окном
+     * alpha = оценка n-й лучшей линии на данный момент, поэтому ходы, не попадающие в n лучших,
+     * отсекаются дёшево. Таблица транспозиций общая для всех линий: совпадающие поддеревья
+     * не пересчитываются, а главные варианты восстанавливаются по лучшим ходам из неё.
+     *
+     * Окно (alpha, beta) — окно стремления iterative_search: линии не хуже alpha не попадают в результат,
+     * а ход с оценкой не ниже beta заканчивает поиск (его оценка — только нижняя граница).
+     * first — ход, который искать первым (лучший ход прошлой итерации углубления); без него — ход из таблицы.
+     * Лучший найденный ход корня — в last_turn.
+     */
+    vector<analysis_line> find_best_lines(const bool color, const vector<vector<POS_T>> &mtx, const size_t n,
+                                          const SCORE_T alpha = -1, const SCORE_T beta = INF + 1,
+                                          const move_pos &first = move_pos{-1, -1, -1, -1})
+    {
+        TRACE_SCOPE("Logic::find_best_lines");
+        start_search(color, mtx);
+        vector<analysis_line> lines;
+        if (n == 0)
+            return lines;
+        const uint64_t hash = zobrist.hash(mtx, color);
+        find_turns(color, mtx);
+        auto turns_now = turns;
+        // сначала — лучший ход предыдущего поиска из этой позиции (его записывает конец find_best_lines):
+        // в итеративном углублении — ход прошлой итерации, он задаёт хороший порог и окно стремления
+        const uint64_t root_key = hash ^ zobrist.root[root_color];
+        move_pos lead = first;
+        if (lead.x == -1)
+            if (auto e = tt->probe(root_key))
+                lead = e->move;
+        stable_partition(turns_now.begin(), turns_now.end(), [&](const move_pos &turn) { return turn == lead; });
+        move_pos best_turn{-1, -1, -1, -1};
+        for (const auto &turn : turns_now)
+        {
+            const auto after = make_turn(mtx, turn);
+            const uint64_t after_hash = zobrist.after(hash, mtx, turn) ^ zobrist.side;
+            cur_plies = plies_after(mtx, turn);
+            nnue_push(mtx, turn);
+            const SCORE_T threshold = max(alpha, lines.size() < n ? SCORE_T(-1) : lines.back().score);
+            TREE_CHILD(tree_dump.get(), 0, turn, size_t(&turn - turns_now.data()), false);
+            const SCORE_T score = search_root_move(after, after_hash, !color, !lines.empty(), threshold, beta);
+            nnue_pop();
+            cur_plies = king_plies;
+            if (stopped)
+                break;
+            if (score <= threshold)
+                continue;
+            analysis_line line;
+            line.score = score;
+            line.pv.push_back(series_steps(mtx, turn));
+            auto tail = principal_variation(after, after_hash, !color);
+            line.pv.insert(line.pv.end(), tail.begin(), tail.end());
+            auto pos = upper_bound(lines.begin(), lines.end(), score,
+                                   [](const SCORE_T value, const analysis_line &l) { return value > l.score; });
+            if (pos == lines.begin())
+                best_turn = turn;
+            lines.insert(pos, line);
+            if (lines.size() > n)
+                lines.pop_back();
+            if (score >= beta)
+                break;
+        }
+        // корень — на уровень выше узлов глубины 0 (ply = 0); прерванный поиск не записывается,
+        // промах вниз (линий нет) оставляет в таблице ход прошлой итерации
+        if (!stopped && !lines.empty())
+            tt->store(root_key, Max_depth + 1, score_to_tt(lines[0].score, 0),
+                      lines[0].score >= beta ? TranspositionTable::LOWER : TranspositionTable::EXACT, best_turn);
+        last_turn = best_turn;
+        return lines;
+    }
 
-    int cur = 0;
-    vector<move_pos> res;
-    while (cur != -1 && cur < (int)next_move.size() && next_move[cur].x != -1) {
-        res.push_back(next_move[cur]);
-        if (cur >= (int)next_best_state.size()) break;
-        cur = next_best_state[cur];
+    /**
+     * Итеративное углубление для внешних оболочек (checkers_engine, сервер): find_best_lines на глубинах
+     * 1..max_depth, после каждой законченной итерации — on_iteration(глубина, линии, узлы всего).
+     * Первая итерация выполняется без ограничений, чтобы ход был всегда; прерванная по stop_flag,
+     * node_budget или deadline итерация отбрасывается. early_exit — закончить раньше, если ход единственный
+     * или исход уже ясен. Возвращает линии последней законченной итерации.
+     *
+     * С одной линией (multipv = 1) итерация начинается с окна стремления вокруг оценки предыдущей:
+     * ход за пределами окна ищется заново с окном, расширенным в kAspirationGrowth раз в сторону промаха.
+     * Каждая итерация (и повторный поиск) начинается с лучшего хода корня предыдущей, а не со случайного
+     * после перемешивания find_turns: окно стремления и нулевые окна PVS проверяются против него.
+     */
+    vector<analysis_line> iterative_search(
+        const bool color, const vector<vector<POS_T>> &mtx, const size_t multipv, const int max_depth,
+        const uint64_t node_budget, const std::atomic<bool> *stop_flag, const bool early_exit,
+        const function<void(int, const vector<analysis_line> &, uint64_t)> &on_iteration = nullptr)
+    {
+        find_turns(color, mtx);
+        const bool single_move = (turns.size() == 1);
+        uint64_t total_nodes = 0;
+        vector<analysis_line> best;
+        move_pos best_turn{-1, -1, -1, -1};
+        const auto time_limit = deadline;
+        for (int depth = 1; depth <= max_depth; ++depth)
+        {
+            Max_depth = depth;
+            stop = (depth == 1 ? nullptr : stop_flag);
+            deadline = (depth == 1 ? chrono::steady_clock::time_point::max() : time_limit);
+            SCORE_T delta = kAspirationWindow;
+            const bool aspiration = (multipv == 1 && !best.empty() && optimization != "O0" && !is_win(best[0].score) &&
+                                     !is_loss(best[0].score));
+            SCORE_T alpha = (aspiration ? max<SCORE_T>(-1, best[0].score - delta) : -1);
+            SCORE_T beta = (aspiration ? min<SCORE_T>(INF + 1, best[0].score + delta) : INF + 1);
+            vector<analysis_line> lines;
+            while (true)
+            {
+                node_limit = (depth == 1 || !node_budget) ? 0
+                                                          : max<uint64_t>(1, node_budget - min(node_budget, total_nodes));
+                lines = find_best_lines(color, mtx, multipv, alpha, beta, best_turn);
+                total_nodes += nodes;
+                if (aborted())
+                    break;
+                // после промаха вверх первым ищется ход, давший его
+                if (!lines.empty())
+                    best_turn = last_turn;
+                // промах вниз — все ходы не лучше alpha, вверх — ход не хуже beta
+                const bool fail_low = (lines.empty() && alpha > -1), fail_high = (!lines.empty() && lines[0].score >= beta);
+                if (!fail_low && !fail_high)
+                    break;
+                delta = SCORE_T(min<int64_t>(int64_t(delta) * kAspirationGrowth, INF));
+                if (fail_low)
+                    alpha = (delta >= INF ? -1 : max<SCORE_T>(-1, alpha - delta));
+                else
+                    beta = (delta >= INF ? INF + 1 : SCORE_T(min<int64_t>(INF + 1, int64_t(beta) + delta)));
+            }
+            if (aborted())
+                break;
+            best = std::move(lines);
+            if (on_iteration)
+                on_iteration(depth, best, total_nodes);
+            const bool decided = best.empty() || single_move || is_win(best[0].score) || is_loss(best[0].score);
+            if ((early_exit && decided) || (stop_flag && stop_flag->load()) ||
+                (node_budget && total_nodes >= node_budget) || chrono::steady_clock::now() >= time_limit)
+                break;
+        }
+        stop = nullptr;
+        node_limit = 0;
+        deadline = time_limit;
+        nodes = total_nodes;
+        return best;
     }
-    return res;
+
+    /**
+     * Ход по профилю сложности (Profile.h) по прыжкам, как у find_best_turns.
+     * Итеративное углубление идёт, пока хватает profile.nodes узлов: бюджет жёсткий, включая первую
+     * итерацию (если её прервали, выбор — среди досчитанных ходов корня, если их нет — случайный ход).
+     * При шуме оценки ищутся все ходы корня (multi-PV), и к каждой оценке, кроме выигрыша и проигрыша,
+     * добавляется шум; с вероятностью profile.blunder вместо найденного ходится случайный другой ход.
+     */
+    vector<move_pos> find_profile_turns(const bool color, const vector<vector<POS_T>> &mtx, const search_profile &profile)
+    {
+        TRACE_SCOPE("Logic::find_profile_turns");
+        find_turns(color, mtx);
+        const auto turns_now = turns;
+        last_turn = move_pos{-1, -1, -1, -1};
+        if (turns_now.empty())
+            return {};
+        const size_t multipv = (profile.noise > 0 ? turns_now.size() : 1);
+        vector<analysis_line> best;
+        uint64_t total_nodes = 0;
+        move_pos lead{-1, -1, -1, -1};
+        last_depth = 0;
+        for (int depth = 1; depth < MAX_PLY && turns_now.size() > 1 && total_nodes < profile.nodes; ++depth)
+        {
+            Max_depth = depth;
+            node_limit = profile.nodes - total_nodes;
+            auto lines = find_best_lines(color, mtx, multipv, -1, INF + 1, lead);
+            total_nodes += nodes;
+            if (aborted())
+            {
+                if (best.empty())
+                {
+                    best = std::move(lines);
+                    last_depth = depth;
+                }
+                break;
+            }
+            best = std::move(lines);
+            last_depth = depth;
+            lead = last_turn;
+            if (best.empty() || is_win(best[0].score) || is_loss(best[0].score))
+                break;
+        }
+        node_limit = 0;
+        nodes = total_nodes;
+
+        move_pos chosen = turns_now[rand_eng() % turns_now.size()];
+        last_score = DRAW;
+        normal_distribution<double> noise(0, profile.noise * SCORE_ONE);
+        double best_noisy = -1;
+        for (const auto &line : best)
+        {
+            const double noisy = (profile.noise > 0 && !is_win(line.score) && !is_loss(line.score)
+                                      ? clamp_score(llround(line.score + noise(rand_eng)))
+                                      : line.score);
+            if (noisy > best_noisy)
+            {
+                best_noisy = noisy;
+                last_score = line.score;
+                chosen = *find_if(turns_now.begin(), turns_now.end(), [&](const move_pos &turn) {
+                    return series_steps(mtx, turn) == line.pv[0];
+                });
+            }
+        }
+        if (turns_now.size() > 1 && uniform_real_distribution<double>(0, 1)(rand_eng) < profile.blunder)
+        {
+            size_t k = rand_eng() % (turns_now.size() - 1);
+            if (turns_now[k] == chosen)
+                k = turns_now.size() - 1;
+            chosen = turns_now[k];
+        }
+        last_turn = chosen;
+        return series_steps(mtx, chosen);
     }
 
+    /**
+     * Находит полную серию ходов стороны color, записанную клетками cells (см. parse_series):
+     * первая и последняя клетки — начало и конец серии, промежуточные (если указаны) идут по пути
+     * в том же порядке. Пустой результат — такого хода нет.
+     */
+    vector<move_pos> resolve_series(const bool color, const vector<vector<POS_T>> &mtx,
+                                    const vector<pair<POS_T, POS_T>> &cells)
+    {
+        if (cells.size() < 2)
+            return {};
+        for (const auto &s : find_series(color, mtx))
+        {
+            if (s[0].x != cells[0].first || s[0].y != cells[0].second || s.back().x2 != cells.back().first ||
+                s.back().y2 != cells.back().second)
+                continue;
+            size_t matched = 1;
+            for (const auto &turn : s)
+                if (matched + 1 < cells.size() && turn.x2 == cells[matched].first && turn.y2 == cells[matched].second)
+                    ++matched;
+            if (matched + 1 == cells.size())
+                return s;
+        }
+        return {};
+    }
+
+    /**
+     * Все ходы стороны color по прыжкам: серия взятий — каждым путём, которым её можно сыграть
+     * (игрок выбирает прыжки по одному, запись хода может указать промежуточные клетки),
+     * тихий ход — серия из одного хода. Допустимы те же ходы, что в find_turns.
+     */
+    vector<vector<move_pos>> find_series(const bool color, const vector<vector<POS_T>> &mtx)
+    {
+        find_turns(color, mtx);
+        vector<vector<move_pos>> res;
+        if (!have_beats)
+        {
+            for (const auto &turn : turns)
+                res.push_back({turn});
+            return res;
+        }
+        for (POS_T i = 0; i < N; ++i)
+        {
+            for (POS_T j = 0; j < N; ++j)
+            {
+                if (!mtx[i][j] || mtx[i][j] % 2 == color)
+                    continue;
+                capture_series(mtx, i, j, [&](const move_pos &turn) {
+                    if (find(turns.begin(), turns.end(), turn) != turns.end())
+                        res.push_back(series_path);
+                });
+            }
+        }
+        return res;
+    }
+
+    /**
+     * Ход turn стороны, которая ходит в позиции mtx, по прыжкам (один из путей серии взятий);
+     * тихий ход — сам turn.
+     */
+    vector<move_pos> series_steps(const vector<vector<POS_T>> &mtx, const move_pos &turn)
+    {
+        if (turn.xb == -1)
+            return {turn};
+        vector<move_pos> steps;
+        capture_series(mtx, turn.x, turn.y, [&](const move_pos &series) {
+            if (steps.empty() && series == turn)
+                steps = series_path;
+        });
+        return steps;
+    }
+
+    /**
+     * Статическая оценка позиции mtx за сторону color, без поиска: в шкале поиска (отношение сил в Q16,
+     * выигрыш / проигрыш, если у соперника / у color нет фигур). Ею MCTS оценивает разыгрывания.
+     */
+    SCORE_T evaluate(const vector<vector<POS_T>> &mtx, const bool color)
+    {
+        if (nnue)
+            acc_stack.assign(1, nnue->refresh(mtx));
+        return calc_score(mtx, color, 0);
+    }
+
+    /**
+     * true, если последний поиск прерван по stop, node_limit или deadline
+     * (результат такого поиска неполный и использоваться не должен).
+     */
+    bool aborted() const
+    {
+        return stopped;
+    }
+
+    /**
+     * true, если переход от позиции before к after — ход дамкой без взятия
+     * (такие ходы считает правило ничьей "KingMovesDraw").
+     */
+    static bool is_king_move(const vector<vector<POS_T>> &before, const vector<vector<POS_T>> &after)
+    {
+        int count_before = 0, count_after = 0;
+        for (POS_T i = 0; i < N; ++i)
+        {
+            for (POS_T j = 0; j < N; ++j)
+            {
+                // шашка ушла, пришла или превратилась в дамку
+                if ((before[i][j] == 1 || before[i][j] == 2 || after[i][j] == 1 || after[i][j] == 2) &&
+                    before[i][j] != after[i][j])
+                    return false;
+                count_before += (before[i][j] != 0);
+                count_after += (after[i][j] != 0);
+            }
+        }
+        return count_before == count_after;
+    }
 
-private:
     /**
      * Выполняет ход на копии матрицы доски и возвращает новое состояние.
-     * Удаляет побитую фигуру (если xb/yb != -1),
+     * Снимает побитые фигуры (turn.captured — вся серия взятий или один прыжок),
      * перемещает шашку или дамку на новую позицию,
-     * при необходимости превращает шашку в дамку.
+     * превращает шашку в дамку, если turn.crown.
      *
      * @param mtx  — исходное состояние доски
-     * @param turn — структура с координатами хода
+     * @param turn — ход (см. move_pos)
      * @return новое состояние доски после применения хода
      */
-    vector<vector<POS_T>> make_turn(vector<vector<POS_T>> mtx, move_pos turn) const
+    vector<vector<POS_T>> make_turn(vector<vector<POS_T>> mtx, const move_pos &turn) const
     {
-        if (turn.xb != -1)
-            mtx[turn.xb][turn.yb] = 0;
-        if ((mtx[turn.x][turn.y] == 1 && turn.x2 == 0) || (mtx[turn.x][turn.y] == 2 && turn.x2 == 7))
-            mtx[turn.x][turn.y] += 2;
-        mtx[turn.x2][turn.y2] = mtx[turn.x][turn.y];
+        for_each_square<N>(turn.captured, [&](const POS_T i, const POS_T j) { mtx[i][j] = 0; });
+        // дамка может закончить серию на той же клетке, с которой начала
+        const POS_T type = mtx[turn.x][turn.y];
         mtx[turn.x][turn.y] = 0;
+        mtx[turn.x2][turn.y2] = POS_T(type + (turn.crown ? 2 : 0));
         return mtx;
     }
 
+private:
     /**
      * Вычисляет «оценку позиции» для бота.
      * Используется как функция оценки (heuristic) в алгоритме поиска.
      *
      * Алгоритм:
      *  - считаем количество белых/чёрных шашек и дамок;
-     *  - при режиме "NumberAndPotential" добавляем небольшой бонус
-     *    за продвижение шашек вперёд (потенциал превращения в дамку);
-     *  - если у соперника фигур не осталось — возвращаем INF (выигрыш);
-     *  - если у бота фигур не осталось — возвращаем 0 (проигрыш);
-     *  - в противном случае возвращаем отношение силы соперника к силе бота
-     *    (меньшее — лучше для бота).
+     *  - при режиме "NumberAndPotential" шашка стоит weights.man[r], где r —
+     *    на сколько рядов она продвинулась (потенциал превращения в дамку),
+     *    а дамка — weights.king; веса читаются из файла "WeightsFile";
+     *  - если у соперника фигур не осталось — выигрыш через ply полуходов;
+     *  - если у бота фигур не осталось — проигрыш через ply полуходов;
+     *  - в противном случае возвращаем отношение силы бота к силе соперника
+     *    в Q16 (большее — лучше для бота), см. Models/Score.h.
+     * Считается в фиксированной точке через BatchEval — так же, как пакетная
+     * оценка листьев в eval_children, чтобы оценки обоих путей совпадали.
      *
      * @param mtx             — текущее состояние доски
      * @param first_bot_color — цвет, которым играет бот
-     * @return числовая оценка позиции (чем меньше, тем лучше для бота)
+     * @param ply             — полуходов от корня до позиции
+     * @return целочисленная оценка позиции (чем больше, тем лучше для бота)
      */
-    double calc_score(const vector<vector<POS_T>> &mtx, const bool first_bot_color) const
+    SCORE_T calc_score(const vector<vector<POS_T>> &mtx, const bool first_bot_color, const int ply) const
     {
+        if (nnue)
+            return calc_nnue_score(mtx, first_bot_color, ply);
         // color - who is max player
-        double w = 0, wq = 0, b = 0, bq = 0;
-        for (POS_T i = 0; i < 8; ++i)
+        if constexpr (N == 8)
+        {
+            uint32_t wm, wk, bm, bk;
+            BatchEval::pack(mtx, wm, wk, bm, bk);
+            return leaf_score(batch_eval.evaluate(wm, wk, bm, bk, first_bot_color), ply);
+        }
+        else
+            return leaf_score(material_q16(mtx, first_bot_color), ply);
+    }
+
+    /**
+     * Отношение сил в Q16 по формуле BatchEval для досок, где пакетной оценки нет (она — по маскам 8x8):
+     * шашка стоит man_value[продвижение], дамка — king_value.
+     */
+    int64_t material_q16(const vector<vector<POS_T>> &mtx, const bool first_bot_color) const
+    {
+        int64_t white = 0, black = 0;
+        for (POS_T i = 0; i < N; ++i)
         {
-            for (POS_T j = 0; j < 8; ++j)
+            for (POS_T j = 0; j < N; ++j)
             {
-                w += (mtx[i][j] == 1);
-                wq += (mtx[i][j] == 3);
-                b += (mtx[i][j] == 2);
-                bq += (mtx[i][j] == 4);
-                if (scoring_mode == "NumberAndPotential")
+                switch (mtx[i][j])
                 {
-                    w += 0.05 * (mtx[i][j] == 1) * (7 - i);
-                    b += 0.05 * (mtx[i][j] == 2) * (i);
+                case 1: white += man_value[N - 1 - i]; break;
+                case 2: black += man_value[i]; break;
+                case 3: white += king_value; break;
+                case 4: black += king_value; break;
+                default: break;
                 }
             }
         }
-        if (!first_bot_color)
+        const int64_t num = (first_bot_color ? black : white), den = (first_bot_color ? white : black);
+        if (den == 0)
+            return BatchEval::INF_Q16;
+        if (num == 0)
+            return 0;
+        return (num << BatchEval::kShift) / den;
+    }
+
+    /**
+     * Отношение сил BatchEval (Q16) в шкале поиска: 0 и INF_Q16 (у бота или у соперника
+     * нет фигур) — проигрыш и выигрыш через ply полуходов.
+     */
+    static SCORE_T leaf_score(const int64_t q16, const int ply)
+    {
+        if (q16 == 0)
+            return loss_in(ply);
+        if (q16 >= BatchEval::INF_Q16)
+            return win_in(ply);
+        return clamp_score(q16);
+    }
+
+    /**
+     * Оценивает всех детей узла предпоследнего уровня одним пакетом (см. BatchEval):
+     * дети — позиции после тихих ходов turns из mtx, собранные из масок родителя.
+     * Результат (Q16) — в leaf_scores в том же порядке, что и turns.
+     */
+    void eval_children(const vector<vector<POS_T>> &mtx, const vector<move_pos> &turns, const bool first_bot_color)
+    {
+        uint32_t wm, wk, bm, bk;
+        BatchEval::pack(mtx, wm, wk, bm, bk);
+        children.clear();
+        for (const auto &turn : turns)
         {
-            swap(b, w);
-            swap(bq, wq);
+            const uint32_t from = 1u << (turn.x * 4 + turn.y / 2), to = 1u << (turn.x2 * 4 + turn.y2 / 2);
+            uint32_t cwm = wm, cwk = wk, cbm = bm, cbk = bk;
+            if (wm & from)
+            {
+                cwm ^= from;
+                (turn.crown ? cwk : cwm) |= to;
+            }
+            else if (bm & from)
+            {
+                cbm ^= from;
+                (turn.crown ? cbk : cbm) |= to;
+            }
+            else if (wk & from)
+                cwk ^= from | to;
+            else
+                cbk ^= from | to;
+            children.push(cwm, cwk, cbm, cbk);
         }
-        if (w + wq == 0)
-            return INF;
-        if (b + bq == 0)
-            return 0;
-        int q_coef = 4;
-        if (scoring_mode == "NumberAndPotential")
+        batch_eval.evaluate(children, first_bot_color, leaf_scores);
+    }
+
+    /**
+     * Оценка позиции нейросетью (режим "NNUE") в той же шкале, что и calc_score:
+     * проигрыш / выигрыш через ply, если у бота / соперника нет фигур, иначе
+     * exp от оценки сети в Q16, растущая вместе с преимуществом бота.
+     * Аккумулятор берётся с вершины acc_stack — он уже обновлён по пути поиска.
+     */
+    SCORE_T calc_nnue_score(const vector<vector<POS_T>> &mtx, const bool first_bot_color, const int ply) const
+    {
+        bool has_white = false, has_black = false;
+        for (POS_T i = 0; i < N; ++i)
         {
-            q_coef = 5;
+            for (POS_T j = 0; j < N; ++j)
+            {
+                has_white |= (mtx[i][j] % 2 == 1);
+                has_black |= (mtx[i][j] && mtx[i][j] % 2 == 0);
+            }
         }
-        return (b + bq * q_coef) / (w + wq * q_coef);
+        if (!first_bot_color)
+            swap(has_white, has_black);
+        if (!has_white)
+            return win_in(ply);
+        if (!has_black)
+            return loss_in(ply);
+        const double eval = nnue->evaluate(acc_stack.back());
+        return clamp_score(llround(min(exp((first_bot_color ? -eval : eval) / 1000.0), 1e4) * SCORE_ONE));
     }
 
-    double find_first_best_turn(vector<vector<POS_T>> mtx, const bool color, const POS_T x, const POS_T y, size_t state,
-                                double alpha = -1)
+    /**
+     * Инкрементально обновляет аккумулятор сети на ход turn перед спуском в поддерево.
+     * Парный вызов nnue_pop() — после возврата из поддерева (отмена хода).
+     */
+    void nnue_push(const vector<vector<POS_T>> &mtx, const move_pos &turn)
     {
-        // регистрируем узел в восстановителе
-        next_best_state.push_back(-1);
-        next_move.emplace_back(-1, -1, -1, -1);
+        if (!nnue)
+            return;
+        Nnue::Accumulator acc = acc_stack.back();
+        nnue->update(acc, mtx, turn);
+        acc_stack.push_back(acc);
+    }
 
-        double best_score = -1; // «худшая» стартовая оценка (мы минимизируем через calc_score, см. ниже)
+    void nnue_pop()
+    {
+        if (nnue)
+            acc_stack.pop_back();
+    }
 
-        // если state != 0, значит это продолжение серии взятий и нужно искать ходы из (x,y)
-        if (state != 0) {
-            find_turns(x, y, mtx);
-        }
-        auto turns_now = turns;
-        bool have_beats_now = have_beats;
+    /**
+     * Проверка ограничений поиска; после срабатывания все узлы сразу возвращаются.
+     */
+    bool limit_reached()
+    {
+        if (!stopped)
+            stopped = (node_limit && nodes >= node_limit) || (stop && stop->load(std::memory_order_relaxed)) ||
+                      (!(nodes & 1023) && chrono::steady_clock::now() >= deadline);
+        return stopped;
+    }
 
-        // если ходы с взятием закончились, серия завершилась — передаём ход оппоненту
-        if (!have_beats_now && state != 0) {
-            return find_best_turns_rec(mtx, /*color=*/!color, /*depth=*/0, alpha);
-        }
+    /**
+     * Ничья в узле с хешем hash: сработало правило ходов дамками или позиция уже была
+     * (в партии или выше по пути поиска). Повториться может только позиция,
+     * сыгранная после последнего хода шашкой или взятия, — их cur_plies последних.
+     */
+    bool is_draw(const uint64_t hash) const
+    {
+        if (draw_plies && cur_plies >= draw_plies)
+            return true;
+        for (size_t k = search_path.size(), n = 0; k-- > 0 && n < size_t(cur_plies); ++n)
+            if (search_path[k] == hash)
+                return true;
+        return false;
+    }
 
-        for (const auto& turn : turns_now) {
-            size_t child_state = next_move.size();
+    /**
+     * Счётчик полуходов дамками после хода turn из позиции mtx: сбрасывается ходом шашки и взятием.
+     */
+    int plies_after(const vector<vector<POS_T>> &mtx, const move_pos &turn) const
+    {
+        return (turn.xb != -1 || mtx[turn.x][turn.y] < 3) ? 0 : cur_plies + 1;
+    }
 
-            double score;
-            if (have_beats_now) {
-                // продолжаем серию: игрок не меняется, фиксируем текущую фигуру (x2,y2)
-                score = find_first_best_turn(make_turn(mtx, turn), color,
-                                            turn.x2, turn.y2, child_state, best_score);
-            } else {
-                // обычный ход: меняем сторону и запускаем minimax с глубины 0
-                score = find_best_turns_rec(make_turn(mtx, turn), /*color=*/!color,
-                                            /*depth=*/0, /*alpha=*/best_score);
-            }
+    /**
+     * Подготовка к новому поиску за цвет color из позиции mtx.
+     */
+    void start_search(const bool color, const vector<vector<POS_T>> &mtx)
+    {
+        root_color = color;
+        nodes = 0;
+        stopped = false;
+        TREE_SEARCH(tree_dump.get(), color, Max_depth);
+        search_path = history;
+        search_path.push_back(zobrist.hash(mtx, color));
+        cur_plies = king_plies;
+        if (nnue)
+        {
+            acc_stack.clear();
+            acc_stack.push_back(nnue->refresh(mtx));
+        }
+    }
 
-            if (score > best_score) {
-                best_score = score;
-                next_move[state] = turn;
-                next_best_state[state] = (have_beats_now ? (int)child_state : -1);
-            }
+    /**
+     * Главный вариант из позиции mtx (ходит color) по лучшим ходам из таблицы транспозиций.
+     * Каждый элемент — ход одной стороны по прыжкам (см. series_steps).
+     */
+    vector<vector<move_pos>> principal_variation(vector<vector<POS_T>> mtx, uint64_t hash, bool color)
+    {
+        vector<vector<move_pos>> pv;
+        for (int depth = 0; depth < Max_depth; ++depth)
+        {
+            const auto e = tt->probe(hash ^ zobrist.root[root_color]);
+            find_turns(color, mtx);
+            const auto it = (e ? find(turns.begin(), turns.end(), e->move) : turns.end());
+            if (it == turns.end())
+                break;
+            const move_pos turn = *it;
+            pv.push_back(series_steps(mtx, turn));
+            hash = zobrist.after(hash, mtx, turn) ^ zobrist.side;
+            mtx = make_turn(mtx, turn);
+            color = !color;
+        }
+        return pv;
+    }
+
+    /**
+     * Оценка хода корня, после которого позиция mtx (ходит color), в окне (alpha, beta).
+     * Если лучший ход уже есть (has_best), ход сначала проверяется нулевым окном (alpha, alpha + 1) —
+     * обычно он не лучше, и поддерево отсекается дёшево; иначе и при «лучше» — поиск с окном (alpha, beta).
+     */
+    SCORE_T search_root_move(const vector<vector<POS_T>> &mtx, const uint64_t hash, const bool color, const bool has_best,
+                             const SCORE_T alpha, const SCORE_T beta)
+    {
+        if (has_best && optimization != "O0" && beta - alpha > 1)
+        {
+            const SCORE_T score = find_best_turns_rec(mtx, hash, color, 0, alpha, alpha + 1);
+            if (stopped || score <= alpha || score >= beta)
+                return score;
+            TREE_RESEARCH(tree_dump.get(), 0);
         }
-        return best_score;
+        return find_best_turns_rec(mtx, hash, color, 0, alpha, beta);
     }
 
-    double find_best_turns_rec(vector<vector<POS_T>> mtx, const bool color, const size_t depth, double alpha = -1,
-                               double beta = INF + 1, const POS_T x = -1, const POS_T y = -1)
+    SCORE_T find_best_turns_rec(const vector<vector<POS_T>> &mtx, const uint64_t hash, const bool color, const size_t depth,
+                                SCORE_T alpha = -1, SCORE_T beta = INF + 1)
     {
+        // запись узла в дамп дерева (только со сборкой CHECKERS_TREE_DUMP)
+        TREE_NODE(tree_dump.get(), depth, alpha, beta);
+        // лимит проверяется до счёта узла: узел, который уже не ищется, в бюджет не входит
+        // (пакет листьев может довести nodes ровно до node_limit)
+        if (limit_reached())
+            return TREE_RETURN(ABORTED, 0);
+        ++nodes;
+
+        // повторение позиции или правило ходов дамками: ничья, поддерево не просматриваем
+        if (is_draw(hash))
+            return TREE_RETURN(DRAW, DRAW);
+
+        // полуходов от корня до узла: корень делает первый, узел глубины 0 — после него
+        const int ply = int(depth) + 1;
+
         // ограничение по глубине
         if (depth == (size_t)Max_depth) {
             // first_bot_color = (depth % 2 == color) — кто сейчас «максимизатор»
-            return calc_score(mtx, (depth % 2 == (size_t)color));
+            return TREE_RETURN(LEAF, calc_score(mtx, (depth % 2 == (size_t)color), ply));
         }
 
-        // генерируем ходы: либо для конкретной фигуры, либо все ходы цвета
-        if (x != -1) {
-            find_turns(x, y, mtx);
-        } else {
-            find_turns(color, mtx);
+        // отсечение по расстоянию до конца партии: из узла нельзя выиграть быстрее, чем через ply
+        // полуходов, и проиграть раньше; если окно вне этих пределов, поддерево ничего не изменит
+        if (optimization != "O0") {
+            if (win_in(ply) <= alpha)
+                return TREE_RETURN(MATE_PRUNE, win_in(ply));
+            if (loss_in(ply) >= beta)
+                return TREE_RETURN(MATE_PRUNE, loss_in(ply));
         }
-        auto turns_now = turns;
-        bool have_beats_now = have_beats;
 
-        // если продолжаем серию, но ударов нет — серия закончена, меняем сторону и увеличиваем глубину
-        if (!have_beats_now && x != -1) {
-            return find_best_turns_rec(mtx, !color, depth + 1, alpha, beta);
+        // таблица транспозиций: оценка той же оставшейся глубины может сразу закрыть узел
+        // (более глубокие оценки не подставляем — результат должен совпадать с поиском на Max_depth)
+        const uint64_t key = hash ^ zobrist.root[root_color];
+        const int remaining = Max_depth - int(depth);
+        const auto entry = tt->probe(key);
+        if (entry && entry->depth == remaining) {
+            const SCORE_T tt_score = score_from_tt(entry->score, ply);
+            if (entry->flag == TranspositionTable::EXACT ||
+                (entry->flag == TranspositionTable::LOWER && tt_score >= beta) ||
+                (entry->flag == TranspositionTable::UPPER && tt_score <= alpha))
+                return TREE_RETURN(TT, tt_score);
         }
 
+        // генерируем ходы цвета (серия взятий — один ход)
+        find_turns(color, mtx);
+        auto turns_now = turns;
+        bool have_beats_now = have_beats;
+
         // терминальный узел: ходов совсем нет
         if (turns_now.empty()) {
-            // если ходить некому — мат. Для MAX (depth%2==color) это 0, для MIN — INF
-            return (depth % 2 ? 0 : INF);
+            // ходить нечем — проигрыш стороны хода через ply полуходов: на MAX-уровне это бот, на MIN — соперник
+            return TREE_RETURN(NO_MOVES, (depth % 2 ? loss_in(ply) : win_in(ply)));
+        }
+
+        // лучший ход из таблицы пробуем первым
+        if (entry) {
+            auto it = find(turns_now.begin(), turns_now.end(), entry->move);
+            if (it != turns_now.end())
+                rotate(turns_now.begin(), it, it + 1);
         }
 
-        double best_min = INF + 1; // для MIN-уровней
-        double best_max = -1;      // для MAX-уровней
+        // позиция узла — на пути поиска (для повторений ниже)
+        search_path.push_back(hash);
 
-        for (const auto& turn : turns_now) {
-            double score;
-            if (!have_beats_now && x == -1) {
-                // обычный ход: меняем сторону, увеличиваем глубину
-                score = find_best_turns_rec(make_turn(mtx, turn), !color, depth + 1, alpha, beta);
+        const SCORE_T alpha_start = alpha, beta_start = beta;
+        SCORE_T best_min = INF + 1; // для MIN-уровней
+        SCORE_T best_max = -1;      // для MAX-уровней
+        move_pos best_turn = turns_now[0];
+
+        // предпоследний уровень: после тихого хода все дети — листья, оцениваем их одним пакетом
+        // (пакетная оценка — по маскам доски 8x8); пакет, не влезающий в лимит узлов, не собираем —
+        // листья по одному останавливаются точно на лимите
+        const bool batch_leaves = (N == 8 && !nnue && !have_beats_now && depth + 1 == (size_t)Max_depth &&
+                                   (!node_limit || nodes + turns_now.size() <= node_limit));
+        if (batch_leaves) {
+            eval_children(mtx, turns_now, ((depth + 1) % 2 == (size_t)!color));
+            nodes += turns_now.size();
+        }
+
+        for (size_t k = 0; k < turns_now.size(); ++k) {
+            const auto& turn = turns_now[k];
+            SCORE_T score;
+            const int plies_before = cur_plies;
+            cur_plies = plies_after(mtx, turn);
+            nnue_push(mtx, turn);
+            if (batch_leaves) {
+                score = leaf_score(leaf_scores[k], ply + 1);
+                if (cur_plies && is_draw(zobrist.after(hash, mtx, turn) ^ zobrist.side))
+                    score = DRAW;
+                TREE_LEAF(tree_dump.get(), turn, k, depth + 1, alpha, beta, score);
             } else {
-                // продолжение серии взятий: ход остаётся за той же стороной, глубина не растёт
-                score = find_best_turns_rec(make_turn(mtx, turn), color, depth, alpha, beta, turn.x2, turn.y2);
+                // ход (тихий или вся серия взятий): меняем сторону, увеличиваем глубину
+                const auto child = make_turn(mtx, turn);
+                const uint64_t child_hash = zobrist.after(hash, mtx, turn) ^ zobrist.side;
+                if (k > 0 && optimization != "O0" && beta - alpha > 1) {
+                    // PVS: первый ход (из таблицы) — главный вариант, остальные сначала только проверяем
+                    // нулевым окном у своей границы: на MAX-уровне «лучше alpha?», на MIN-уровне «хуже beta?»;
+                    // точная оценка нужна, лишь если ответ «да» и оценка внутри окна
+                    const SCORE_T bound = (depth % 2 ? alpha : beta - 1);
+                    TREE_CHILD(tree_dump.get(), depth + 1, turn, k, false);
+                    score = find_best_turns_rec(child, child_hash, !color, depth + 1, bound, bound + 1);
+                    if (!stopped && score > alpha && score < beta) {
+                        TREE_CHILD(tree_dump.get(), depth + 1, turn, k, true);
+                        score = find_best_turns_rec(child, child_hash, !color, depth + 1, alpha, beta);
+                    }
+                } else {
+                    TREE_CHILD(tree_dump.get(), depth + 1, turn, k, false);
+                    score = find_best_turns_rec(child, child_hash, !color, depth + 1, alpha, beta);
+                }
+            }
+            nnue_pop();
+            cur_plies = plies_before;
+            // поиск прерван: оценка неполная, в таблицу её не пишем
+            if (stopped) {
+                search_path.pop_back();
+                return TREE_RETURN(ABORTED, 0);
             }
 
             // обновляем экстремумы
-            if (score < best_min) best_min = score;
-            if (score > best_max) best_max = score;
+            if (score < best_min) {
+                best_min = score;
+                if (!(depth % 2)) best_turn = turn;
+            }
+            if (score > best_max) {
+                best_max = score;
+                if (depth % 2) best_turn = turn;
+            }
 
             // depth % 2 == 1 → MAX-уровень (обновляем alpha),
             // depth % 2 == 0 → MIN-уровень (обновляем beta).
@@ -212,42 +880,35 @@ private:
             }
 
             if (optimization != "O0" && alpha >= beta) {
-                // лёгкая «сдвижка» для стабильности выбора при равенствах
-                return (depth % 2 ? best_max + 1 : best_min - 1);
+                // отсечение: возвращаем саму границу без «сдвижки» на ±1 — сохранённая в таблице
+                // граница должна быть верной и для других окон; при равенствах корень всё равно
+                // выбирает ход строгим сравнением
+                const SCORE_T bound = (depth % 2 ? best_max : best_min);
+                search_path.pop_back();
+                tt->store(key, remaining, score_to_tt(bound, ply),
+                         (depth % 2 ? TranspositionTable::LOWER : TranspositionTable::UPPER), best_turn);
+                return TREE_RETURN_MOVES(NODE, bound, turns_now, best_turn, long(k));
             }
         }
 
         // выбираем, что вернуть, в зависимости от уровня (MIN/ MAX)
-        return (depth % 2 ? best_max : best_min);
+        search_path.pop_back();
+        const SCORE_T best = (depth % 2 ? best_max : best_min);
+        uint8_t flag = TranspositionTable::EXACT;
+        if (depth % 2 && best <= alpha_start)
+            flag = TranspositionTable::UPPER;
+        else if (!(depth % 2) && best >= beta_start)
+            flag = TranspositionTable::LOWER;
+        tt->store(key, remaining, score_to_tt(best, ply), flag, best_turn);
+        return TREE_RETURN_MOVES(NODE, best, turns_now, best_turn, -1);
     }
 
 public:
-    /**
-     * Находит все возможные ходы для игрока заданного цвета.
-     * Использует текущее состояние доски из объекта Board.
-     *
-     * @param color — цвет игрока (0 = белые, 1 = чёрные)
-     */
-    void find_turns(const bool color)
-    {
-        find_turns(color, board->get_board());
-    }
-    /**
-     * Находит все возможные ходы для фигуры в клетке (x, y).
-     * Использует текущее состояние доски из объекта Board.
-     *
-     * @param x — координата по вертикали (строка)
-     * @param y — координата по горизонтали (столбец)
-     */
-    void find_turns(const POS_T x, const POS_T y)
-    {
-        find_turns(x, y, board->get_board());
-    }
-
-private:
     /**
      * Находит все возможные ходы для игрока заданного цвета на основе переданной матрицы.
-     * Сначала проверяет наличие ударов (beats). Если удары есть, то остальные ходы не рассматриваются.
+     * Сначала проверяет наличие ударов (beats). Если удары есть, то остальные ходы не рассматриваются;
+     * каждая серия взятий — один ход (см. capture_series), серии с одинаковым результатом — один раз;
+     * в международных шашках остаются только серии с наибольшим числом взятых фигур.
      * Результат перемешивается (shuffle) для случайности.
      *
      * @param color — цвет игрока (0 = белые, 1 = чёрные)
@@ -255,133 +916,197 @@ private:
      */
     void find_turns(const bool color, const vector<vector<POS_T>> &mtx)
     {
-        vector<move_pos> res_turns;
-        bool have_beats_before = false;
-        for (POS_T i = 0; i < 8; ++i)
+        turns.clear();
+        have_beats = false;
+        for (POS_T i = 0; i < N; ++i)
         {
-            for (POS_T j = 0; j < 8; ++j)
+            for (POS_T j = 0; j < N; ++j)
             {
-                if (mtx[i][j] && mtx[i][j] % 2 != color)
+                if (!mtx[i][j] || mtx[i][j] % 2 == color)
+                    continue;
+                const size_t begin = turns.size();
+                const bool beats = piece_turns(i, j, mtx, turns);
+                if (beats && !have_beats)
                 {
-                    find_turns(i, j, mtx);
-                    if (have_beats && !have_beats_before)
-                    {
-                        have_beats_before = true;
-                        res_turns.clear();
-                    }
-                    if ((have_beats_before && have_beats) || !have_beats_before)
-                    {
-                        res_turns.insert(res_turns.end(), turns.begin(), turns.end());
-                    }
+                    // первые удары: собранные до них тихие ходы больше не допустимы
+                    turns.erase(turns.begin(), turns.begin() + begin);
+                    have_beats = true;
                 }
+                else if (!beats && have_beats)
+                    turns.erase(turns.begin() + begin, turns.end());
             }
         }
-        turns = res_turns;
+        keep_longest_captures();
         shuffle(turns.begin(), turns.end(), rand_eng);
-        have_beats = have_beats_before;
     }
+
+  private:
     /**
-     * Находит все возможные ходы для фигуры в клетке (x, y) на основе переданной матрицы.
-     * Сначала ищет удары (beats):
-     *   - для шашек: проверяет клетки через одну диагональ (x±2, y±2);
-     *   - для дамок: ищет по диагоналям до первой встреченной фигуры, проверяя возможность взятия.
-     * Если ударов нет — ищет простые ходы:
-     *   - для шашек: на одну клетку вперёд по диагонали;
-     *   - для дамок: на любое количество клеток по диагоналям до преграды.
-     *
-     * Результаты сохраняются в поле turns, а флаг have_beats показывает, есть ли удары.
-     *
-     * @param x   — координата по вертикали
-     * @param y   — координата по горизонтали
-     * @param mtx — текущее состояние доски
+     * Добавляет в out ходы фигуры в клетке (x, y) по правилам варианта. Сначала ищет серии взятий
+     * (capture_series); одинаковые по результату (move_pos::operator==) добавляются один раз.
+     * Если ударов нет — добавляет простые ходы:
+     *   - для шашек: на одну клетку вперёд по диагонали (diagonals.step);
+     *   - для дамок: на любое количество клеток по лучам до преграды (короткие — на одну клетку).
+     * Возвращает true, если добавлены удары.
      */
-    void find_turns(const POS_T x, const POS_T y, const vector<vector<POS_T>> &mtx)
+    bool piece_turns(const POS_T x, const POS_T y, const vector<vector<POS_T>> &mtx, vector<move_pos> &out)
     {
-        turns.clear();
-        have_beats = false;
-        POS_T type = mtx[x][y];
-        // check beats
-        switch (type)
+        const auto &diag = board_diagonals<N>;
+        const size_t begin = out.size();
+        capture_series(mtx, x, y, [&](const move_pos &turn) {
+            if (find(out.begin() + begin, out.end(), turn) == out.end())
+                out.push_back(turn);
+        });
+        if (out.size() != begin)
+            return true;
+        const POS_T type = mtx[x][y];
+        const int s = x * N + y;
+        const bool king = (type > 2);
+        // белые шашки ходят к x == 0 (направления 0, 1), чёрные — к x == N - 1 (2, 3)
+        const int forward = ((type % 2) ? 0 : 2);
+        if (!king || !Rules::flying_kings)
         {
-        case 1:
-        case 2:
-            // check pieces
-            for (POS_T i = x - 2; i <= x + 2; i += 4)
+            // check pieces (короткие дамки — во все стороны)
+            for (int d = (king ? 0 : forward), end = (king ? 4 : forward + 2); d < end; ++d)
             {
-                for (POS_T j = y - 2; j <= y + 2; j += 4)
-                {
-                    if (i < 0 || i > 7 || j < 0 || j > 7)
-                        continue;
-                    POS_T xb = (x + i) / 2, yb = (y + j) / 2;
-                    if (mtx[i][j] || !mtx[xb][yb] || mtx[xb][yb] % 2 == type % 2)
-                        continue;
-                    turns.emplace_back(x, y, i, j, xb, yb);
-                }
+                const POS_T to = diag.step[s][d];
+                if (to == -1 || mtx[square_x<N>(to)][square_y<N>(to)])
+                    continue;
+                out.emplace_back(x, y, square_x<N>(to), square_y<N>(to));
+                out.back().crown = (!king && diag.promotion[type - 1][to]);
             }
-            break;
-        default:
+        }
+        else
+        {
             // check queens
-            for (POS_T i = -1; i <= 1; i += 2)
+            for (int d = 0; d < 4; ++d)
             {
-                for (POS_T j = -1; j <= 1; j += 2)
+                for (const POS_T *r = diag.ray[s][d]; *r != -1; ++r)
                 {
-                    POS_T xb = -1, yb = -1;
-                    for (POS_T i2 = x + i, j2 = y + j; i2 != 8 && j2 != 8 && i2 != -1 && j2 != -1; i2 += i, j2 += j)
-                    {
-                        if (mtx[i2][j2])
-                        {
-                            if (mtx[i2][j2] % 2 == type % 2 || (mtx[i2][j2] % 2 != type % 2 && xb != -1))
-                            {
-                                break;
-                            }
-                            xb = i2;
-                            yb = j2;
-                        }
-                        if (xb != -1 && xb != i2)
-                        {
-                            turns.emplace_back(x, y, i2, j2, xb, yb);
-                        }
-                    }
+                    if (mtx[square_x<N>(*r)][square_y<N>(*r)])
+                        break;
+                    out.emplace_back(x, y, square_x<N>(*r), square_y<N>(*r));
                 }
             }
-            break;
         }
-        // check other turns
-        if (!turns.empty())
-        {
-            have_beats = true;
-            return;
-        }
-        switch (type)
+        return false;
+    }
+
+    /**
+     * Все полные серии взятий фигуры с клетки (x, y): для каждой вызывает emit(ход) — серию целиком
+     * (см. move_pos), её прыжки по порядку в этот момент лежат в series_path.
+     * Турецкий удар: побитые фигуры снимаются только после серии, до этого их нельзя бить повторно
+     * и через них нельзя перепрыгнуть; клетка, с которой фигура начала серию, свободна.
+     * Серия продолжается, пока есть чем бить (в английских шашках превращение в дамку её заканчивает).
+     * Возвращает true, если бить есть чем.
+     */
+    template <class Emit> bool capture_series(const vector<vector<POS_T>> &mtx, const POS_T x, const POS_T y, Emit &&emit)
+    {
+        series_path.clear();
+        return extend_series(mtx, x * N + y, mtx[x][y], x * N + y, 0, false, emit);
+    }
+
+    /**
+     * Шаг capture_series: фигура типа type (с учётом превращения по ходу серии) стоит на клетке s,
+     * начала серию с клетки origin и уже побила captured; crowned — превратилась в дамку по ходу серии.
+     * Возвращает true, если серия продолжается хотя бы одним прыжком:
+     *   - шашки и короткие дамки прыгают через соседнюю клетку (diagonals.jump), шашки назад — если правила разрешают;
+     *   - дальнобойные дамки бьют первую фигуру на луче (diagonals.ray) и встают на любую свободную клетку за ней.
+     */
+    template <class Emit>
+    bool extend_series(const vector<vector<POS_T>> &mtx, const int origin, const POS_T type, const int s,
+                       const uint64_t captured, const bool crowned, Emit &emit)
+    {
+        const auto &diag = board_diagonals<N>;
+        const bool king = (type > 2);
+        const auto is_free = [&](const POS_T sq) { return sq == origin || !mtx[square_x<N>(sq)][square_y<N>(sq)]; };
+        const auto is_prey = [&](const POS_T sq) {
+            const POS_T i = square_x<N>(sq), j = square_y<N>(sq);
+            return mtx[i][j] && mtx[i][j] % 2 != type % 2 && !(captured & square_bit<N>(i, j));
+        };
+        bool found = false;
+        // прыжок через фигуру на клетке over на клетку to и продолжение серии оттуда
+        const auto jump = [&](const POS_T over, const POS_T to) {
+            found = true;
+            const POS_T xb = square_x<N>(over), yb = square_y<N>(over);
+            series_path.emplace_back(square_x<N>(s), square_y<N>(s), square_x<N>(to), square_y<N>(to), xb, yb);
+            series_path.back().captured = square_bit<N>(xb, yb);
+            const uint64_t now = captured | series_path.back().captured;
+            const bool last_row = (!king && diag.promotion[type - 1][to]);
+            // в английских шашках серия на превращении заканчивается
+            bool ended = true;
+            if (last_row && Rules::crown == crowning::continue_as_king)
+            {
+                series_path.back().crown = true;
+                ended = !extend_series(mtx, origin, POS_T(type + 2), to, now, true, emit);
+            }
+            else if (!last_row || Rules::crown == crowning::at_series_end)
+                ended = !extend_series(mtx, origin, type, to, now, crowned, emit);
+            if (ended)
+            {
+                if (last_row)
+                    series_path.back().crown = true;
+                move_pos turn(square_x<N>(origin), square_y<N>(origin), square_x<N>(to), square_y<N>(to),
+                              series_path[0].xb, series_path[0].yb);
+                turn.captured = now;
+                turn.crown = (crowned || last_row);
+                emit(turn);
+            }
+            series_path.pop_back();
+        };
+        if (!king || !Rules::flying_kings)
         {
-        case 1:
-        case 2:
             // check pieces
+            int d = 0, end = 4;
+            if constexpr (!Rules::men_capture_backwards)
             {
-                POS_T i = ((type % 2) ? x - 1 : x + 1);
-                for (POS_T j = y - 1; j <= y + 1; j += 2)
+                if (!king)
                 {
-                    if (i < 0 || i > 7 || j < 0 || j > 7 || mtx[i][j])
-                        continue;
-                    turns.emplace_back(x, y, i, j);
+                    d = ((type % 2) ? 0 : 2);
+                    end = d + 2;
                 }
-                break;
             }
-        default:
-            // check queens
-            for (POS_T i = -1; i <= 1; i += 2)
+            for (; d < end; ++d)
             {
-                for (POS_T j = -1; j <= 1; j += 2)
-                {
-                    for (POS_T i2 = x + i, j2 = y + j; i2 != 8 && j2 != 8 && i2 != -1 && j2 != -1; i2 += i, j2 += j)
-                    {
-                        if (mtx[i2][j2])
-                            break;
-                        turns.emplace_back(x, y, i2, j2);
-                    }
-                }
+                const POS_T to = diag.jump[s][d];
+                if (to != -1 && is_prey(diag.step[s][d]) && is_free(to))
+                    jump(diag.step[s][d], to);
+            }
+        }
+        else
+        {
+            // check queens: до первой фигуры на луче, её бьём, если можно, и встаём за ней
+            for (int d = 0; d < 4; ++d)
+            {
+                const POS_T *r = diag.ray[s][d];
+                while (*r != -1 && is_free(*r))
+                    ++r;
+                if (*r == -1 || !is_prey(*r))
+                    continue;
+                const POS_T over = *r;
+                for (++r; *r != -1 && is_free(*r); ++r)
+                    jump(over, *r);
             }
-            break;
+        }
+        return found;
+    }
+
+    /**
+     * Правило большинства (международные шашки): из серий взятий в turns оставляет только те,
+     * что берут наибольшее число фигур. В остальных вариантах ничего не делает.
+     */
+    void keep_longest_captures()
+    {
+        if constexpr (Rules::majority_capture)
+        {
+            if (!have_beats)
+                return;
+            int longest = 0;
+            for (const auto &turn : turns)
+                longest = max(longest, bit_count(turn.captured));
+            turns.erase(remove_if(turns.begin(), turns.end(),
+                                  [&](const move_pos &turn) { return bit_count(turn.captured) != longest; }),
+                        turns.end());
         }
     }
 
@@ -397,6 +1122,31 @@ private:
     // максимальная глубина рекурсии при поиске лучшего хода (ограничение для minimax/alpha-beta)
     int Max_depth;
 
+    // позиции партии до корня поиска (хеши Zobrist::hash с учётом стороны хода) — для повторений
+    vector<uint64_t> history;
+
+    // полуходов подряд дамками без взятий, сделанных в партии к позиции корня (правило "KingMovesDraw")
+    int king_plies = 0;
+
+    // число узлов, просмотренных последним поиском
+    uint64_t nodes = 0;
+
+    // лучший ход (полная серия) и его оценка за сторону хода — по последнему find_best_turns
+    // (find_best_lines записывает только ход)
+    move_pos last_turn{-1, -1, -1, -1};
+    SCORE_T last_score = 0;
+    // глубина, на которой найден ход последнего find_profile_turns: последняя законченная итерация
+    // (прерванная первая — 1, ход вынужден — 0); Max_depth там — глубина прерванной итерации
+    int last_depth = 0;
+
+    // ограничения поиска: не больше node_limit узлов (0 — без ограничения)
+    // и досрочная остановка, когда *stop == true (флаг выставляет другой поток)
+    uint64_t node_limit = 0;
+    const std::atomic<bool> *stop = nullptr;
+
+    // время, после которого поиск прерывается (часы проверяются раз в 1024 узла)
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+
 private:
     // генератор случайных чисел (используется для перемешивания ходов,
     // чтобы бот не делал всегда один и тот же ход)
@@ -405,22 +1155,64 @@ private:
     // выбранный режим оценки позиции:
     //   "Number"              — считать только количество фигур;
     //   "NumberAndPotential"  — учитывать продвижение и потенциал превращения в дамки
+    //   "NNUE"                — оценка нейросетью из файла "NnueFile"
     string scoring_mode;
 
+    // веса оценки для режима "NumberAndPotential" (подбираются checkers_tuner)
+    EvalWeights weights;
+
+    // оценка материала в фиксированной точке (скалярно и пакетами листьев)
+    BatchEval batch_eval;
+
+    // стоимость шашки по продвижению и дамки в Q16 — для досок без пакетной оценки (material_q16)
+    int32_t man_value[N] = {};
+    int32_t king_value = 0;
+
+    // дети узла предпоследнего уровня и их оценки (Q16) для пакетной оценки
+    leaf_batch children;
+    vector<int64_t> leaf_scores;
+
+    // нейросеть оценки (только в режиме "NNUE", иначе nullptr)
+    shared_ptr<Nnue> nnue;
+
+    // аккумуляторы первого слоя сети по пути поиска: вершина — текущий узел
+    vector<Nnue::Accumulator> acc_stack;
+
     // выбранный режим оптимизации поиска
     string optimization;
 
-    // для каждого состояния хранится выбранный следующий ход (используется при восстановлении лучшей последовательности)
-    vector<move_pos> next_move;
+    // таблица транспозиций (размер — "HashMB"), общая для последовательных поисков и линий multi-PV,
+    // а на сервере — для всех сессий
+    shared_ptr<TranspositionTable> tt;
+
+    // ключи хеширования позиций
+    static inline const BasicZobrist<N> &zobrist = BasicZobrist<N>::get();
+
+    // цвет, за который ведётся текущий поиск (оценки в таблице — с его точки зрения)
+    bool root_color = false;
 
-    // связь между состояниями: для каждого состояния храним индекс следующего
-    // (используется для восстановления цепочки ходов)
-    vector<int> next_best_state;
+    // последний поиск прерван ограничениями (см. limit_reached)
+    bool stopped = false;
 
-    // указатель на объект доски, чтобы вызывать board->get_board()
-    Board *board;
+    // история партии и позиции на пути от корня до текущего узла (см. is_draw)
+    vector<uint64_t> search_path;
+
+    // полуходов дамками подряд в текущем узле и предел по правилу "KingMovesDraw" (0 — правило выключено)
+    int cur_plies = 0;
+    int draw_plies = 0;
+
+    // прыжки серии взятий, которую сейчас строит capture_series
+    vector<move_pos> series_path;
 
     // указатель на объект конфигурации, чтобы читать параметры (задержки, режимы и т.п.)
     Config *config;
 
+#ifdef CHECKERS_TREE_DUMP
+    // дамп дерева поиска в "TreeDumpFile" (Models/Tree_dump.h; nullptr — не пишется)
+    unique_ptr<SearchTreeWriter> tree_dump;
+#endif
+
 };
+
+// русские шашки 8x8
+using Logic = BasicLogic<russian_rules>;
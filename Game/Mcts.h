@@ -0,0 +1,307 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "../Models/Score.h"
+#include "../Models/Trace.h"
+#include "Config.h"
+#include "Logic.h"
+
+/**
+ * Поиск Монте-Карло по дереву (MCTS, UCT) на всех ядрах — второй движок бота ("Bot" → "Engine": "MCTS").
+ *
+ * Каждый поток повторяет: спуск от корня по UCT, раскрытие листа, разыгрывание из него, обратный проход.
+ * Статистика узлов — атомарные счётчики без блокировок; виртуальная потеря: посещение засчитывается
+ * узлу уже на спуске, а результат — только после разыгрывания, поэтому пока поток в поддереве,
+ * оно выглядит для других потоков хуже, и они расходятся по разным ветвям. Узел раскрывает один поток
+ * (флаг state, compare_exchange), остальные до конца раскрытия разыгрывают из него как из листа.
+ *
+ * Узлы лежат в арене — массиве, выделенном один раз ("MctsArenaMB") и переиспользуемом между ходами:
+ * новый поиск просто начинает выдачу узлов сначала, дети узла занимают подряд идущие ячейки.
+ * Когда арена заполнена, дерево перестаёт расти, а поиск продолжается по уже построенному.
+ *
+ * Разыгрывание — случайные ходы (серия взятий — один ход) до конца партии или, если "MctsPlayoutPlies" > 0,
+ * столько полуходов, после чего позиция оценивается оценкой бота (BotScoringType): отношение сил r
+ * переводится в вероятность выигрыша r / (1 + r). Ничья — правило "KingMovesDraw" (и в дереве, и в разыгрывании)
+ * или предел длины разыгрывания; повторения позиций не отслеживаются.
+ *
+ * Ходы генерирует BasicLogic — у каждого потока своя (со своими буферами ходов и аккумулятором сети).
+ */
+template <class Rules> class BasicMcts
+{
+  public:
+    explicit BasicMcts(Config *config) : config(config)
+    {
+        const int requested = (*config)("Bot", "MctsThreads");
+        threads = (requested > 0 ? requested : max(1, int(thread::hardware_concurrency())));
+        move_time = chrono::milliseconds(int((*config)("Bot", "MctsTimeMS")));
+        playout_plies = (*config)("Bot", "MctsPlayoutPlies");
+        draw_plies = 2 * int((*config)("Game", "KingMovesDraw"));
+        capacity = max<size_t>(1024, size_t((*config)("Bot", "MctsArenaMB")) * 1024 * 1024 / sizeof(node));
+        arena.reset(new node[capacity]);
+        // генераторы ходов потоков: таблица транспозиций им не нужна, одна маленькая на всех
+        auto tt = make_shared<TranspositionTable>(1);
+        for (int t = 0; t < threads; ++t)
+            workers.push_back(make_unique<BasicLogic<Rules>>(config, tt));
+        const unsigned seed = ((*config)("Bot", "NoRandom") ? 0u : unsigned(time(0)));
+        for (int t = 0; t < threads; ++t)
+            rngs.emplace_back(seed + unsigned(t));
+    }
+
+    /**
+     * Лучший ход стороны color в позиции mtx по прыжкам — как BasicLogic::find_best_turns.
+     * king_plies — полуходов дамками подряд к этой позиции (правило "KingMovesDraw").
+     * Думает "MctsTimeMS" миллисекунд или, если задан playout_limit, до стольких разыгрываний.
+     */
+    vector<move_pos> find_best_turns(const bool color, const vector<vector<POS_T>> &mtx, const int king_plies = 0)
+    {
+        TRACE_SCOPE("Mcts::find_best_turns");
+        auto &logic = *workers[0];
+        logic.find_turns(color, mtx);
+        playouts = 0;
+        if (logic.turns.empty())
+            return {};
+        if (logic.turns.size() == 1)
+            return logic.series_steps(mtx, logic.turns[0]);
+        // run(0) разыгрывает партии на workers[0], после поиска logic.turns — ходы последней позиции разыгрывания
+        const vector<move_pos> root_turns = logic.turns;
+
+        root_mtx = mtx;
+        root_color = color;
+        root_plies = king_plies;
+        top = 1;
+        arena[0].reset(move_pos{-1, -1, -1, -1});
+        deadline = chrono::steady_clock::now() + move_time;
+        vector<thread> pool;
+        for (int t = 1; t < threads; ++t)
+            pool.emplace_back([this, t]() { run(t); });
+        run(0);
+        for (auto &th : pool)
+            th.join();
+
+        // ход — самый посещённый ребёнок корня
+        const node &root = arena[0];
+        if (root.state.load() != kExpanded)
+            return logic.series_steps(mtx, root_turns[0]);
+        const node *best = nullptr;
+        for (uint32_t k = 0; k < root.count; ++k)
+        {
+            const node &child = arena[root.first + k];
+            if (!best || child.visits.load() > best->visits.load())
+                best = &child;
+        }
+        return logic.series_steps(mtx, best->move);
+    }
+
+    // не больше стольких разыгрываний за ход (0 — только ограничение по времени)
+    uint64_t playout_limit = 0;
+
+    // число разыгрываний последнего поиска (все потоки)
+    std::atomic<uint64_t> playouts{0};
+
+  private:
+    enum : uint8_t
+    {
+        kLeaf,     ///< не раскрыт
+        kBusy,     ///< раскрывается другим потоком
+        kExpanded, ///< дети в first .. first + count - 1
+        kFull      ///< в арене не хватило места — навсегда лист
+    };
+
+    // узел дерева; value — сумма результатов (Q16, 1.0 = выигрыш) с точки зрения стороны, сделавшей move
+    struct node
+    {
+        move_pos move{-1, -1, -1, -1};
+        std::atomic<uint32_t> visits{0};
+        std::atomic<int64_t> value{0};
+        uint32_t first = 0;
+        uint32_t count = 0;
+        std::atomic<uint8_t> state{kLeaf};
+
+        void reset(const move_pos &turn)
+        {
+            move = turn;
+            visits.store(0, std::memory_order_relaxed);
+            value.store(0, std::memory_order_relaxed);
+            first = count = 0;
+            state.store(kLeaf, std::memory_order_relaxed);
+        }
+    };
+
+    // лист раскрывается со второго посещения: одиночные разыгрывания не расходуют арену
+    static constexpr uint32_t kExpandVisits = 2;
+    // предел длины разыгрывания до конца партии (дальше — ничья)
+    static constexpr int kMaxPlayout = 400;
+    // константа исследования UCT
+    static constexpr double kExploration = 1.4;
+    static constexpr int64_t kOne = int64_t(1) << 16;
+
+    // цикл одного потока: разыгрывания до конца времени или лимита
+    void run(const int t)
+    {
+        if (t)
+            TRACE_THREAD("mcts");
+        TRACE_SCOPE("Mcts::run");
+        auto &logic = *workers[t];
+        auto &rng = rngs[t];
+        vector<uint32_t> path;
+        while (chrono::steady_clock::now() < deadline &&
+               (!playout_limit || playouts.load(std::memory_order_relaxed) < playout_limit))
+        {
+            iterate(logic, rng, path);
+            playouts.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Одна итерация: спуск с виртуальной потерей, раскрытие, разыгрывание, обратный проход.
+     */
+    void iterate(BasicLogic<Rules> &logic, mt19937 &rng, vector<uint32_t> &path)
+    {
+        auto mtx = root_mtx;
+        bool color = root_color;
+        int plies = root_plies;
+        path.assign(1, 0);
+        arena[0].visits.fetch_add(1, std::memory_order_relaxed);
+        int64_t result = -1; // вероятность выигрыша root_color (Q16), -1 — ещё не известна
+        while (result < 0)
+        {
+            node &cur = arena[path.back()];
+            uint8_t state = cur.state.load(std::memory_order_acquire);
+            if (state == kLeaf && cur.visits.load(std::memory_order_relaxed) >= kExpandVisits &&
+                cur.state.compare_exchange_strong(state, kBusy, std::memory_order_acquire))
+            {
+                state = expand(logic, cur, color, mtx);
+            }
+            if (state != kExpanded)
+            {
+                result = playout(logic, rng, mtx, color, plies);
+                break;
+            }
+            if (!cur.count)
+            {
+                // ходить нечем — проигрыш стороны хода
+                result = (color == root_color ? 0 : kOne);
+                break;
+            }
+            const uint32_t next = select(cur);
+            node &child = arena[next];
+            child.visits.fetch_add(1, std::memory_order_relaxed); // виртуальная потеря до обратного прохода
+            plies = (child.move.xb != -1 || mtx[child.move.x][child.move.y] < 3) ? 0 : plies + 1;
+            mtx = logic.make_turn(mtx, child.move);
+            color = !color;
+            path.push_back(next);
+            if (draw_plies && plies >= draw_plies)
+                result = kOne / 2;
+        }
+        // результат — с точки зрения стороны, сделавшей ход в узел: на нечётной глубине это root_color
+        for (size_t d = 1; d < path.size(); ++d)
+            arena[path[d]].value.fetch_add(d % 2 ? result : kOne - result, std::memory_order_relaxed);
+    }
+
+    /**
+     * Раскрытие узла cur (state == kBusy у этого потока): дети — ходы стороны color из mtx.
+     */
+    uint8_t expand(BasicLogic<Rules> &logic, node &cur, const bool color, const vector<vector<POS_T>> &mtx)
+    {
+        logic.find_turns(color, mtx);
+        const uint32_t count = uint32_t(logic.turns.size());
+        const uint32_t first = top.fetch_add(count, std::memory_order_relaxed);
+        if (size_t(first) + count > capacity)
+        {
+            cur.state.store(kFull, std::memory_order_release);
+            return kFull;
+        }
+        for (uint32_t k = 0; k < count; ++k)
+            arena[first + k].reset(logic.turns[k]);
+        cur.first = first;
+        cur.count = count;
+        cur.state.store(kExpanded, std::memory_order_release);
+        return kExpanded;
+    }
+
+    /**
+     * UCT: ребёнок с наибольшим Q + c * sqrt(ln N / n); непосещённые — первыми.
+     */
+    uint32_t select(const node &cur) const
+    {
+        const double log_parent = log(double(max<uint32_t>(1, cur.visits.load(std::memory_order_relaxed))));
+        uint32_t best = cur.first;
+        double best_ucb = -1;
+        for (uint32_t k = cur.first; k < cur.first + cur.count; ++k)
+        {
+            const uint32_t n = arena[k].visits.load(std::memory_order_relaxed);
+            if (!n)
+                return k;
+            const double q = double(arena[k].value.load(std::memory_order_relaxed)) / double(kOne) / n;
+            const double ucb = q + kExploration * sqrt(log_parent / n);
+            if (ucb > best_ucb)
+            {
+                best_ucb = ucb;
+                best = k;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * Разыгрывание из позиции mtx (ходит color): вероятность выигрыша root_color в Q16.
+     */
+    int64_t playout(BasicLogic<Rules> &logic, mt19937 &rng, vector<vector<POS_T>> mtx, bool color, int plies)
+    {
+        for (int ply = 0;; ++ply)
+        {
+            if (playout_plies > 0 && ply >= playout_plies)
+            {
+                const SCORE_T score = logic.evaluate(mtx, root_color);
+                if (is_win(score))
+                    return kOne;
+                if (is_loss(score))
+                    return 0;
+                // отношение сил r = score / SCORE_ONE → r / (1 + r)
+                return int64_t(score) * kOne / (int64_t(score) + SCORE_ONE);
+            }
+            if (ply >= kMaxPlayout || (draw_plies && plies >= draw_plies))
+                return kOne / 2;
+            logic.find_turns(color, mtx);
+            if (logic.turns.empty())
+                return (color == root_color ? 0 : kOne);
+            const move_pos &turn = logic.turns[rng() % logic.turns.size()];
+            plies = (turn.xb != -1 || mtx[turn.x][turn.y] < 3) ? 0 : plies + 1;
+            mtx = logic.make_turn(mtx, turn);
+            color = !color;
+        }
+    }
+
+    Config *config;
+
+    // потоки поиска, время на ход, длина разыгрывания до оценки (0 — до конца партии), правило ничьей
+    int threads = 1;
+    chrono::milliseconds move_time{1000};
+    int playout_plies = 0;
+    int draw_plies = 0;
+
+    // арена узлов: arena[0] — корень, top — первая свободная ячейка
+    std::unique_ptr<node[]> arena;
+    size_t capacity = 0;
+    std::atomic<uint32_t> top{0};
+
+    // генераторы ходов и случайных чисел потоков
+    vector<unique_ptr<BasicLogic<Rules>>> workers;
+    vector<mt19937> rngs;
+
+    // позиция корня текущего поиска
+    vector<vector<POS_T>> root_mtx;
+    bool root_color = false;
+    int root_plies = 0;
+    chrono::steady_clock::time_point deadline;
+};
+
+// MCTS для русских шашек 8x8
+using Mcts = BasicMcts<russian_rules>;
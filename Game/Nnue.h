@@ -0,0 +1,324 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define NNUE_SSE2
+#endif
+
+#include "../Models/Move.h"
+#include "Diagonals.h"
+
+/**
+ * Нейросетевая оценка позиции в стиле NNUE.
+ *
+ * Архитектура: 128 бинарных входов (4 типа фигур × 32 тёмные клетки) →
+ * скрытый слой kHidden нейронов (int16, «аккумулятор») → clipped ReLU [0, 127] →
+ * один выход (int32). Первый слой обновляется инкрементально: при ходе
+ * вычитаются веса ушедших фигур и прибавляются веса пришедших, поэтому
+ * стоимость узла поиска — несколько векторных сложений вместо полного пересчёта.
+ *
+ * Формат файла сети (little-endian):
+ *   char[4]  magic = "CKNN"
+ *   uint32   version = kVersion
+ *   uint32   inputs  = kInputs
+ *   uint32   hidden  = kHidden
+ *   int16    ft_bias[hidden]
+ *   int16    ft_weights[inputs][hidden]
+ *   int8     out_weights[hidden]
+ *   int32    out_bias
+ *   int32    out_scale  — делитель выхода; результат — 1000 * e, e в шкале ln(W / B) (calc_nnue_score)
+ *
+ * Сеть обучает checkers_tuner nnue (см. quantize), готовая сеть — Networks/checkers.nnue.
+ */
+class Nnue
+{
+  public:
+    static constexpr uint32_t kVersion = 1;
+    static constexpr int kSquares = 32;
+    static constexpr int kInputs = 4 * kSquares;
+    static constexpr int kHidden = 128;
+    static constexpr int kClip = 127;
+
+    // значения аккумулятора первого слоя для одной позиции
+    struct Accumulator
+    {
+        alignas(32) int16_t v[kHidden];
+    };
+
+    // номер входа: тип фигуры (1..4) × тёмная клетка sq = i * 4 + j / 2 (как в packed_position)
+    static int feature(const POS_T type, const int sq)
+    {
+        return (type - 1) * kSquares + sq;
+    }
+
+    /**
+     * Загружает сеть из бинарного файла. Возвращает nullptr,
+     * если файл не найден, повреждён или собран под другую версию/размеры.
+     */
+    static std::shared_ptr<Nnue> load(const std::string &path)
+    {
+        std::ifstream fin(path, std::ios::binary);
+        if (!fin)
+            return nullptr;
+        char magic[4];
+        uint32_t version = 0, inputs = 0, hidden = 0;
+        fin.read(magic, 4);
+        read_raw(fin, version);
+        read_raw(fin, inputs);
+        read_raw(fin, hidden);
+        if (!fin || memcmp(magic, "CKNN", 4) != 0 || version != kVersion || inputs != kInputs || hidden != kHidden)
+            return nullptr;
+
+        auto net = std::make_shared<Nnue>();
+        int8_t out8[kHidden];
+        fin.read(reinterpret_cast<char *>(net->ft_bias), sizeof(net->ft_bias));
+        fin.read(reinterpret_cast<char *>(net->ft_weights), sizeof(net->ft_weights));
+        fin.read(reinterpret_cast<char *>(out8), sizeof(out8));
+        read_raw(fin, net->out_bias);
+        read_raw(fin, net->out_scale);
+        if (!fin || net->out_scale == 0)
+            return nullptr;
+        for (int i = 0; i < kHidden; ++i)
+            net->out_weights[i] = out8[i];
+        return net;
+    }
+
+    /**
+     * Сохраняет сеть в бинарный файл того же формата, что читает load().
+     */
+    bool save(const std::string &path) const
+    {
+        std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+        if (!fout)
+            return false;
+        int8_t out8[kHidden];
+        for (int i = 0; i < kHidden; ++i)
+            out8[i] = int8_t(out_weights[i]);
+        fout.write("CKNN", 4);
+        write_raw(fout, kVersion);
+        write_raw(fout, uint32_t(kInputs));
+        write_raw(fout, uint32_t(kHidden));
+        fout.write(reinterpret_cast<const char *>(ft_bias), sizeof(ft_bias));
+        fout.write(reinterpret_cast<const char *>(ft_weights), sizeof(ft_weights));
+        fout.write(reinterpret_cast<const char *>(out8), sizeof(out8));
+        write_raw(fout, out_bias);
+        write_raw(fout, out_scale);
+        return bool(fout);
+    }
+
+    /**
+     * Встроенная материальная сеть: нейроны 0/2 считают белые/чёрные шашки
+     * с бонусом за продвижение, нейроны 1/3 — дамки; выходной слой даёт разницу материала.
+     * Это не оценка "NumberAndPotential": та — отношение сил сторон, а здесь разница
+     * материала переводится в шкалу поиска через exp (calc_nnue_score), так что ходы могут отличаться.
+     * Используется, если файл сети не найден.
+     */
+    static std::shared_ptr<Nnue> material()
+    {
+        auto net = std::make_shared<Nnue>();
+        for (int sq = 0; sq < kSquares; ++sq)
+        {
+            const int row = sq / 4;
+            net->ft_weights[feature(1, sq)][0] = int16_t(6 + (7 - row) / 2);
+            net->ft_weights[feature(3, sq)][1] = 6;
+            net->ft_weights[feature(2, sq)][2] = int16_t(6 + row / 2);
+            net->ft_weights[feature(4, sq)][3] = 6;
+        }
+        net->out_weights[0] = 16;
+        net->out_weights[1] = 80;
+        net->out_weights[2] = -16;
+        net->out_weights[3] = -80;
+        return net;
+    }
+
+    /**
+     * Квантование сети, обученной в float (checkers_tuner nnue): скрытый нейрон — clamp(a, 0, 1),
+     * выход — оценка e в той же шкале, что ln(W / B) оценки "NumberAndPotential".
+     * Первый слой умножается на kClip (1.0 — kClip в аккумуляторе), выходной — на наибольший масштаб,
+     * при котором веса помещаются в int8; out_scale подбирается так, чтобы evaluate() вернул 1000 * e.
+     * Возвращает nullptr, если веса не помещаются в int16 / int8.
+     */
+    static std::shared_ptr<Nnue> quantize(const float *bias, const float *weights, const float *out, const float out_b)
+    {
+        float out_max = 1e-6f;
+        for (int i = 0; i < kHidden; ++i)
+            out_max = std::max(out_max, std::abs(out[i]));
+        // веса выхода в int8: out * (out_scale * 1000 / kClip), out_scale — целое не меньше 1
+        const int32_t scale = int32_t(kClip * (kClip / out_max) / 1000);
+        if (scale < 1)
+            return nullptr;
+        const float out_mult = float(scale) * 1000.0f / kClip;
+        auto net = std::make_shared<Nnue>();
+        auto to16 = [](const float v, int16_t &res) {
+            const long q = std::lround(v * kClip);
+            res = int16_t(q);
+            return q >= INT16_MIN && q <= INT16_MAX;
+        };
+        bool ok = true;
+        for (int i = 0; i < kHidden; ++i)
+        {
+            ok &= to16(bias[i], net->ft_bias[i]);
+            for (int f = 0; f < kInputs; ++f)
+                ok &= to16(weights[f * kHidden + i], net->ft_weights[f][i]);
+            net->out_weights[i] = int16_t(std::lround(out[i] * out_mult));
+        }
+        net->out_bias = int32_t(std::lround(double(out_b) * 1000.0 * scale));
+        net->out_scale = scale;
+        return ok ? net : nullptr;
+    }
+
+    /**
+     * Полный пересчёт аккумулятора по матрице доски (корень поиска).
+     */
+    Accumulator refresh(const std::vector<std::vector<POS_T>> &mtx) const
+    {
+        Accumulator acc;
+        memcpy(acc.v, ft_bias, sizeof(acc.v));
+        for (POS_T i = 0; i < 8; ++i)
+            for (POS_T j = 0; j < 8; ++j)
+                if (mtx[i][j])
+                    add(acc, feature(mtx[i][j], square(i, j)));
+        return acc;
+    }
+
+    /**
+     * Инкрементальное обновление аккумулятора на ход turn,
+     * сделанный из позиции mtx (до хода). Повторяет правила make_turn:
+     * снятие побитых фигур серии и превращение в дамку.
+     */
+    void update(Accumulator &acc, const std::vector<std::vector<POS_T>> &mtx, const move_pos &turn) const
+    {
+        const POS_T type = mtx[turn.x][turn.y];
+        sub(acc, feature(type, square(turn.x, turn.y)));
+        for_each_square(turn.captured, [&](const POS_T i, const POS_T j) { sub(acc, feature(mtx[i][j], square(i, j))); });
+        add(acc, feature(type + (turn.crown ? 2 : 0), square(turn.x2, turn.y2)));
+    }
+
+    /**
+     * Выход сети: оценка с точки зрения белых, 1000 * e.
+     */
+    int evaluate(const Accumulator &acc) const
+    {
+        return (out_bias + dot_clipped(acc.v, out_weights)) / out_scale;
+    }
+
+  private:
+    static int square(const POS_T i, const POS_T j)
+    {
+        return i * 4 + j / 2;
+    }
+
+    void add(Accumulator &acc, const int f) const
+    {
+        const int16_t *w = ft_weights[f];
+#if defined(__AVX2__)
+        for (int i = 0; i < kHidden; i += 16)
+        {
+            __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i *>(acc.v + i));
+            __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i *>(w + i));
+            _mm256_store_si256(reinterpret_cast<__m256i *>(acc.v + i), _mm256_add_epi16(a, b));
+        }
+#elif defined(NNUE_SSE2)
+        for (int i = 0; i < kHidden; i += 8)
+        {
+            __m128i a = _mm_load_si128(reinterpret_cast<const __m128i *>(acc.v + i));
+            __m128i b = _mm_load_si128(reinterpret_cast<const __m128i *>(w + i));
+            _mm_store_si128(reinterpret_cast<__m128i *>(acc.v + i), _mm_add_epi16(a, b));
+        }
+#else
+        for (int i = 0; i < kHidden; ++i)
+            acc.v[i] = int16_t(acc.v[i] + w[i]);
+#endif
+    }
+
+    void sub(Accumulator &acc, const int f) const
+    {
+        const int16_t *w = ft_weights[f];
+#if defined(__AVX2__)
+        for (int i = 0; i < kHidden; i += 16)
+        {
+            __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i *>(acc.v + i));
+            __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i *>(w + i));
+            _mm256_store_si256(reinterpret_cast<__m256i *>(acc.v + i), _mm256_sub_epi16(a, b));
+        }
+#elif defined(NNUE_SSE2)
+        for (int i = 0; i < kHidden; i += 8)
+        {
+            __m128i a = _mm_load_si128(reinterpret_cast<const __m128i *>(acc.v + i));
+            __m128i b = _mm_load_si128(reinterpret_cast<const __m128i *>(w + i));
+            _mm_store_si128(reinterpret_cast<__m128i *>(acc.v + i), _mm_sub_epi16(a, b));
+        }
+#else
+        for (int i = 0; i < kHidden; ++i)
+            acc.v[i] = int16_t(acc.v[i] - w[i]);
+#endif
+    }
+
+    // sum(clamp(a[i], 0, kClip) * w[i]) — выходной слой
+    static int32_t dot_clipped(const int16_t *a, const int16_t *w)
+    {
+#if defined(__AVX2__)
+        const __m256i zero = _mm256_setzero_si256(), clip = _mm256_set1_epi16(kClip);
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < kHidden; i += 16)
+        {
+            __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i *>(a + i));
+            x = _mm256_min_epi16(_mm256_max_epi16(x, zero), clip);
+            __m256i y = _mm256_load_si256(reinterpret_cast<const __m256i *>(w + i));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(x, y));
+        }
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+        return _mm_cvtsi128_si32(s);
+#elif defined(NNUE_SSE2)
+        const __m128i zero = _mm_setzero_si128(), clip = _mm_set1_epi16(kClip);
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < kHidden; i += 8)
+        {
+            __m128i x = _mm_load_si128(reinterpret_cast<const __m128i *>(a + i));
+            x = _mm_min_epi16(_mm_max_epi16(x, zero), clip);
+            __m128i y = _mm_load_si128(reinterpret_cast<const __m128i *>(w + i));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(x, y));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        return _mm_cvtsi128_si32(sum);
+#else
+        int32_t sum = 0;
+        for (int i = 0; i < kHidden; ++i)
+        {
+            int32_t x = a[i] < 0 ? 0 : (a[i] > kClip ? kClip : a[i]);
+            sum += x * w[i];
+        }
+        return sum;
+#endif
+    }
+
+    template <typename T> static void read_raw(std::istream &in, T &value)
+    {
+        in.read(reinterpret_cast<char *>(&value), sizeof(value));
+    }
+
+    template <typename T> static void write_raw(std::ostream &out, const T &value)
+    {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    alignas(32) int16_t ft_bias[kHidden] = {};
+    alignas(32) int16_t ft_weights[kInputs][kHidden] = {};
+    // веса выходного слоя хранятся в файле как int8, в памяти — расширенными до int16 для madd
+    alignas(32) int16_t out_weights[kHidden] = {};
+    int32_t out_bias = 0;
+    int32_t out_scale = 1;
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "Config.h"
+
+/**
+ * Профиль сложности бота (секция "Profiles" в settings.json) — вместо глубины "WhiteBotLevel" / "BlackBotLevel":
+ *   nodes   — бюджет узлов на ход, жёсткий: поиск (итеративное углубление) не просматривает больше,
+ *             поэтому худшая стоимость хода известна заранее и не зависит от позиции;
+ *   noise   — шум оценки: к оценке каждого хода корня добавляется нормальный шум с таким
+ *             стандартным отклонением (в долях равенства сил, 0.1 — 10%);
+ *   blunder — вероятность зевка: вместо лучшего хода — случайный другой.
+ * Выполняет поиск Logic::find_profile_turns.
+ */
+struct search_profile
+{
+    uint64_t nodes = 0;
+    double noise = 0;
+    double blunder = 0;
+};
+
+/**
+ * Профиль name из секции "Profiles"; false — такого профиля нет.
+ */
+inline bool read_profile(const Config &config, const string &name, search_profile &profile)
+{
+    if (name.empty() || !config.has("Profiles", name))
+        return false;
+    const json p = config("Profiles", name);
+    profile.nodes = p.value("Nodes", uint64_t(0));
+    profile.noise = p.value("Noise", 0.0);
+    profile.blunder = p.value("Blunder", 0.0);
+    return profile.nodes > 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Небольшой пул потоков для многих партий в одном процессе (см. Session.h): задачи — шаги партий
+ * и поиски ходов. Партия, ждущая ход человека или удалённого игрока, поток не занимает.
+ * Деструктор дожидается выполнения всех уже поставленных задач.
+ */
+class Scheduler
+{
+  public:
+    explicit Scheduler(const unsigned threads = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        for (unsigned t = 0; t < std::max(1u, threads); ++t)
+            pool.emplace_back([this]() { run(); });
+    }
+
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    ~Scheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto &th : pool)
+            th.join();
+    }
+
+    void post(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            tasks.push_back(std::move(task));
+        }
+        cv.notify_one();
+    }
+
+    size_t threads() const
+    {
+        return pool.size();
+    }
+
+  private:
+    void run()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> tasks;
+    bool stopping = false;
+    std::vector<std::thread> pool;
+};
@@ -0,0 +1,374 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "../Models/Notation.h"
+#include "Logic.h"
+#include "Scheduler.h"
+
+/**
+ * Партия без окна — возобновляемый конечный автомат для многих партий в одном процессе.
+ *
+ * Состояния: ход (проверка ничьей и конца партии, запрос хода у источника стороны) →
+ * ожидание хода → ход сделан → снова ход ... → партия окончена. Шаги автомата выполняются
+ * задачами Scheduler; пока источник думает или ждёт человека, партия — только данные, поток свободен.
+ * Источники ходов подключаются через BasicMoveSource: локальный движок (BasicEngineSource),
+ * человек или удалённый игрок (BasicRemoteSource: запрос уходит в интерфейс или в сеть, ответ — deliver).
+ * Правила конца партии — как в Game::play: "MaxNumTurns" полуходов, третье повторение позиции,
+ * "KingMovesDraw" ходов дамками — ничья; нет ходов — поражение.
+ */
+template <class Rules> class BasicSession;
+
+// запрос хода у источника
+struct turn_request
+{
+    // номер запроса: ответ на устаревший запрос (партия закончилась, сторона сдалась) отбрасывается
+    uint64_t ticket = 0;
+    bool color = false;
+    vector<vector<POS_T>> mtx;
+    // допустимые ходы (полные серии взятий)
+    vector<move_pos> turns;
+    // хэши позиций партии до текущей и число полуходов дамками подряд — для поиска
+    vector<uint64_t> history;
+    int king_plies = 0;
+};
+
+/**
+ * Источник ходов одной стороны. request не должен блокировать: ход передаётся позже
+ * через session->deliver(req.ticket, ...) из любого потока.
+ */
+template <class Rules> class BasicMoveSource
+{
+  public:
+    virtual ~BasicMoveSource() = default;
+    virtual void request(const shared_ptr<BasicSession<Rules>> &session, const turn_request &req) = 0;
+};
+
+/**
+ * Logic для многих партий и поисков: объекты переиспользуются (веса и сеть NNUE загружаются
+ * один раз на объект), таблица транспозиций у всех общая. Объект пула — только в одном потоке за раз.
+ */
+template <class Rules> class BasicLogicPool
+{
+  public:
+    using handle = unique_ptr<BasicLogic<Rules>, function<void(BasicLogic<Rules> *)>>;
+
+    BasicLogicPool(Config *config, shared_ptr<TranspositionTable> shared_tt = nullptr)
+        : config(config), tt(shared_tt ? shared_tt : make_shared<TranspositionTable>((*config)("Bot", "HashMB")))
+    {
+    }
+
+    handle acquire()
+    {
+        BasicLogic<Rules> *logic = nullptr;
+        {
+            lock_guard<mutex> lock(m);
+            if (!idle.empty())
+            {
+                logic = idle.back().release();
+                idle.pop_back();
+            }
+        }
+        if (!logic)
+            logic = new BasicLogic<Rules>(config, tt);
+        return handle(logic, [this](BasicLogic<Rules> *l) {
+            lock_guard<mutex> lock(m);
+            idle.emplace_back(l);
+        });
+    }
+
+  private:
+    Config *config;
+    shared_ptr<TranspositionTable> tt;
+    mutex m;
+    vector<unique_ptr<BasicLogic<Rules>>> idle;
+};
+
+template <class Rules> class BasicSession : public enable_shared_from_this<BasicSession<Rules>>
+{
+  public:
+    using source_ptr = shared_ptr<BasicMoveSource<Rules>>;
+
+    /**
+     * sources[0] ходит за белых, sources[1] — за чёрных; on_finish вызывается один раз по окончании партии.
+     */
+    BasicSession(Scheduler &scheduler, BasicLogicPool<Rules> &logics, source_ptr white, source_ptr black,
+                 const int max_turns, const int draw_plies, function<void(BasicSession &)> on_finish = nullptr)
+        : scheduler(scheduler), logics(logics), sources{std::move(white), std::move(black)}, max_turns(max_turns),
+          draw_plies(draw_plies), on_finish(std::move(on_finish))
+    {
+    }
+
+    /**
+     * Начинает партию с позиции mtx (ходит color); дальше партия идёт на потоках scheduler.
+     */
+    void start(vector<vector<POS_T>> start_mtx = start_position(Rules::size), const bool start_color = false)
+    {
+        lock_guard<mutex> lock(m);
+        mtx = std::move(start_mtx);
+        color = start_color;
+        state = state_t::TURN;
+        schedule();
+    }
+
+    /**
+     * Ход turn на запрос ticket. false — запрос устарел или такого хода нет (запрос остаётся в силе).
+     */
+    bool deliver(const uint64_t ticket, const move_pos &turn)
+    {
+        lock_guard<mutex> lock(m);
+        if (state != state_t::WAITING || ticket != current.ticket || pending ||
+            find(current.turns.begin(), current.turns.end(), turn) == current.turns.end())
+            return false;
+        pending = make_unique<move_pos>(turn);
+        schedule();
+        return true;
+    }
+
+    /**
+     * Ход в нотации Models/Notation.h ("c3-d4", "c3:e5:g3") на запрос ticket.
+     */
+    bool deliver(const uint64_t ticket, const string &series)
+    {
+        vector<vector<POS_T>> before, after;
+        bool side;
+        {
+            lock_guard<mutex> lock(m);
+            if (state != state_t::WAITING || ticket != current.ticket)
+                return false;
+            before = current.mtx;
+            side = current.color;
+        }
+        auto logic = logics.acquire();
+        const auto steps = logic->resolve_series(side, before, parse_series(series));
+        if (steps.empty())
+            return false;
+        after = before;
+        for (const auto &step : steps)
+            after = logic->make_turn(after, step);
+        // серия приходит по прыжкам, а deliver ждёт полный ход: тот, что ведёт в ту же позицию
+        logic->find_turns(side, before);
+        for (const auto &turn : logic->turns)
+            if (turn.x == steps[0].x && turn.y == steps[0].y && logic->make_turn(before, turn) == after)
+                return deliver(ticket, turn);
+        return false;
+    }
+
+    /**
+     * Сторона side сдаётся (например, удалённый игрок отключился).
+     */
+    void resign(const bool side)
+    {
+        {
+            lock_guard<mutex> lock(m);
+            if (state == state_t::FINISHED)
+                return;
+            finish(side ? 1 : 2);
+        }
+        if (on_finish)
+            on_finish(*this);
+    }
+
+    // итог: -1 — партия идёт, 0 — ничья, 1 — победа белых, 2 — победа чёрных (как у Game::play)
+    int result() const
+    {
+        lock_guard<mutex> lock(m);
+        return res;
+    }
+
+    // сыгранные ходы (полные серии взятий)
+    vector<move_pos> moves() const
+    {
+        lock_guard<mutex> lock(m);
+        return played;
+    }
+
+  private:
+    enum class state_t
+    {
+        IDLE,
+        TURN,
+        WAITING,
+        FINISHED
+    };
+
+    // ставит шаг партии в очередь scheduler, если он ещё не стоит там (вызывается под m)
+    void schedule()
+    {
+        if (queued)
+            return;
+        queued = true;
+        scheduler.post([self = this->shared_from_this()]() { self->advance(); });
+    }
+
+    void finish(const int result)
+    {
+        res = result;
+        state = state_t::FINISHED;
+        ++current.ticket;
+    }
+
+    /**
+     * Шаг автомата: делает пришедший ход и готовит запрос следующего; источник вызывается
+     * без блокировки партии, поэтому может ответить сразу, из того же потока.
+     */
+    void advance()
+    {
+        unique_lock<mutex> lock(m);
+        queued = false;
+        while (true)
+        {
+            if (state == state_t::WAITING && pending)
+            {
+                const auto before = mtx;
+                {
+                    auto logic = logics.acquire();
+                    mtx = logic->make_turn(mtx, *pending);
+                }
+                hashes.push_back(zobrist.hash(before, color));
+                king_plies = (BasicLogic<Rules>::is_king_move(before, mtx) ? king_plies + 1 : 0);
+                played.push_back(*pending);
+                pending.reset();
+                color = !color;
+                state = state_t::TURN;
+            }
+            if (state != state_t::TURN)
+                return;
+            const uint64_t hash = zobrist.hash(mtx, color);
+            if (int(played.size()) >= max_turns || count(hashes.begin(), hashes.end(), hash) >= 2 ||
+                (draw_plies && king_plies >= draw_plies))
+                finish(0);
+            else
+            {
+                auto logic = logics.acquire();
+                logic->find_turns(color, mtx);
+                if (logic->turns.empty())
+                    finish(color ? 1 : 2);
+                else
+                    current = turn_request{current.ticket + 1, color, mtx, logic->turns, hashes, king_plies};
+            }
+            if (state == state_t::FINISHED)
+            {
+                lock.unlock();
+                if (on_finish)
+                    on_finish(*this);
+                return;
+            }
+            state = state_t::WAITING;
+            const auto req = current;
+            const auto source = sources[color];
+            lock.unlock();
+            source->request(this->shared_from_this(), req);
+            return;
+        }
+    }
+
+    Scheduler &scheduler;
+    BasicLogicPool<Rules> &logics;
+    const source_ptr sources[2];
+    const int max_turns, draw_plies;
+    const function<void(BasicSession &)> on_finish;
+    static inline const BasicZobrist<Rules::size> &zobrist = BasicZobrist<Rules::size>::get();
+
+    mutable mutex m;
+    state_t state = state_t::IDLE;
+    // шаг партии уже стоит в очереди scheduler
+    bool queued = false;
+    vector<vector<POS_T>> mtx;
+    bool color = false;
+    // хэши позиций перед каждым сделанным полуходом
+    vector<uint64_t> hashes;
+    int king_plies = 0;
+    vector<move_pos> played;
+    turn_request current;
+    unique_ptr<move_pos> pending;
+    int res = -1;
+};
+
+/**
+ * Локальный движок: alpha-beta уровня level (как "WhiteBotLevel" / "BlackBotLevel") или по профилю
+ * сложности (Profile.h — с известной наибольшей стоимостью хода) задачей scheduler.
+ */
+template <class Rules> class BasicEngineSource : public BasicMoveSource<Rules>
+{
+  public:
+    BasicEngineSource(Scheduler &scheduler, BasicLogicPool<Rules> &logics, const int level)
+        : scheduler(scheduler), logics(logics), level(level)
+    {
+    }
+
+    BasicEngineSource(Scheduler &scheduler, BasicLogicPool<Rules> &logics, const search_profile &profile)
+        : scheduler(scheduler), logics(logics), level(0), profile(profile), use_profile(true)
+    {
+    }
+
+    // узлов поиска за всё время и наибольшее число узлов за один ход
+    uint64_t total_nodes() const
+    {
+        return nodes_total;
+    }
+
+    uint64_t max_nodes() const
+    {
+        return nodes_max;
+    }
+
+    void request(const shared_ptr<BasicSession<Rules>> &session, const turn_request &req) override
+    {
+        scheduler.post([this, session, req]() {
+            move_pos turn{-1, -1, -1, -1};
+            {
+                auto logic = logics.acquire();
+                logic->history = req.history;
+                logic->king_plies = req.king_plies;
+                logic->Max_depth = level;
+                if (use_profile)
+                    logic->find_profile_turns(req.color, req.mtx, profile);
+                else
+                    logic->find_best_turns(req.color, req.mtx);
+                turn = logic->last_turn;
+                nodes_total += logic->nodes;
+                uint64_t seen = nodes_max;
+                while (logic->nodes > seen && !nodes_max.compare_exchange_weak(seen, logic->nodes))
+                    ;
+            }
+            session->deliver(req.ticket, turn);
+        });
+    }
+
+  private:
+    Scheduler &scheduler;
+    BasicLogicPool<Rules> &logics;
+    const int level;
+    const search_profile profile;
+    const bool use_profile = false;
+    atomic<uint64_t> nodes_total{0}, nodes_max{0};
+};
+
+/**
+ * Ход приходит извне — от человека через интерфейс или от удалённого игрока по сети:
+ * запрос передаётся в notify, ответ — session->deliver(req.ticket, ...) когда угодно и из любого потока.
+ */
+template <class Rules> class BasicRemoteSource : public BasicMoveSource<Rules>
+{
+  public:
+    using callback = function<void(const shared_ptr<BasicSession<Rules>> &, const turn_request &)>;
+
+    explicit BasicRemoteSource(callback notify) : notify(std::move(notify))
+    {
+    }
+
+    void request(const shared_ptr<BasicSession<Rules>> &session, const turn_request &req) override
+    {
+        notify(session, req);
+    }
+
+  private:
+    const callback notify;
+};
+
+using Session = BasicSession<russian_rules>;
+using LogicPool = BasicLogicPool<russian_rules>;
+using EngineSource = BasicEngineSource<russian_rules>;
+using RemoteSource = BasicRemoteSource<russian_rules>;
@@ -0,0 +1,63 @@
+#pragma once
+
+/**
+ * Выбор SIMD-ядер во время выполнения (BatchEval, BatchMoveGen).
+ *
+ * GCC и Clang на x86 собирают ядра AVX2 и SSE4.1 в любой сборке: функции ядер помечены
+ * CHECKERS_TARGET_AVX2 / CHECKERS_TARGET_SSE41, остальной код остаётся под базовый x86-64,
+ * поэтому бинарник без -march=native работает на любом процессоре, а на новых берёт широкие ядра.
+ * Какие ядра вызывать, один раз решает cpu_simd() по cpuid.
+ * В MSVC атрибута target нет: ядро AVX2 есть, только если оно включено ключом /arch:AVX2.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #include <immintrin.h>
+    #define CHECKERS_SIMD_AVX2
+    #define CHECKERS_SIMD_SSE41
+    #define CHECKERS_TARGET_AVX2 __attribute__((target("avx2")))
+    #define CHECKERS_TARGET_SSE41 __attribute__((target("sse4.1")))
+    // ядро-шаблон встраивается в функцию с атрибутом target целиком (вместе с лямбдами и операциями дорожек)
+    #define CHECKERS_FLATTEN __attribute__((flatten))
+#elif defined(_MSC_VER) && defined(__AVX2__)
+    #include <immintrin.h>
+    #define CHECKERS_SIMD_AVX2
+    #define CHECKERS_TARGET_AVX2
+    #define CHECKERS_FLATTEN
+#endif
+
+// общий код ядер (шаблоны по ширине «дорожек») встраивается в функции с атрибутом target:
+// отдельно скомпилированный под базовый x86-64, он передавал бы векторы AVX не по ABI вызывающего
+#if defined(__GNUC__) || defined(__clang__)
+    #define CHECKERS_INLINE __attribute__((always_inline))
+#else
+    #define CHECKERS_INLINE
+#endif
+
+// набор инструкций ядер, от меньшего к большему
+enum class simd_level
+{
+    SCALAR,
+    SSE41,
+    AVX2
+};
+
+/**
+ * Лучший набор инструкций, который есть и у процессора, и среди собранных ядер.
+ */
+inline simd_level cpu_simd()
+{
+    static const simd_level level = []() {
+#if defined(CHECKERS_SIMD_SSE41)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return simd_level::AVX2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return simd_level::SSE41;
+        return simd_level::SCALAR;
+#elif defined(CHECKERS_SIMD_AVX2)
+        return simd_level::AVX2; // собрано с /arch:AVX2 — без AVX2 программа не запустится
+#else
+        return simd_level::SCALAR;
+#endif
+    }();
+    return level;
+}
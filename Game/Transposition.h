@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "../Models/Move.h"
+#include "../Models/Score.h"
+
+/**
+ * Таблица транспозиций: результаты уже просчитанных узлов по хешу позиции.
+ *
+ * Для узла хранится оставшаяся глубина, оценка, тип оценки (точная / нижняя /
+ * верхняя граница) и лучший найденный ход — он пробуется первым при повторном
+ * обходе и по нему восстанавливается главный вариант. Выигрыш и проигрыш
+ * хранятся с расстоянием от узла, а не от корня (см. score_to_tt).
+ * Размер — степень двойки, индекс — младшие биты ключа.
+ *
+ * Ход — полная серия взятий: клетки начала и конца, побитые фигуры и превращение, т. е. всё,
+ * что сравнивает move_pos::operator== (первая побитая фигура xb/yb не хранится — она берётся
+ * у совпавшего хода из списка сгенерированных).
+ *
+ * Таблица может быть общей для нескольких потоков поиска (сервер движка) без блокировок:
+ * запись — три 64-битных слова (check, score, data), где check = key ^ score ^ data.
+ * Если чтение попало на запись другого потока и слова «перемешались», проверка
+ * не сходится и запись считается отсутствующей.
+ */
+class TranspositionTable
+{
+  public:
+    enum : uint8_t
+    {
+        EXACT, ///< точная оценка
+        LOWER, ///< оценка не меньше score (отсечение по beta)
+        UPPER  ///< оценка не больше score (все ходы хуже alpha)
+    };
+
+    struct entry
+    {
+        uint64_t key = 0;
+        SCORE_T score = 0;
+        move_pos move{-1, -1, -1, -1};
+        uint8_t depth = 0;
+        uint8_t flag = EXACT;
+    };
+
+    explicit TranspositionTable(const size_t size_mb = 16)
+    {
+        resize(size_mb);
+    }
+
+    /**
+     * Пересоздаёт таблицу размером не больше size_mb мегабайт (все записи теряются).
+     * Не вызывать, пока таблицей пользуются другие потоки.
+     */
+    void resize(const size_t size_mb)
+    {
+        size_t count = 1;
+        while (count * 2 * sizeof(slot) <= size_mb * 1024 * 1024)
+            count *= 2;
+        table.reset(new slot[count]);
+        mask = count - 1;
+        clear();
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i <= mask; ++i)
+        {
+            table[i].check.store(0, std::memory_order_relaxed);
+            table[i].score.store(0, std::memory_order_relaxed);
+            table[i].data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Запись по ключу или пустое значение, если позиции в таблице нет.
+     */
+    std::optional<entry> probe(const uint64_t key) const
+    {
+        const slot &s = table[key & mask];
+        const uint64_t score = s.score.load(std::memory_order_relaxed);
+        const uint64_t data = s.data.load(std::memory_order_relaxed);
+        const uint64_t check = s.check.load(std::memory_order_relaxed);
+        if ((check ^ score ^ data) != key || !data)
+            return std::nullopt;
+        entry e;
+        e.key = key;
+        e.score = SCORE_T(uint32_t(score));
+        e.move.x = POS_T(data & 0xF);
+        e.move.y = POS_T((data >> 4) & 0xF);
+        e.move.x2 = POS_T((data >> 8) & 0xF);
+        e.move.y2 = POS_T((data >> 12) & 0xF);
+        e.depth = uint8_t(data >> 16);
+        e.flag = uint8_t((data >> 24) & 3);
+        e.move.crown = (data >> 26) & 1;
+        e.move.captured = (score >> 32) | (data >> 32) << 32;
+        return e;
+    }
+
+    /**
+     * Сохраняет результат узла. Запись той же позиции с большей глубиной не затирается.
+     */
+    void store(const uint64_t key, const int depth, const SCORE_T score, const uint8_t flag, const move_pos &move)
+    {
+        slot &s = table[key & mask];
+        const auto old = probe(key);
+        if (old && old->depth > depth)
+            return;
+        // score: оценка и младшие 32 бита маски побитых; data: клетки хода по 4 бита (доска до 10x10),
+        // глубина, тип оценки, превращение, бит 27 (всегда выставлен, чтобы пустой слот data == 0
+        // отличался от записи) и старшие биты маски
+        const uint64_t score_bits = uint64_t(uint32_t(score)) | (move.captured & 0xFFFFFFFFull) << 32;
+        const uint64_t data = uint64_t(move.x & 0xF) | uint64_t(move.y & 0xF) << 4 | uint64_t(move.x2 & 0xF) << 8 |
+                              uint64_t(move.y2 & 0xF) << 12 | uint64_t(uint8_t(depth)) << 16 |
+                              uint64_t(flag) << 24 | uint64_t(move.crown) << 26 | uint64_t(1) << 27 |
+                              (move.captured >> 32) << 32;
+        s.check.store(key ^ score_bits ^ data, std::memory_order_relaxed);
+        s.score.store(score_bits, std::memory_order_relaxed);
+        s.data.store(data, std::memory_order_relaxed);
+    }
+
+  private:
+    struct slot
+    {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> score{0};
+        std::atomic<uint64_t> data{0};
+    };
+
+    std::unique_ptr<slot[]> table;
+    size_t mask = 0;
+};
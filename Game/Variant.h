@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+
+/**
+ * Правила вариантов шашек — политики времени компиляции для BasicLogic, BasicZobrist и таблиц диагоналей.
+ *
+ * Размер доски и каждое правило — constexpr-константы: генератор ходов и поиск инстанцируются
+ * для варианта отдельно, ветви чужих правил отбрасываются через if constexpr, поэтому
+ * горячий путь 8x8 остаётся тем же кодом, что и до появления 10x10.
+ * Вариант игры выбирается в settings.json ("Game" → "Variant", значение — name).
+ */
+
+// что происходит, когда шашка во время взятия встаёт на последний ряд
+enum class crowning
+{
+    continue_as_king, ///< сразу становится дамкой и продолжает бить как дамка (русские)
+    ends_series,      ///< становится дамкой, и серия на этом заканчивается (английские)
+    at_series_end     ///< проходит ряд шашкой; дамкой — только если серия там закончилась (международные)
+};
+
+// русские шашки: 8x8, шашки бьют назад, дальнобойные дамки, бить можно любую серию
+struct russian_rules
+{
+    static constexpr const char *name = "Russian";
+    static constexpr int size = 8;
+    static constexpr bool men_capture_backwards = true;
+    static constexpr bool flying_kings = true;
+    static constexpr bool majority_capture = false;
+    static constexpr crowning crown = crowning::continue_as_king;
+};
+
+// английские (американские) шашки: 8x8, шашки бьют только вперёд, дамки ходят и бьют на одну клетку
+struct english_rules
+{
+    static constexpr const char *name = "English";
+    static constexpr int size = 8;
+    static constexpr bool men_capture_backwards = false;
+    static constexpr bool flying_kings = false;
+    static constexpr bool majority_capture = false;
+    static constexpr crowning crown = crowning::ends_series;
+};
+
+// международные шашки: 10x10, как русские, но бить обязательно серию с наибольшим числом взятых фигур
+struct international_rules
+{
+    static constexpr const char *name = "International";
+    static constexpr int size = 10;
+    static constexpr bool men_capture_backwards = true;
+    static constexpr bool flying_kings = true;
+    static constexpr bool majority_capture = true;
+    static constexpr crowning crown = crowning::at_series_end;
+};
+
+/**
+ * Вызывает f(Rules{}) для варианта с именем name; неизвестное имя — русские шашки.
+ */
+template <class F> void with_variant(const std::string &name, F &&f)
+{
+    if (name == english_rules::name)
+        f(english_rules{});
+    else if (name == international_rules::name)
+        f(international_rules{});
+    else
+        f(russian_rules{});
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <nlohmann/json.hpp>
+
+/**
+ * Веса оценки "NumberAndPotential".
+ *
+ * man[r] — стоимость шашки, продвинувшейся на r рядов от своего края,
+ * king   — стоимость дамки (в тех же единицах).
+ * Значения по умолчанию совпадают с прежними константами calc_score:
+ * 1 + 0.05 * r для шашки и 5 для дамки.
+ *
+ * Файл весов — JSON вида {"Man": [8 чисел], "King": число};
+ * его пишет checkers_tuner, а Logic читает при создании.
+ */
+struct EvalWeights
+{
+    double man[8] = {1.0, 1.05, 1.10, 1.15, 1.20, 1.25, 1.30, 1.35};
+    double king = 5.0;
+
+    /**
+     * Загружает веса из JSON-файла. При ошибке оставляет текущие значения и возвращает false.
+     */
+    bool load(const std::string &path)
+    {
+        std::ifstream fin(path);
+        if (!fin)
+            return false;
+        auto data = nlohmann::json::parse(fin, nullptr, false, true);
+        if (data.is_discarded() || !data.contains("Man") || !data.contains("King") || data["Man"].size() != 8)
+            return false;
+        for (int r = 0; r < 8; ++r)
+            man[r] = data["Man"][r];
+        king = data["King"];
+        return true;
+    }
+
+    /**
+     * Сохраняет веса в JSON-файл; extra — дополнительные поля (например, параметры подбора).
+     */
+    bool save(const std::string &path, const nlohmann::json &extra = nlohmann::json::object()) const
+    {
+        nlohmann::json data = extra;
+        data["Man"] = man;
+        data["King"] = king;
+        std::ofstream fout(path, std::ios_base::trunc);
+        fout << data.dump(2) << "\n";
+        return bool(fout);
+    }
+};
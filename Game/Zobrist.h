@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "Diagonals.h"
+
+/**
+ * Ключи Зобриста для хеширования позиций.
+ *
+ * Хеш позиции — XOR ключей всех фигур (тип × клетка) и ключа side, если ходят чёрные.
+ * Ключи строятся детерминированно (splitmix64 от фиксированного зерна), поэтому хеш
+ * одной и той же позиции одинаков во всех запусках и процессах.
+ * Ключи свои для каждого размера доски N; для 8x8 они те же, что и до появления вариантов.
+ */
+template <int N> class BasicZobrist
+{
+  public:
+    static const BasicZobrist &get()
+    {
+        static const BasicZobrist keys;
+        return keys;
+    }
+
+    /**
+     * Полный хеш позиции: mtx и сторона хода color (0 = белые, 1 = чёрные).
+     */
+    uint64_t hash(const std::vector<std::vector<POS_T>> &mtx, const bool color) const
+    {
+        uint64_t h = color ? side : 0;
+        for (POS_T i = 0; i < N; ++i)
+            for (POS_T j = 0; j < N; ++j)
+                if (mtx[i][j])
+                    h ^= piece[mtx[i][j]][i][j];
+        return h;
+    }
+
+    /**
+     * Хеш после хода turn из позиции mtx (до хода); повторяет правила make_turn:
+     * снимаются все побитые фигуры серии, превращение — по turn.crown.
+     * Сторона хода не меняется — при передаче хода нужно отдельно сделать ^= side.
+     */
+    uint64_t after(uint64_t h, const std::vector<std::vector<POS_T>> &mtx, const move_pos &turn) const
+    {
+        const POS_T type = mtx[turn.x][turn.y];
+        h ^= piece[type][turn.x][turn.y];
+        for_each_square<N>(turn.captured, [&](const POS_T i, const POS_T j) { h ^= piece[mtx[i][j]][i][j]; });
+        return h ^ piece[type + (turn.crown ? 2 : 0)][turn.x2][turn.y2];
+    }
+
+    // ключи фигур: [тип 1..4][x][y]
+    uint64_t piece[5][N][N];
+    // ключ хода чёрных
+    uint64_t side;
+    // ключ цвета, за который ведётся поиск (оценки в таблице — с его точки зрения)
+    uint64_t root[2];
+
+  private:
+    BasicZobrist()
+    {
+        uint64_t state = 0x4B1D5EEDC0FFEEull;
+        auto next = [&state]() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        };
+        for (auto &type : piece)
+            for (auto &row : type)
+                for (auto &key : row)
+                    key = next();
+        side = next();
+        root[0] = next();
+        root[1] = next();
+    }
+};
+
+// ключи доски 8x8
+using Zobrist = BasicZobrist<8>;
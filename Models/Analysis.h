@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+
+#include "Move.h"
+#include "Score.h"
+
+/**
+ * Одна линия анализа (результат multi-PV поиска).
+ *
+ * pv[0] — ход корня (серия ходов одной стороны, как у Logic::find_best_turns),
+ * pv[1] — ответ соперника и т.д. по главному варианту;
+ * score — точная оценка линии в шкале поиска (Models/Score.h, больше — лучше для стороны корня).
+ */
+struct analysis_line
+{
+    std::vector<std::vector<move_pos>> pv;
+    SCORE_T score = 0;
+};
@@ -1,14 +1,23 @@
 #pragma once
+#include <stdint.h>
 #include <stdlib.h>
 
 typedef int8_t POS_T; // тип координаты на доске (-128..127)
 
-// Структура описывает один возможный ход фигуры
+/**
+ * Ход фигуры: тихий ход, один прыжок серии взятий или вся серия целиком.
+ *
+ * Генератор ходов (BasicLogic::find_turns) выдаёт полные серии: (x, y) → (x2, y2) — начало и конец
+ * серии, xb/yb — первая побитая фигура, captured — все побитые. Прыжки серии по отдельности
+ * (для анимации и записи ходов) — тот же move_pos с одной побитой фигурой.
+ */
 struct move_pos
 {
     POS_T x, y;             // исходная клетка (откуда ходим)
     POS_T x2, y2;           // целевая клетка (куда ходим)
     POS_T xb = -1, yb = -1; // клетка побитой фигуры (если есть взятие), -1 = нет
+    bool crown = false;     // шашка становится дамкой этим ходом
+    uint64_t captured = 0;  // побитые фигуры: маска тёмных клеток, бит (x * N + y) / 2 (см. square_bit)
 
     // Конструктор: обычный ход без побитой фигуры
     move_pos(const POS_T x, const POS_T y, const POS_T x2, const POS_T y2)
@@ -23,11 +32,13 @@ struct move_pos
     {
     }
 
-    // Сравнение двух ходов: равны, если совпадает начальная и конечная клетка
+    // Сравнение двух ходов: равны, если совпадают начальная и конечная клетка, побитые фигуры
+    // и превращение — т. е. позиция после хода (порядок прыжков серии не важен)
     bool operator==(const move_pos &other) const
     {
         return (x == other.x && y == other.y &&
-                x2 == other.x2 && y2 == other.y2);
+                x2 == other.x2 && y2 == other.y2 &&
+                captured == other.captured && crown == other.crown);
     }
 
     // Неравенство реализовано через оператор ==
@@ -0,0 +1,156 @@
+#pragma once
+#include <cctype>
+#include <string>
+#include <vector>
+
+#include "Move.h"
+
+/**
+ * Текстовая нотация позиций и ходов (PDN, русские шашки).
+ *
+ * Клетка (x, y) доски записывается как "c3": буква — столбец y (a..h),
+ * цифра — ряд 8 - x (белые внизу, a1 = (7, 0)).
+ * Ход — клетки через "-" (тихий ход) или ":" (взятие, серия: "c3:e5:c7").
+ * Позиция (FEN) — "W:Wa1,c3,Kd4:Bf6,h8": сторона хода, белые, чёрные; K — дамка.
+ */
+
+inline std::string cell_name(const POS_T x, const POS_T y)
+{
+    return std::string(1, char('a' + y)) + char('0' + (8 - x));
+}
+
+/**
+ * Разбирает клетку вида "c3" (регистр буквы не важен). Возвращает false для неверной записи.
+ */
+inline bool parse_cell(const std::string &s, POS_T &x, POS_T &y)
+{
+    if (s.size() != 2)
+        return false;
+    const char col = char(tolower(s[0])), row = s[1];
+    if (col < 'a' || col > 'h' || row < '1' || row > '8')
+        return false;
+    x = POS_T(8 - (row - '0'));
+    y = POS_T(col - 'a');
+    return true;
+}
+
+/**
+ * Записывает серию ходов одной стороны (например, цепочку взятий) одной строкой.
+ */
+inline std::string series_name(const std::vector<move_pos> &turns)
+{
+    if (turns.empty())
+        return "";
+    std::string res = cell_name(turns[0].x, turns[0].y);
+    for (const auto &turn : turns)
+        res += std::string(turn.xb != -1 ? ":" : "-") + cell_name(turn.x2, turn.y2);
+    return res;
+}
+
+/**
+ * Разбирает запись хода на список клеток: "c3-d4" → {c3, d4}, "c3:e5:c7" / "c3xe5" → {c3, e5, c7}.
+ * Отбрасывает завершающие пометки ("!", "?", "*"). Возвращает пустой список при ошибке.
+ */
+inline std::vector<std::pair<POS_T, POS_T>> parse_series(std::string s)
+{
+    while (!s.empty() && (s.back() == '!' || s.back() == '?' || s.back() == '*' || s.back() == '+'))
+        s.pop_back();
+    std::vector<std::pair<POS_T, POS_T>> cells;
+    size_t begin = 0;
+    while (begin <= s.size())
+    {
+        size_t end = s.find_first_of("-:x", begin);
+        if (end == std::string::npos)
+            end = s.size();
+        POS_T x, y;
+        if (!parse_cell(s.substr(begin, end - begin), x, y))
+            return {};
+        cells.emplace_back(x, y);
+        begin = end + 1;
+    }
+    if (cells.size() < 2)
+        return {};
+    return cells;
+}
+
+/**
+ * Стартовая расстановка доски n×n (как Board::make_start_mtx): чёрные (2) в верхних (n - 2) / 2 рядах,
+ * белые (1) в нижних — для 8x8 это ряды 0..2 и 5..7, для 10x10 — 0..3 и 6..9.
+ */
+inline std::vector<std::vector<POS_T>> start_position(const int n = 8)
+{
+    const int rows = (n - 2) / 2;
+    std::vector<std::vector<POS_T>> mtx(n, std::vector<POS_T>(n, 0));
+    for (POS_T i = 0; i < n; ++i)
+        for (POS_T j = 0; j < n; ++j)
+            if ((i + j) % 2 == 1)
+                mtx[i][j] = (i < rows ? 2 : (i >= n - rows ? 1 : 0));
+    return mtx;
+}
+
+/**
+ * Позиция в FEN: color — кто ходит (0 = белые, 1 = чёрные).
+ */
+inline std::string to_fen(const std::vector<std::vector<POS_T>> &mtx, const bool color)
+{
+    std::string white, black;
+    for (POS_T i = 7; i >= 0; --i)
+    {
+        for (POS_T j = 0; j < 8; ++j)
+        {
+            if (!mtx[i][j])
+                continue;
+            std::string &side = (mtx[i][j] % 2 ? white : black);
+            if (!side.empty())
+                side += ",";
+            side += (mtx[i][j] > 2 ? "K" : "") + cell_name(i, j);
+        }
+    }
+    return std::string(color ? "B" : "W") + ":W" + white + ":B" + black;
+}
+
+/**
+ * Разбирает FEN вида "W:Wa1,Kc3:Bh8" (допускаются кавычки и пробелы). Возвращает false при ошибке.
+ */
+inline bool parse_fen(std::string fen, std::vector<std::vector<POS_T>> &mtx, bool &color)
+{
+    std::string clean;
+    for (char c : fen)
+        if (c != '"' && c != ' ' && c != '.')
+            clean += c;
+    if (clean.size() < 2 || (clean[0] != 'W' && clean[0] != 'B') || clean[1] != ':')
+        return false;
+    color = (clean[0] == 'B');
+    mtx.assign(8, std::vector<POS_T>(8, 0));
+    size_t pos = 2;
+    while (pos < clean.size())
+    {
+        size_t end = clean.find(':', pos);
+        if (end == std::string::npos)
+            end = clean.size();
+        const std::string part = clean.substr(pos, end - pos);
+        pos = end + 1;
+        if (part.empty())
+            continue;
+        const POS_T piece = (part[0] == 'W' ? 1 : (part[0] == 'B' ? 2 : 0));
+        if (!piece)
+            return false;
+        size_t begin = 1;
+        while (begin < part.size())
+        {
+            size_t comma = part.find(',', begin);
+            if (comma == std::string::npos)
+                comma = part.size();
+            std::string cell = part.substr(begin, comma - begin);
+            begin = comma + 1;
+            if (cell.empty())
+                continue;
+            const bool king = (cell[0] == 'K');
+            POS_T x, y;
+            if (!parse_cell(king ? cell.substr(1) : cell, x, y))
+                return false;
+            mtx[x][y] = POS_T(piece + (king ? 2 : 0));
+        }
+    }
+    return true;
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Move.h"
+
+/**
+ * Компактная запись позиции с меткой результата партии (13 байт) —
+ * формат обучающих данных для checkers_tuner.
+ *
+ * Тёмная клетка (i, j) имеет номер i * 4 + j / 2 (0..31), бит с этим номером
+ * выставлен в white/black, если там стоит фигура соответствующего цвета,
+ * и в kings, если это дамка.
+ * meta: биты 0-1 — результат для белых (0 — поражение, 1 — ничья, 2 — победа),
+ *       бит 2 — сторона хода (0 — белые, 1 — чёрные).
+ */
+struct packed_position
+{
+    uint32_t white = 0, black = 0, kings = 0;
+    uint8_t meta = 0;
+
+    static constexpr size_t kBytes = 13;
+
+    static packed_position pack(const std::vector<std::vector<POS_T>> &mtx, const bool color, const int result)
+    {
+        packed_position pos;
+        for (POS_T i = 0; i < 8; ++i)
+        {
+            for (POS_T j = 0; j < 8; ++j)
+            {
+                if (!mtx[i][j])
+                    continue;
+                const uint32_t bit = 1u << (i * 4 + j / 2);
+                (mtx[i][j] % 2 ? pos.white : pos.black) |= bit;
+                if (mtx[i][j] > 2)
+                    pos.kings |= bit;
+            }
+        }
+        pos.meta = uint8_t(result | (color << 2));
+        return pos;
+    }
+
+    std::vector<std::vector<POS_T>> unpack() const
+    {
+        std::vector<std::vector<POS_T>> mtx(8, std::vector<POS_T>(8, 0));
+        for (int sq = 0; sq < 32; ++sq)
+        {
+            const uint32_t bit = 1u << sq;
+            const int i = sq / 4, j = sq % 4 * 2 + (i % 2 == 0);
+            if (white & bit)
+                mtx[i][j] = (kings & bit) ? 3 : 1;
+            else if (black & bit)
+                mtx[i][j] = (kings & bit) ? 4 : 2;
+        }
+        return mtx;
+    }
+
+    int result() const
+    {
+        return meta & 3;
+    }
+
+    bool color() const
+    {
+        return (meta >> 2) & 1;
+    }
+
+    void write(char *buf) const
+    {
+        memcpy(buf, &white, 4);
+        memcpy(buf + 4, &black, 4);
+        memcpy(buf + 8, &kings, 4);
+        buf[12] = char(meta);
+    }
+
+    void read(const char *buf)
+    {
+        memcpy(&white, buf, 4);
+        memcpy(&black, buf + 4, 4);
+        memcpy(&kings, buf + 8, 4);
+        meta = uint8_t(buf[12]);
+    }
+};
+
+/**
+ * Файл позиций: заголовок "CKPS" + uint32 версия, затем записи по packed_position::kBytes.
+ * Количество записей определяется по размеру файла, поэтому писать можно потоково.
+ */
+class PositionWriter
+{
+  public:
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kHeader = 8;
+
+    explicit PositionWriter(const std::string &path) : fout(path, std::ios::binary | std::ios::trunc)
+    {
+        fout.write("CKPS", 4);
+        fout.write(reinterpret_cast<const char *>(&kVersion), 4);
+    }
+
+    void add(const packed_position &pos)
+    {
+        char buf[packed_position::kBytes];
+        pos.write(buf);
+        fout.write(buf, sizeof(buf));
+        ++count;
+    }
+
+    bool ok() const
+    {
+        return bool(fout);
+    }
+
+    size_t count = 0;
+
+  private:
+    std::ofstream fout;
+};
+
+/**
+ * Потоковое чтение файла позиций блоками; каждый поток может открыть свой PositionReader
+ * и читать свой диапазон записей.
+ */
+class PositionReader
+{
+  public:
+    explicit PositionReader(const std::string &path) : fin(path, std::ios::binary)
+    {
+        char magic[4];
+        uint32_t version = 0;
+        fin.read(magic, 4);
+        fin.read(reinterpret_cast<char *>(&version), 4);
+        if (!fin || memcmp(magic, "CKPS", 4) != 0 || version != PositionWriter::kVersion)
+        {
+            fin.setstate(std::ios::failbit);
+            return;
+        }
+        fin.seekg(0, std::ios::end);
+        total = (size_t(fin.tellg()) - PositionWriter::kHeader) / packed_position::kBytes;
+    }
+
+    bool ok() const
+    {
+        return !fin.fail();
+    }
+
+    /**
+     * Читает до n записей начиная с записи first в out. Возвращает число прочитанных.
+     */
+    size_t read(const size_t first, const size_t n, std::vector<packed_position> &out)
+    {
+        const size_t cnt = (first >= total ? 0 : std::min(n, total - first));
+        buf.resize(cnt * packed_position::kBytes);
+        out.resize(cnt);
+        fin.clear();
+        fin.seekg(std::streamoff(PositionWriter::kHeader + first * packed_position::kBytes));
+        fin.read(buf.data(), std::streamsize(buf.size()));
+        for (size_t k = 0; k < cnt; ++k)
+            out[k].read(buf.data() + k * packed_position::kBytes);
+        return cnt;
+    }
+
+    size_t total = 0;
+
+  private:
+    std::ifstream fin;
+    std::vector<char> buf;
+};
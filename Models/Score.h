@@ -0,0 +1,66 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * Целочисленные оценки поиска: с точки зрения стороны корня, больше — лучше.
+ *
+ * Обычная оценка — отношение сил сторон в фиксированной точке Q16 (как у BatchEval):
+ * SCORE_ONE — силы равны. Выигрыш и проигрыш хранят расстояние в полуходах от корня:
+ * win_in(n) = INF - n, loss_in(n) = n, поэтому быстрый выигрыш лучше медленного,
+ * а проигрыш тем лучше, чем он дальше. Обычные оценки зажаты между этими диапазонами.
+ */
+typedef int32_t SCORE_T;
+
+const SCORE_T INF = 1000000000;
+
+// наибольшее расстояние до конца партии, которое различает шкала
+const int MAX_PLY = 1024;
+
+// равенство сил, 1.0 в Q16 (равно BatchEval::kOne)
+const SCORE_T SCORE_ONE = 1 << 16;
+
+// оценка ничьей (повторение позиции, правило ходов дамками): силы сторон равны
+const SCORE_T DRAW = SCORE_ONE;
+
+inline SCORE_T win_in(const int ply)
+{
+    return INF - ply;
+}
+
+inline SCORE_T loss_in(const int ply)
+{
+    return ply;
+}
+
+inline bool is_win(const SCORE_T score)
+{
+    return score >= INF - MAX_PLY;
+}
+
+inline bool is_loss(const SCORE_T score)
+{
+    return score <= MAX_PLY;
+}
+
+/**
+ * Обычная оценка из отношения сил в Q16: зажимается, чтобы не попасть в диапазоны выигрыша и проигрыша.
+ */
+inline SCORE_T clamp_score(const int64_t q16)
+{
+    return SCORE_T(std::min<int64_t>(std::max<int64_t>(q16, MAX_PLY + 1), INF - MAX_PLY - 1));
+}
+
+/**
+ * Перевод для таблицы транспозиций: в таблице выигрыш и проигрыш считаются от узла
+ * (ply полуходов от корня), а не от корня, — иначе запись неверна при другом корне.
+ */
+inline SCORE_T score_to_tt(const SCORE_T score, const int ply)
+{
+    return is_win(score) ? score + ply : is_loss(score) ? score - ply : score;
+}
+
+inline SCORE_T score_from_tt(const SCORE_T score, const int ply)
+{
+    return is_win(score) ? score - ply : is_loss(score) ? score + ply : score;
+}
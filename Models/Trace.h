@@ -0,0 +1,165 @@
+#pragma once
+
+/**
+ * Трассировка игрового цикла в формате Chrome Trace Event (chrome://tracing, ui.perfetto.dev).
+ *
+ * TRACE_SCOPE("Board::redraw") отмечает интервал от этой строки до конца блока,
+ * TRACE_THREAD("search") подписывает поток, TRACE_WRITE(path) записывает все интервалы в JSON.
+ * Без CHECKERS_TRACE (опция CMake) макросы пустые и в код не попадают.
+ *
+ * С ней интервал стоит два чтения счётчика тактов (rdtsc; на других процессорах — steady_clock)
+ * и запись в буфер своего потока без блокировок: несколько наносекунд сверх самих rdtsc, поэтому
+ * трассировку можно оставлять и в релизной сборке. Буфер потока заранее рассчитан на 65536 интервалов;
+ * дальше он растёт как vector, и интервал, на котором буфер переполнился, платит за выделение памяти
+ * и копирование. Первый интервал потока ещё и регистрирует буфер под мьютексом.
+ * Такты переводятся в микросекунды только при записи файла, по калибровке steady_clock от создания реестра
+ * (первый TRACE_THREAD или конец первого интервала) до записи. Буферы живут дольше потоков
+ * (поток поиска бота завершается после хода), TRACE_WRITE вызывается, когда остальные потоки закончили.
+ */
+#ifdef CHECKERS_TRACE
+    #include <chrono>
+    #include <cstdint>
+    #include <fstream>
+    #include <memory>
+    #include <mutex>
+    #include <string>
+    #include <vector>
+    #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        #include <intrin.h>
+        #define CHECKERS_TRACE_RDTSC
+    #elif defined(__x86_64__) || defined(__i386__)
+        #include <x86intrin.h>
+        #define CHECKERS_TRACE_RDTSC
+    #endif
+
+namespace trace
+{
+inline uint64_t ticks()
+{
+    #ifdef CHECKERS_TRACE_RDTSC
+    return __rdtsc();
+    #else
+    return uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+    #endif
+}
+
+// законченный интервал: имя — строковый литерал, границы — в тактах ticks()
+struct event
+{
+    const char *name;
+    uint64_t begin, end;
+};
+
+struct thread_buffer
+{
+    int tid = 0;
+    std::string name;
+    std::vector<event> events;
+};
+
+// буфер текущего потока (nullptr до первого интервала); владеет им registry
+inline thread_local thread_buffer *local_buffer = nullptr;
+
+class registry
+{
+  public:
+    static registry &get()
+    {
+        static registry r;
+        return r;
+    }
+
+    // буфер текущего потока (создаётся при первом интервале потока)
+    static thread_buffer &local()
+    {
+        if (!local_buffer)
+            local_buffer = get().add();
+        return *local_buffer;
+    }
+
+    /**
+     * Пишет интервалы всех потоков в path как события "X" (complete) Chrome Trace Event.
+     */
+    bool write(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const double elapsed_us =
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count();
+        const uint64_t elapsed_ticks = ticks() - start_ticks;
+        const double us_per_tick = (elapsed_ticks ? elapsed_us / double(elapsed_ticks) : 0.0);
+        std::ofstream fout(path, std::ios_base::trunc);
+        fout << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        for (const auto &buffer : buffers)
+        {
+            if (!buffer->name.empty())
+            {
+                fout << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                     << buffer->tid << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+                first = false;
+            }
+            for (const auto &e : buffer->events)
+            {
+                fout << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                     << buffer->tid << ",\"ts\":" << double(int64_t(e.begin - start_ticks)) * us_per_tick
+                     << ",\"dur\":" << double(e.end - e.begin) * us_per_tick << "}";
+                first = false;
+            }
+        }
+        fout << "\n]}\n";
+        return bool(fout);
+    }
+
+  private:
+    registry() = default;
+
+    thread_buffer *add()
+    {
+        auto buffer = std::make_unique<thread_buffer>();
+        buffer->events.reserve(1 << 16);
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer->tid = int(buffers.size()) + 1;
+        buffers.push_back(std::move(buffer));
+        return buffers.back().get();
+    }
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<thread_buffer>> buffers;
+    // калибровка тактов: отсчёт ведётся от создания реестра
+    const uint64_t start_ticks = ticks();
+    const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+};
+
+// интервал от создания до конца блока
+class span
+{
+  public:
+    explicit span(const char *name) : name(name), begin(ticks())
+    {
+    }
+
+    ~span()
+    {
+        const uint64_t end = ticks();
+        registry::local().events.push_back({name, begin, end});
+    }
+
+    span(const span &) = delete;
+    span &operator=(const span &) = delete;
+
+  private:
+    const char *name;
+    const uint64_t begin;
+};
+} // namespace trace
+
+    #define CHECKERS_TRACE_CONCAT2(a, b) a##b
+    #define CHECKERS_TRACE_CONCAT(a, b) CHECKERS_TRACE_CONCAT2(a, b)
+    #define TRACE_SCOPE(name) const trace::span CHECKERS_TRACE_CONCAT(trace_span_, __LINE__)(name)
+    #define TRACE_THREAD(thread_name) (trace::registry::local().name = (thread_name))
+    #define TRACE_WRITE(path) trace::registry::get().write(path)
+#else
+    #define TRACE_SCOPE(name) ((void)0)
+    #define TRACE_THREAD(thread_name) ((void)0)
+    #define TRACE_WRITE(path) ((void)0)
+#endif
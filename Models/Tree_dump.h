@@ -0,0 +1,282 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Move.h"
+#include "Score.h"
+
+/**
+ * Дамп дерева поиска alpha-beta (BasicLogic::find_best_turns_rec) для разбора отсечений.
+ *
+ * Файл — заголовок tree_dump_header и записи tree_record по 20 байт (порядок байтов машины).
+ * Запись узла пишется при выходе из него, поэтому дети идут раньше родителя, и дерево
+ * восстанавливается по одним глубинам, без ссылок (так читает checkers_tree, Tools/tree.cpp).
+ * Каждый поиск (start_search) открывается записью SEARCH: глубина поиска и цвет корня.
+ * Записей не больше limit, следующие узлы только считаются (dropped): в файле остаются
+ * законченные поддеревья начала поиска. Листья пакетной оценки после отсечения не пишутся (их оценили,
+ * но не рассматривали), поэтому узлов в дампе бывает меньше, чем BasicLogic::nodes.
+ *
+ * Запись собирается только с опцией CMake CHECKERS_TREE_DUMP и включается настройкой "TreeDumpFile";
+ * без опции макросы TREE_* пустые и поиск компилируется как обычно.
+ */
+
+// вид узла (младшие 4 бита tree_record::flags)
+enum class tree_kind : uint8_t
+{
+    NODE = 0,       // ходы перебирались (с отсечением или без)
+    LEAF = 1,       // оценка на предельной глубине
+    BATCH_LEAF = 2, // лист из пакетной оценки предпоследнего уровня
+    TT = 3,         // закрыт оценкой из таблицы транспозиций
+    DRAW = 4,       // повторение позиции или правило ходов дамками
+    MATE_PRUNE = 5, // отсечение по расстоянию до конца партии
+    NO_MOVES = 6,   // ходов нет — конец партии
+    ABORTED = 7,    // поиск прерван ограничениями, оценка неполная
+    SEARCH = 8      // начало поиска (не узел)
+};
+
+struct tree_record
+{
+    // окно узла при входе и возвращённая оценка (с точки зрения стороны корня)
+    SCORE_T alpha, beta, score;
+    // глубина узла: 0 — ход корня; у SEARCH — глубина поиска (Max_depth)
+    uint8_t depth;
+    // ход в узел: клетки (x << 4) | y; у SEARCH from — цвет корня
+    uint8_t from, to;
+    // вид узла | NULL_WINDOW | RESEARCH | CAPTURE
+    uint8_t flags;
+    // ходов в узле (не больше 255)
+    uint8_t moves;
+    // номер хода в списке родителя (порядок перебора), лучшего хода узла и хода, давшего отсечение
+    uint8_t order, best, cut;
+
+    static constexpr uint8_t NULL_WINDOW = 16; // окно нулевой ширины (проверка PVS)
+    static constexpr uint8_t RESEARCH = 32;    // повторный поиск хода после проверки нулевым окном
+    static constexpr uint8_t CAPTURE = 64;     // ход в узел — взятие
+    static constexpr uint8_t NONE = 255;       // нет лучшего хода / отсечения
+
+    tree_kind kind() const
+    {
+        return tree_kind(flags & 15);
+    }
+};
+static_assert(sizeof(tree_record) == 20, "tree_record is a file format");
+
+struct tree_dump_header
+{
+    char magic[8];
+    uint32_t board;       // клеток в ряду доски
+    uint32_t record_size; // sizeof(tree_record)
+    uint64_t records;     // записей в файле
+    uint64_t dropped;     // узлов сверх limit, не попавших в файл
+    uint64_t limit;
+};
+
+inline constexpr char kTreeDumpMagic[8] = "CKTREE1";
+
+/**
+ * Запись дерева в файл: буфер в памяти, сброс по 64K записей и в деструкторе
+ * (там же в заголовок пишутся итоговые счётчики).
+ */
+class SearchTreeWriter
+{
+  public:
+    SearchTreeWriter(const std::string &path, const int board, const uint64_t limit)
+        : out(path, std::ios_base::binary | std::ios_base::trunc)
+    {
+        std::memcpy(header.magic, kTreeDumpMagic, sizeof(header.magic));
+        header.board = uint32_t(board);
+        header.record_size = sizeof(tree_record);
+        header.records = header.dropped = 0;
+        header.limit = limit;
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        buffer.reserve(kFlush);
+    }
+
+    SearchTreeWriter(const SearchTreeWriter &) = delete;
+    SearchTreeWriter &operator=(const SearchTreeWriter &) = delete;
+
+    ~SearchTreeWriter()
+    {
+        flush();
+        out.seekp(0);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+
+    bool ok() const
+    {
+        return bool(out);
+    }
+
+    // начало поиска на глубину depth за цвет color
+    void search(const bool color, const int depth)
+    {
+        tree_record r{};
+        r.depth = uint8_t(depth);
+        r.from = uint8_t(color);
+        r.flags = uint8_t(tree_kind::SEARCH);
+        r.best = r.cut = tree_record::NONE;
+        write(r);
+    }
+
+    // ход turn (номер order в списке родителя) ведёт в узел глубины depth, который будет искаться следующим
+    void child(const size_t depth, const move_pos &turn, const size_t order, const bool research)
+    {
+        tree_record &r = next[depth & 255];
+        r.from = square(turn.x, turn.y);
+        r.to = square(turn.x2, turn.y2);
+        r.order = uint8_t(std::min<size_t>(order, tree_record::NONE));
+        r.flags = uint8_t((research ? tree_record::RESEARCH : 0) | (turn.xb != -1 ? tree_record::CAPTURE : 0));
+    }
+
+    // тот же ход в узел глубины depth ищется ещё раз (после проверки нулевым окном)
+    void research(const size_t depth)
+    {
+        next[depth & 255].flags |= tree_record::RESEARCH;
+    }
+
+    // лист пакетной оценки: ход turn из узла глубины depth - 1 с окном (alpha, beta)
+    void leaf(const move_pos &turn, const size_t order, const size_t depth, const SCORE_T alpha, const SCORE_T beta,
+              const SCORE_T score)
+    {
+        child(depth, turn, order, false);
+        tree_record r = enter(depth, alpha, beta);
+        r.score = score;
+        r.flags |= uint8_t(tree_kind::BATCH_LEAF);
+        write(r);
+    }
+
+    // запись узла глубины depth с окном (alpha, beta): ход в узел — из последнего child для этой глубины
+    tree_record enter(const size_t depth, const SCORE_T alpha, const SCORE_T beta)
+    {
+        tree_record r = next[depth & 255];
+        r.alpha = alpha;
+        r.beta = beta;
+        r.depth = uint8_t(depth);
+        if (beta - alpha == 1)
+            r.flags |= tree_record::NULL_WINDOW;
+        r.best = r.cut = tree_record::NONE;
+        return r;
+    }
+
+    void write(const tree_record &r)
+    {
+        if (header.records == header.limit)
+        {
+            ++header.dropped;
+            return;
+        }
+        ++header.records;
+        buffer.push_back(r);
+        if (buffer.size() == kFlush)
+            flush();
+    }
+
+  private:
+    static constexpr size_t kFlush = 1 << 16;
+
+    static uint8_t square(const POS_T x, const POS_T y)
+    {
+        return uint8_t((x << 4) | y);
+    }
+
+    void flush()
+    {
+        out.write(reinterpret_cast<const char *>(buffer.data()), std::streamsize(buffer.size() * sizeof(tree_record)));
+        buffer.clear();
+    }
+
+    std::ofstream out;
+    tree_dump_header header;
+    std::vector<tree_record> buffer;
+    // ход в следующий узел каждой глубины (см. child): повторный поиск хода корня идёт после его поддерева
+    tree_record next[256] = {};
+};
+
+/**
+ * Узел в процессе поиска: запоминает окно при входе, пишет запись при выходе (leave).
+ * Без writer ничего не делает.
+ */
+class tree_node
+{
+  public:
+    tree_node(SearchTreeWriter *writer, const size_t depth, const SCORE_T alpha, const SCORE_T beta)
+        : writer(writer)
+    {
+        if (writer)
+            rec = writer->enter(depth, alpha, beta);
+    }
+
+    SCORE_T leave(const tree_kind kind, const SCORE_T score)
+    {
+        if (writer)
+        {
+            rec.flags |= uint8_t(kind);
+            rec.score = score;
+            writer->write(rec);
+        }
+        return score;
+    }
+
+    // узел с ходами turns: лучший ход best и номер хода, давшего отсечение (cut < 0 — отсечения не было)
+    SCORE_T leave(const tree_kind kind, const SCORE_T score, const std::vector<move_pos> &turns, const move_pos &best,
+                  const long cut)
+    {
+        if (writer)
+        {
+            rec.moves = uint8_t(std::min<size_t>(turns.size(), tree_record::NONE));
+            for (size_t k = 0; k < turns.size() && k < tree_record::NONE; ++k)
+                if (turns[k] == best)
+                {
+                    rec.best = uint8_t(k);
+                    break;
+                }
+            if (cut >= 0)
+                rec.cut = uint8_t(std::min<long>(cut, tree_record::NONE));
+        }
+        return leave(kind, score);
+    }
+
+  private:
+    SearchTreeWriter *const writer;
+    tree_record rec{};
+};
+
+/**
+ * Читает дамп path: заголовок и все записи. false — файла нет или это не дамп дерева.
+ */
+inline bool read_tree_dump(const std::string &path, tree_dump_header &header, std::vector<tree_record> &records)
+{
+    std::ifstream in(path, std::ios_base::binary);
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kTreeDumpMagic, sizeof(header.magic)) || header.record_size != sizeof(tree_record))
+        return false;
+    records.resize(size_t(header.records));
+    in.read(reinterpret_cast<char *>(records.data()), std::streamsize(records.size() * sizeof(tree_record)));
+    records.resize(size_t(in.gcount()) / sizeof(tree_record));
+    return true;
+}
+
+#ifdef CHECKERS_TREE_DUMP
+    // writer — SearchTreeWriter * (nullptr — запись выключена)
+    #define TREE_SEARCH(writer, color, depth) ((writer) ? (writer)->search(color, depth) : void())
+    #define TREE_CHILD(writer, depth, turn, order, research)                                                          \
+        ((writer) ? (writer)->child(depth, turn, order, research) : void())
+    #define TREE_RESEARCH(writer, depth) ((writer) ? (writer)->research(depth) : void())
+    #define TREE_LEAF(writer, turn, order, depth, alpha, beta, score)                                                  \
+        ((writer) ? (writer)->leaf(turn, order, depth, alpha, beta, score) : void())
+    #define TREE_NODE(writer, depth, alpha, beta) tree_node tree_node_(writer, depth, alpha, beta)
+    #define TREE_RETURN(kind, score) tree_node_.leave(tree_kind::kind, score)
+    #define TREE_RETURN_MOVES(kind, score, turns, best, cut) tree_node_.leave(tree_kind::kind, score, turns, best, cut)
+#else
+    #define TREE_SEARCH(writer, color, depth) ((void)0)
+    #define TREE_CHILD(writer, depth, turn, order, research) ((void)0)
+    #define TREE_RESEARCH(writer, depth) ((void)0)
+    #define TREE_LEAF(writer, turn, order, depth, alpha, beta, score) ((void)0)
+    #define TREE_NODE(writer, depth, alpha, beta) ((void)0)
+    #define TREE_RETURN(kind, score) (score)
+    #define TREE_RETURN_MOVES(kind, score, turns, best, cut) (score)
+#endif
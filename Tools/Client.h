@@ -0,0 +1,136 @@
+#pragma once
+/**
+ * Клиент сервера движка (checkers_server) по Unix-сокету.
+ *
+ * Протокол тот же, что у checkers_engine (см. Tools/engine.cpp): строки команд туда,
+ * строки info / bestmove обратно. Один объект — одна сессия; объект не потокобезопасен,
+ * для параллельных партий нужно по клиенту на поток.
+ */
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+class EngineClient
+{
+  public:
+    EngineClient() = default;
+    EngineClient(const EngineClient &) = delete;
+    EngineClient &operator=(const EngineClient &) = delete;
+
+    ~EngineClient()
+    {
+        close();
+    }
+
+    bool connect(const std::string &socket_path)
+    {
+        close();
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return false;
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(addr.sun_path))
+        {
+            close();
+            return false;
+        }
+        socket_path.copy(addr.sun_path, socket_path.size());
+        if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+        buffer.clear();
+    }
+
+    bool connected() const
+    {
+        return fd >= 0;
+    }
+
+    bool send(const std::string &line)
+    {
+        const std::string data = line + "\n";
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            sent += size_t(n);
+        }
+        return true;
+    }
+
+    /**
+     * Читает одну строку ответа (без '\n'); false — соединение закрыто.
+     */
+    bool read_line(std::string &line)
+    {
+        while (true)
+        {
+            const size_t end = buffer.find('\n');
+            if (end != std::string::npos)
+            {
+                line = buffer.substr(0, end);
+                buffer.erase(0, end + 1);
+                return true;
+            }
+            char chunk[4096];
+            const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0)
+                return false;
+            buffer.append(chunk, size_t(n));
+        }
+    }
+
+    /**
+     * Читает ответы до строки, начинающейся с prefix, и возвращает её; пустая строка — соединение закрыто.
+     */
+    std::string wait_for(const std::string &prefix)
+    {
+        std::string line;
+        while (read_line(line))
+            if (line.compare(0, prefix.size(), prefix) == 0)
+                return line;
+        return "";
+    }
+
+    /**
+     * Приветствие: "checkers" → "checkersok".
+     */
+    bool handshake()
+    {
+        return send("checkers") && !wait_for("checkersok").empty();
+    }
+
+    /**
+     * Лучший ход: position <position>, go <go>; возвращает ход из bestmove
+     * ("(none)" — ходов нет, пустая строка — ошибка соединения).
+     */
+    std::string best_move(const std::string &position, const std::string &go)
+    {
+        if (!send("position " + position) || !send("go " + go))
+            return "";
+        const std::string line = wait_for("bestmove ");
+        if (line.empty())
+            return "";
+        const size_t begin = 9, end = line.find(' ', begin);
+        return line.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+    }
+
+  private:
+    int fd = -1;
+    std::string buffer;
+};
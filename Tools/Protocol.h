@@ -0,0 +1,160 @@
+#pragma once
+/**
+ * Общие части текстового протокола движка (checkers_engine и checkers_server):
+ * разбор команд position / go и форматирование ответов info / bestmove.
+ * Описание протокола — в Tools/engine.cpp.
+ */
+#include <iomanip>
+#include <sstream>
+
+#include "../Game/Logic.h"
+#include "../Models/Notation.h"
+
+// параметры команды go
+struct go_params
+{
+    int depth = 0;
+    long long movetime = -1;
+    long long wtime = -1, btime = -1, winc = 0, binc = 0;
+    uint64_t nodes = 0;
+    bool infinite = false;
+    bool ponder = false;
+};
+
+inline go_params parse_go(istringstream &in)
+{
+    go_params p;
+    string token;
+    while (in >> token)
+    {
+        if (token == "depth")
+            in >> p.depth;
+        else if (token == "movetime")
+            in >> p.movetime;
+        else if (token == "nodes")
+            in >> p.nodes;
+        else if (token == "wtime")
+            in >> p.wtime;
+        else if (token == "btime")
+            in >> p.btime;
+        else if (token == "winc")
+            in >> p.winc;
+        else if (token == "binc")
+            in >> p.binc;
+        else if (token == "infinite")
+            p.infinite = true;
+        else if (token == "ponder")
+            p.ponder = true;
+    }
+    return p;
+}
+
+/**
+ * Время на ход в миллисекундах: movetime, иначе 1/20 остатка часов стороны color
+ * плюс половина добавки (но не больше половины остатка); -1 — время не ограничено.
+ */
+inline long long move_budget_ms(const go_params &p, const bool color)
+{
+    if (p.movetime >= 0)
+        return p.movetime;
+    const long long clock = (color ? p.btime : p.wtime), inc = (color ? p.binc : p.winc);
+    if (clock < 0)
+        return -1;
+    return min(clock / 2, clock / 20 + inc / 2);
+}
+
+// позиция партии: текущая расстановка, сторона хода и история для правил ничьей (см. Logic::history)
+struct game_position
+{
+    vector<vector<POS_T>> mtx = start_position();
+    bool color = false;
+    vector<uint64_t> history;
+    int king_plies = 0;
+};
+
+/**
+ * Разбирает "startpos|fen <FEN> [moves <ход> ...]" (после слова position).
+ * Ходы проверяются по правилам через logic. При ошибке возвращает false и текст ошибки в error.
+ */
+inline bool parse_position(istringstream &in, Logic &logic, game_position &pos, string &error)
+{
+    string token;
+    in >> token;
+    game_position res;
+    if (token == "startpos")
+    {
+        in >> token;
+    }
+    else if (token == "fen")
+    {
+        string fen;
+        while (in >> token && token != "moves")
+            fen += token;
+        if (!parse_fen(fen, res.mtx, res.color))
+        {
+            error = "bad fen " + fen;
+            return false;
+        }
+    }
+    else
+    {
+        error = "usage: position startpos|fen <fen> [moves ...]";
+        return false;
+    }
+    if (token == "moves")
+    {
+        while (in >> token)
+        {
+            const auto series = logic.resolve_series(res.color, res.mtx, parse_series(token));
+            if (series.empty())
+            {
+                error = "illegal move " + token;
+                return false;
+            }
+            auto after = res.mtx;
+            for (const auto &turn : series)
+                after = logic.make_turn(after, turn);
+            res.history.push_back(Zobrist::get().hash(res.mtx, res.color));
+            res.king_plies = (Logic::is_king_move(res.mtx, after) ? res.king_plies + 1 : 0);
+            res.mtx = after;
+            res.color = !res.color;
+        }
+    }
+    pos = res;
+    return true;
+}
+
+/**
+ * Оценка для info: "win N" / "loss N" (через N полуходов) или отношение сил с 4 знаками.
+ */
+inline string score_name(const SCORE_T score)
+{
+    if (is_win(score))
+        return "win " + to_string(INF - score);
+    if (is_loss(score))
+        return "loss " + to_string(score);
+    ostringstream out;
+    out << fixed << setprecision(4) << double(score) / SCORE_ONE;
+    return out.str();
+}
+
+inline string info_line(const int depth, const size_t multipv, const analysis_line &line, const uint64_t nodes,
+                        const long long ms)
+{
+    ostringstream info;
+    info << "info depth " << depth << " multipv " << multipv << " score " << score_name(line.score)
+         << " nodes " << nodes << " nps " << nodes * 1000 / uint64_t(max(1LL, ms)) << " time " << ms << " pv";
+    for (const auto &series : line.pv)
+        info << " " << series_name(series);
+    return info.str();
+}
+
+inline string bestmove_line(const vector<analysis_line> &lines)
+{
+    if (lines.empty() || lines[0].pv.empty())
+        return "bestmove (none)";
+    string answer = "bestmove " + series_name(lines[0].pv[0]);
+    if (lines[0].pv.size() > 1)
+        answer += " ponder " + series_name(lines[0].pv[1]);
+    return answer;
+}
@@ -0,0 +1,360 @@
+#pragma once
+/**
+ * Общие части матчей двух конфигураций бота (checkers_match и checkers_farm):
+ * стороны и их переопределения настроек, случайный дебют, партия, пара партий с обменом цветами
+ * и пентаномиальная статистика пар с тестом SPRT. Описание матча — в Tools/match.cpp.
+ */
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "../Game/Archive.h"
+#include "../Game/Logic.h"
+#include "../Game/Mcts.h"
+#include "../Models/Notation.h"
+
+struct match_options
+{
+    int pairs = 1000;
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    int depth = 0;
+    uint64_t nodes = 0;
+    int movetime = 0;
+    int plies = 6;
+    double elo0 = 0, elo1 = 10;
+    double alpha = 0.05, beta = 0.05;
+    unsigned seed = 1;
+    // архив сыгранных партий (аргумент archive=FILE, "" — не записывать) и он открытый
+    string archive_file;
+    ArchiveWriter *archive = nullptr;
+};
+
+// глубина alpha-beta при ограничении только по времени
+constexpr int kMaxDepth = 40;
+
+// одна сторона матча: её настройки, описание для отчёта и суммарная работа поиска за матч
+struct engine_side
+{
+    Config config;
+    string name;
+    vector<string> overrides;
+    atomic<uint64_t> work{0};
+    atomic<uint64_t> micros{0};
+};
+
+// игрок стороны в одном потоке матча: alpha-beta или, при "Engine" = "MCTS", ещё и MCTS
+struct player
+{
+    explicit player(engine_side &side) : side(&side), logic(&side.config)
+    {
+        if (string(side.config("Bot", "Engine")) == "MCTS")
+            mcts = make_unique<Mcts>(&side.config);
+    }
+
+    engine_side *side;
+    Logic logic;
+    unique_ptr<Mcts> mcts;
+};
+
+/**
+ * "ключ=значение" стороны: значение — JSON ("5", "true", "\"O1\""), иначе строка.
+ */
+inline bool apply_override(engine_side &side, const string &assignment)
+{
+    const size_t eq = assignment.find('=');
+    if (eq == string::npos)
+        return false;
+    string dir = "Bot", name = assignment.substr(0, eq);
+    const size_t dot = name.find('.');
+    if (dot != string::npos)
+    {
+        dir = name.substr(0, dot);
+        name = name.substr(dot + 1);
+    }
+    const string value = assignment.substr(eq + 1);
+    json parsed = json::parse(value, nullptr, false);
+    side.config.set(dir, name, parsed.is_discarded() ? json(value) : parsed);
+    side.name += (side.name.empty() ? "" : " ") + assignment;
+    side.overrides.push_back(assignment);
+    return true;
+}
+
+/**
+ * Аргумент матча arg: "a.<ключ>=<значение>" / "b.<ключ>=<значение>" или параметр match_options
+ * (pairs, threads, depth, nodes, movetime, plies, elo0, elo1, alpha, beta, seed, archive).
+ * false — аргумент не из них: остальные параметры разбирает сам инструмент.
+ */
+inline bool parse_match_arg(engine_side sides[2], match_options &opt, const string &arg)
+{
+    const size_t eq = arg.find('=');
+    if (eq == string::npos)
+        return false;
+    if (arg.compare(0, 2, "a.") == 0 || arg.compare(0, 2, "b.") == 0)
+        return apply_override(sides[arg[0] == 'b'], arg.substr(2));
+    const string key = arg.substr(0, eq), value = arg.substr(eq + 1);
+    if (key == "pairs")
+        opt.pairs = stoi(value);
+    else if (key == "threads")
+        opt.threads = unsigned(max(1, stoi(value)));
+    else if (key == "depth")
+        opt.depth = stoi(value);
+    else if (key == "nodes")
+        opt.nodes = stoull(value);
+    else if (key == "movetime")
+        opt.movetime = stoi(value);
+    else if (key == "plies")
+        opt.plies = stoi(value);
+    else if (key == "elo0")
+        opt.elo0 = stod(value);
+    else if (key == "elo1")
+        opt.elo1 = stod(value);
+    else if (key == "alpha")
+        opt.alpha = stod(value);
+    else if (key == "beta")
+        opt.beta = stod(value);
+    else if (key == "seed")
+        opt.seed = unsigned(stoul(value));
+    else if (key == "archive")
+        opt.archive_file = value;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Архив партий матча path с настройками side; nullptr, если он не задан или не открылся.
+ * "ArchiveFile" из settings.json здесь не используется: матчи пишут партии только по явной просьбе.
+ */
+inline unique_ptr<ArchiveWriter> open_archive(engine_side &side, const string &path)
+{
+    if (path.empty())
+        return nullptr;
+    auto archive = make_unique<ArchiveWriter>(&side.config);
+    if (!archive->open(path))
+    {
+        cerr << "can't open game archive " << path << "\n";
+        return nullptr;
+    }
+    return archive;
+}
+
+/**
+ * Случайный дебют: plies полуходов из начальной позиции (серии взятий — до конца).
+ * Возвращает false, если после дебюта у стороны хода нет ходов.
+ */
+inline bool random_opening(Logic &logic, mt19937 &rng, const int plies, vector<vector<POS_T>> &mtx, bool &color)
+{
+    mtx = start_position();
+    color = false;
+    for (int ply = 0; ply < plies; ++ply)
+    {
+        logic.find_turns(color, mtx);
+        if (logic.turns.empty())
+            return false;
+        mtx = logic.make_turn(mtx, logic.turns[rng() % logic.turns.size()]);
+        color = !color;
+    }
+    logic.find_turns(color, mtx);
+    return !logic.turns.empty();
+}
+
+/**
+ * Партия из позиции mtx (ходит color): players[0] играет белыми, players[1] — чёрными.
+ * Возвращает очки белых: 2 — победа, 1 — ничья, 0 — поражение.
+ * Ничья — "MaxNumTurns" полуходов, трёхкратное повторение или правило "KingMovesDraw".
+ * Партия записывается в opt.archive, если он задан.
+ */
+inline int play_game(player *players[2], const int depths[2], const match_options &opt, vector<vector<POS_T>> mtx,
+              bool color, const int max_turns, const int draw_plies)
+{
+    vector<uint64_t> history;
+    int king_plies = 0;
+    vector<vector<vector<POS_T>>> played{mtx};
+    const bool first = color;
+    auto finish = [&](const int points) {
+        if (opt.archive)
+            opt.archive->append_positions(played, first, points == 1 ? 0 : (points == 2 ? 1 : 2));
+        return points;
+    };
+    for (int turn = 0; turn < max_turns; ++turn)
+    {
+        player &p = *players[color];
+        Logic &logic = p.logic;
+        logic.history = history;
+        logic.king_plies = king_plies;
+        const auto start = chrono::steady_clock::now();
+        vector<move_pos> steps;
+        if (p.mcts)
+        {
+            steps = p.mcts->find_best_turns(color, mtx, king_plies);
+            p.side->work += p.mcts->playouts;
+        }
+        else
+        {
+            if (opt.movetime > 0)
+                logic.deadline = start + chrono::milliseconds(opt.movetime);
+            const auto lines = logic.iterative_search(color, mtx, 1, depths[color], opt.nodes, nullptr, true);
+            if (!lines.empty() && !lines[0].pv.empty())
+                steps = lines[0].pv[0];
+            p.side->work += logic.nodes;
+        }
+        p.side->micros += uint64_t(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+        if (steps.empty())
+            return finish(color ? 2 : 0);
+        auto after = mtx;
+        for (const auto &step : steps)
+            after = logic.make_turn(after, step);
+        history.push_back(Zobrist::get().hash(mtx, color));
+        king_plies = (Logic::is_king_move(mtx, after) ? king_plies + 1 : 0);
+        mtx = after;
+        color = !color;
+        played.push_back(mtx);
+        const uint64_t hash = Zobrist::get().hash(mtx, color);
+        if ((draw_plies && king_plies >= draw_plies) || count(history.begin(), history.end(), hash) >= 2)
+            return finish(1);
+    }
+    return finish(1);
+}
+
+/**
+ * Глубины alpha-beta: depths[s][c] — сторона s (0 — A, 1 — B) цветом c (0 — белые).
+ */
+inline void side_depths(engine_side sides[2], const match_options &opt, int depths[2][2])
+{
+    for (int s = 0; s < 2; ++s)
+        for (int c = 0; c < 2; ++c)
+            depths[s][c] = opt.depth > 0      ? opt.depth
+                           : opt.movetime > 0 ? kMaxDepth
+                                              : int(sides[s].config("Bot", c ? "BlackBotLevel" : "WhiteBotLevel")) + 1;
+}
+
+/**
+ * Пара партий номер pair из одного случайного дебюта (зерно opt.seed и pair):
+ * A играет сначала белыми, затем чёрными. a_white, a_black — очки A в каждой (0..2).
+ */
+inline void play_pair(player &a, player &b, const int depths[2][2], const match_options &opt, const int pair,
+                      const int max_turns, const int draw_plies, int &a_white, int &a_black)
+{
+    mt19937 rng(opt.seed * 1000003u + unsigned(pair));
+    vector<vector<POS_T>> mtx;
+    bool color;
+    while (!random_opening(a.logic, rng, opt.plies, mtx, color))
+        ;
+    player *first[2] = {&a, &b}, *second[2] = {&b, &a};
+    const int first_depths[2] = {depths[0][0], depths[1][1]}, second_depths[2] = {depths[1][0], depths[0][1]};
+    a_white = play_game(first, first_depths, opt, mtx, color, max_turns, draw_plies);
+    a_black = 2 - play_game(second, second_depths, opt, mtx, color, max_turns, draw_plies);
+}
+
+/**
+ * Статистика пар: pairs[k] — число пар, в которых A набрал k / 2 очка (k = 0..4).
+ */
+struct pair_stats
+{
+    array<int, 5> pairs{};
+    int wins = 0, draws = 0, losses = 0;
+
+    int count() const
+    {
+        return pairs[0] + pairs[1] + pairs[2] + pairs[3] + pairs[4];
+    }
+
+    // пара, в которой A набрал a_white очков белыми и a_black чёрными (0..2 каждая)
+    void add(const int a_white, const int a_black)
+    {
+        ++pairs[a_white + a_black];
+        for (const int r : {a_white, a_black})
+            (r == 2 ? wins : r == 1 ? draws : losses)++;
+    }
+
+    // средний результат пары (0..1) и дисперсия результата одной пары
+    void moments(double &mean, double &var) const
+    {
+        const int n = count();
+        mean = var = 0;
+        for (int k = 0; k < 5; ++k)
+            mean += pairs[k] * (k / 4.0) / n;
+        for (int k = 0; k < 5; ++k)
+            var += pairs[k] * (k / 4.0 - mean) * (k / 4.0 - mean) / n;
+    }
+};
+
+inline double expected_score(const double elo)
+{
+    return 1 / (1 + pow(10.0, -elo / 400));
+}
+
+inline double elo_of(const double score)
+{
+    const double s = min(max(score, 1e-6), 1 - 1e-6);
+    return -400 * log10(1 / s - 1);
+}
+
+/**
+ * Логарифм отношения правдоподобия H1 (elo1) к H0 (elo0) в нормальном приближении (GSPRT):
+ * N * (s1 - s0) * (2 * mean - s0 - s1) / (2 * var).
+ */
+inline double llr(const pair_stats &stats, const double elo0, const double elo1)
+{
+    const int n = stats.count();
+    double mean, var;
+    stats.moments(mean, var);
+    if (n < 2 || var <= 0)
+        return 0;
+    const double s0 = expected_score(elo0), s1 = expected_score(elo1);
+    return n * (s1 - s0) * (2 * mean - s0 - s1) / (2 * var);
+}
+
+/**
+ * Начало отчёта: стороны, параметры SPRT и details — как идут партии (потоки, исполнители).
+ */
+inline void print_header(const engine_side sides[2], const match_options &opt, const string &details)
+{
+    cout << "A: " << (sides[0].name.empty() ? "settings.json" : sides[0].name) << "\n"
+         << "B: " << (sides[1].name.empty() ? "settings.json" : sides[1].name) << "\n"
+         << "SPRT elo0 " << opt.elo0 << " elo1 " << opt.elo1 << ", alpha " << opt.alpha << " beta " << opt.beta
+         << ", " << details << endl;
+}
+
+inline void print_stats(const pair_stats &stats, const double llr_value, const double lower, const double upper)
+{
+    double mean, var;
+    stats.moments(mean, var);
+    const int n = stats.count();
+    const double margin = 1.96 * sqrt(var / max(1, n));
+    const double elo = elo_of(mean), elo_lo = elo_of(mean - margin), elo_hi = elo_of(mean + margin);
+    cout << fixed << setprecision(1) << "pairs " << n << "  A: +" << stats.wins << " =" << stats.draws << " -"
+         << stats.losses << "  [" << stats.pairs[0] << " " << stats.pairs[1] << " " << stats.pairs[2] << " "
+         << stats.pairs[3] << " " << stats.pairs[4] << "]  elo " << elo << " +- " << (elo_hi - elo_lo) / 2
+         << setprecision(2) << "  LLR " << llr_value << " (" << lower << ", " << upper << ")" << endl;
+}
+
+/**
+ * Итог матча за seconds секунд: статистика, принятая гипотеза (interrupted — матч прерван
+ * до решения) и скорость каждой стороны — work[s] узлов или разыгрываний за micros[s] мкс.
+ */
+inline void print_verdict(const engine_side sides[2], const match_options &opt, const pair_stats &stats,
+                          const double llr_value, const double lower, const double upper, const double seconds,
+                          const uint64_t work[2], const uint64_t micros[2], const bool interrupted = false)
+{
+    print_stats(stats, llr_value, lower, upper);
+    if (llr_value >= upper)
+        cout << "H1 accepted: A is stronger by at least " << opt.elo1 << " elo";
+    else if (llr_value <= lower)
+        cout << "H0 accepted: A is not stronger by " << opt.elo1 << " elo";
+    else if (interrupted)
+        cout << "interrupted after " << stats.count() << " pairs, resume with the same arguments";
+    else
+        cout << "inconclusive after " << stats.count() << " pairs";
+    cout << " (" << setprecision(1) << seconds << " s)\n";
+    for (int s = 0; s < 2; ++s)
+    {
+        const bool mcts = (string(sides[s].config("Bot", "Engine")) == "MCTS");
+        cout << (s ? "B: " : "A: ") << setprecision(0) << double(work[s]) / max(1e-6, double(micros[s]) / 1e6)
+             << (mcts ? " playouts/s" : " nodes/s") << "\n";
+    }
+}
@@ -0,0 +1,248 @@
+/**
+ * checkers_archive — архив сыгранных партий (Game/Archive.h): индекс позиций и поиск партий по позиции.
+ *
+ * Партии в архив "ArchiveFile" (games_Russian.cga) пишет игра; checkers_match, checkers_farm и
+ * checkers_tuner selfplay — в архив из своего аргумента archive. Архив — аргумент <archive>,
+ * по умолчанию — файл из settings.json.
+ *
+ * Режимы:
+ *   checkers_archive index [archive] [memory_mb]
+ *       строит индекс <archive>.idx или дополняет его партиями, дописанными после построения;
+ *       позиции сортируются частями по memory_mb мегабайт (по умолчанию 256) и сливаются с диска.
+ *   checkers_archive stats [archive]
+ *       партии, результаты, полуходы и бит на ход, размер индекса.
+ *   checkers_archive find <FEN> [archive] [limit]
+ *       партии, в которых встретилась позиция (сторона хода — из FEN): сколько их и чем кончились,
+ *       время запроса; по первым limit (по умолчанию 1000) — ходы из позиции с итогами и номера партий.
+ *   checkers_archive show <game> [archive]
+ *       партия по номеру: итог, ходы и FEN начальной и конечной позиций.
+ * Итоги — со стороны белых: +1 победа белых, =0 ничья, -1 победа чёрных.
+ */
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include "../Game/Archive.h"
+
+namespace
+{
+using steady = chrono::steady_clock;
+
+int usage()
+{
+    cerr << "usage:\n"
+            "  checkers_archive index [archive] [memory_mb]\n"
+            "  checkers_archive stats [archive]\n"
+            "  checkers_archive find <FEN> [archive] [limit]\n"
+            "  checkers_archive show <game> [archive]\n";
+    return 1;
+}
+
+double millis(const steady::time_point start)
+{
+    return chrono::duration<double, milli>(steady::now() - start).count();
+}
+
+// итоги партий: по индексу result (0 ничья, 1 белые, 2 чёрные)
+struct outcome
+{
+    size_t games[3] = {};
+
+    void add(const int result)
+    {
+        ++games[result];
+    }
+
+    size_t total() const
+    {
+        return games[0] + games[1] + games[2];
+    }
+
+    string text() const
+    {
+        ostringstream out;
+        out << "+" << games[1] << " =" << games[0] << " -" << games[2];
+        if (total())
+            out << " (white " << fixed << setprecision(1) << 100.0 * (games[1] + 0.5 * games[0]) / total() << "%)";
+        return out.str();
+    }
+};
+
+bool open(Archive &archive, const string &path, const bool index_tail = true)
+{
+    if (path.empty())
+    {
+        cerr << "no archive: \"ArchiveFile\" is empty in settings.json\n";
+        return false;
+    }
+    if (!archive.open(path, index_tail))
+    {
+        cerr << "can't open game archive " << path << "\n";
+        return false;
+    }
+    if (archive.index_stale())
+        cerr << "warning: " << path << ".idx does not match the archive, run checkers_archive index\n";
+    return true;
+}
+
+int run_index(Config &config, const string &path, const size_t memory_mb)
+{
+    const auto start = steady::now();
+    if (!build_archive_index<russian_rules>(&config, path, memory_mb,
+                                            [](const size_t games) { cout << "games: " << games << endl; }))
+    {
+        cerr << "can't index game archive " << path << "\n";
+        return 1;
+    }
+    Archive archive(&config);
+    if (!open(archive, path, false))
+        return 1;
+    cout << "indexed " << archive.indexed_games() << " games, " << archive.index_size() << " positions in "
+         << fixed << setprecision(1) << millis(start) / 1000 << " s\n";
+    return 0;
+}
+
+int run_stats(Config &config, const string &path)
+{
+    Archive archive(&config);
+    if (!open(archive, path, false))
+        return 1;
+    outcome results;
+    uint64_t plies = 0, bytes = 0;
+    size_t custom = 0;
+    for (size_t g = 0; g < archive.games(); ++g)
+    {
+        const archive_record r = archive.record(g);
+        results.add(r.result);
+        plies += r.plies;
+        bytes += r.bytes;
+        if (r.flags & archive_record::START)
+        {
+            ++custom;
+            bytes -= 3 * sizeof(uint64_t);
+        }
+    }
+    cout << archive.games() << " games " << results.text() << ", " << custom << " from custom positions\n"
+         << plies << " plies, " << fixed << setprecision(1) << double(plies) / max<size_t>(1, archive.games())
+         << " per game, " << setprecision(2) << 8.0 * double(bytes) / double(max<uint64_t>(1, plies))
+         << " bits per move, " << archive.data_bytes() << " bytes\n"
+         << "index: " << archive.indexed_games() << " games, " << archive.index_size() << " positions";
+    if (archive.games() > archive.indexed_games())
+        cout << ", " << archive.games() - archive.indexed_games() << " games not indexed yet";
+    cout << "\n";
+    return 0;
+}
+
+int run_find(Config &config, const string &fen, const string &path, const size_t limit)
+{
+    vector<vector<POS_T>> mtx;
+    bool color;
+    if (!parse_fen(fen, mtx, color))
+    {
+        cerr << "bad FEN: " << fen << "\n";
+        return 1;
+    }
+    Archive archive(&config);
+    if (!open(archive, path))
+        return 1;
+    const uint64_t hash = Zobrist::get().hash(mtx, color);
+
+    auto start = steady::now();
+    const vector<uint32_t> games = archive.find(hash);
+    outcome results;
+    for (const uint32_t g : games)
+        results.add(archive.record(g).result);
+    const double lookup = millis(start);
+    cout << games.size() << " of " << archive.games() << " games reached the position: " << results.text() << "\n"
+         << fixed << setprecision(3) << "lookup " << lookup << " ms\n";
+    if (games.empty())
+        return 0;
+
+    // ходы из позиции: партии разыгрываются до неё (позиция может встретиться в партии не раз — берётся первый)
+    start = steady::now();
+    map<string, outcome> next;
+    outcome ended;
+    vector<pair<uint32_t, int>> reached;
+    for (size_t k = 0; k < games.size() && k < limit; ++k)
+    {
+        archived_game game;
+        int ply = -1;
+        archive.replay(
+            games[k],
+            [&](const int p, const vector<vector<POS_T>> &pos, const bool side, const uint64_t h) {
+                if (ply < 0 && h == hash && side == color && pos == mtx)
+                    ply = p;
+            },
+            &game);
+        if (ply < 0)
+            continue; // совпадение хеша другой позиции
+        reached.emplace_back(games[k], ply);
+        if (size_t(ply) < game.moves.size())
+            next[series_name({game.moves[ply]})].add(game.result);
+        else
+            ended.add(game.result);
+    }
+    vector<pair<string, outcome>> moves(next.begin(), next.end());
+    stable_sort(moves.begin(), moves.end(), [](const auto &a, const auto &b) { return a.second.total() > b.second.total(); });
+    cout << "moves in " << reached.size() << " games (" << setprecision(1) << millis(start) << " ms):\n";
+    for (const auto &[name, res] : moves)
+        cout << "  " << left << setw(8) << name << right << setw(8) << res.total() << "  " << res.text() << "\n";
+    if (ended.total())
+        cout << "  " << left << setw(8) << "(end)" << right << setw(8) << ended.total() << "  " << ended.text() << "\n";
+    cout << "games (game:ply):";
+    for (size_t k = 0; k < reached.size() && k < 20; ++k)
+        cout << " " << reached[k].first << ":" << reached[k].second;
+    if (reached.size() > 20)
+        cout << " ...";
+    cout << "\n";
+    return 0;
+}
+
+int run_show(Config &config, const size_t id, const string &path)
+{
+    Archive archive(&config);
+    if (!open(archive, path, false))
+        return 1;
+    archived_game game;
+    if (id >= archive.games() || !archive.game(id, game))
+    {
+        cerr << "no game " << id << " in " << path << "\n";
+        return 1;
+    }
+    static const char *const results[] = {"1-1", "2-0", "0-2"};
+    cout << "game " << id << ": " << results[game.result] << ", " << game.moves.size() << " plies\n"
+         << "start: " << to_fen(game.start, game.color) << "\n";
+    BasicArchiveCodec<russian_rules> codec(&config);
+    auto mtx = game.start;
+    bool side = game.color;
+    for (size_t k = 0; k < game.moves.size(); ++k, side = !side)
+    {
+        if (k == 0 || !side)
+            cout << (k ? "\n" : "") << (k + (game.color ? 1 : 0)) / 2 + 1 << "." << (side ? " ..." : "");
+        cout << " " << series_name({game.moves[k]});
+        mtx = codec.make_turn(mtx, game.moves[k]);
+    }
+    cout << "\nend: " << to_fen(mtx, side) << "\n";
+    return 0;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+        return usage();
+    Config config;
+    const string mode = argv[1];
+    const string settings_path = archive_path(config, russian_rules::name);
+    auto arg = [&](const int i, const string &def) { return argc > i ? string(argv[i]) : def; };
+    if (mode == "index")
+        return run_index(config, arg(2, settings_path), argc > 3 ? size_t(stoul(argv[3])) : 256);
+    if (mode == "stats")
+        return run_stats(config, arg(2, settings_path));
+    if (mode == "find" && argc > 2)
+        return run_find(config, argv[2], arg(3, settings_path), argc > 4 ? size_t(stoul(argv[4])) : 1000);
+    if (mode == "show" && argc > 2)
+        return run_show(config, size_t(stoul(argv[2])), arg(3, settings_path));
+    return usage();
+}
@@ -0,0 +1,141 @@
+/**
+ * checkers_embed_textures — шаг сборки: PNG из Textures/ → заголовок с готовыми пикселями.
+ *
+ * Запуск: checkers_embed_textures <out.h> <file.png> ...
+ * Каждая картинка декодируется (SDL_image) в SDL_PIXELFORMAT_ARGB8888 — формат, который
+ * SDL_UpdateTexture загружает в текстуру без преобразований, — и записывается сериями
+ * одинаковых пикселей (длина, пиксель): рисунки из крупных заливок сжимаются в сотни раз,
+ * а распаковка при запуске — простое заполнение памяти, без PNG и файловой системы.
+ * Полностью прозрачные пиксели приводятся к 0, чтобы не рвать серии.
+ */
+#define SDL_MAIN_HANDLED
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __APPLE__
+    #include <SDL2/SDL.h>
+    #include <SDL2/SDL_image.h>
+#else
+    #include <SDL.h>
+    #include <SDL_image.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+// имя массива по имени файла: "Textures/piece_white.png" → "piece_white"
+string identifier(const string &path)
+{
+    const size_t slash = path.find_last_of("/\\");
+    string name = path.substr(slash == string::npos ? 0 : slash + 1);
+    name = name.substr(0, name.rfind('.'));
+    for (auto &c : name)
+        if (!isalnum((unsigned char)c))
+            c = '_';
+    return name;
+}
+
+string file_name(const string &path)
+{
+    const size_t slash = path.find_last_of("/\\");
+    return path.substr(slash == string::npos ? 0 : slash + 1);
+}
+
+/**
+ * Пиксели картинки сериями: runs = {длина, пиксель, длина, пиксель, ...}.
+ */
+bool encode(const string &path, int &w, int &h, vector<uint32_t> &runs)
+{
+    SDL_Surface *loaded = IMG_Load(path.c_str());
+    if (!loaded)
+        return false;
+    SDL_Surface *surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loaded);
+    if (!surface)
+        return false;
+    w = surface->w;
+    h = surface->h;
+    runs.clear();
+    for (int y = 0; y < h; ++y)
+    {
+        const auto *row = reinterpret_cast<const uint32_t *>(static_cast<const uint8_t *>(surface->pixels) +
+                                                             size_t(y) * surface->pitch);
+        for (int x = 0; x < w; ++x)
+        {
+            const uint32_t pixel = (row[x] >> 24) ? row[x] : 0;
+            if (!runs.empty() && runs.back() == pixel && runs[runs.size() - 2] < UINT32_MAX)
+                ++runs[runs.size() - 2];
+            else
+            {
+                runs.push_back(1);
+                runs.push_back(pixel);
+            }
+        }
+    }
+    SDL_FreeSurface(surface);
+    return true;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        cerr << "usage: checkers_embed_textures <out.h> <file.png> ...\n";
+        return 1;
+    }
+    ofstream out(argv[1]);
+    if (!out)
+    {
+        cerr << "can't write " << argv[1] << "\n";
+        return 1;
+    }
+    out << "#pragma once\n"
+           "// Сгенерировано checkers_embed_textures из Textures/*.png — не редактировать.\n"
+           "#include <cstddef>\n"
+           "#include <cstdint>\n\n"
+           "// картинка: w x h пикселей ARGB8888 сериями {длина, пиксель} (runs_size чисел)\n"
+           "struct embedded_texture\n"
+           "{\n"
+           "    const char *name;\n"
+           "    int w, h;\n"
+           "    const uint32_t *runs;\n"
+           "    size_t runs_size;\n"
+           "};\n\n";
+    vector<string> entries;
+    size_t total = 0;
+    for (int i = 2; i < argc; ++i)
+    {
+        int w, h;
+        vector<uint32_t> runs;
+        if (!encode(argv[i], w, h, runs))
+        {
+            cerr << "can't decode " << argv[i] << ": " << SDL_GetError() << "\n";
+            return 1;
+        }
+        const string id = identifier(argv[i]);
+        out << "static const uint32_t " << id << "_runs[" << runs.size() << "] = {";
+        for (size_t k = 0; k < runs.size(); ++k)
+        {
+            if (k)
+                out << ',';
+            if (k % 12 == 0)
+                out << "\n    ";
+            out << runs[k];
+        }
+        out << "};\n\n";
+        entries.push_back("    {\"" + file_name(argv[i]) + "\", " + to_string(w) + ", " + to_string(h) + ", " + id +
+                          "_runs, " + to_string(runs.size()) + "},\n");
+        total += runs.size() * sizeof(uint32_t);
+    }
+    out << "static const embedded_texture embedded_textures[] = {\n";
+    for (const auto &entry : entries)
+        out << entry;
+    out << "};\n";
+    cout << "embedded " << entries.size() << " textures, " << total / 1024 << " KiB\n";
+    return out ? 0 : 1;
+}
@@ -0,0 +1,356 @@
+/**
+ * checkers_engine — движок без SDL с построчным текстовым протоколом в стиле UCI (stdin/stdout).
+ *
+ * Команды:
+ *   checkers                          — приветствие: id, список опций, затем "checkersok"
+ *   isready                           — "readyok", когда прочитаны предыдущие команды (поиск не прерывает)
+ *   setoption name <имя> value <v>    — параметр секции "Bot" из settings.json или MultiPV
+ *   newgame                           — новая партия (таблица транспозиций очищается)
+ *   position startpos|fen <FEN> [moves <ход> ...]
+ *   go [depth N] [movetime MS] [nodes N] [wtime MS] [btime MS] [winc MS] [binc MS] [infinite] [ponder]
+ *   stop                              — закончить поиск и выдать ход
+ *   ponderhit                         — соперник сделал ожидаемый ход: поиск в режиме ponder
+ *                                       продолжается как обычный, с отсчётом времени с этого момента
+ *   perft N                           — число позиций на глубинах 1..N от текущей позиции
+ *                                       (пакетный генератор ходов Game/Batch_movegen.h)
+ *   quit
+ * Ответы:
+ *   info depth D multipv K score S nodes N nps N time MS pv <ходы>
+ *     S — отношение сил стороны хода к силам соперника ("1.0000" — равенство),
+ *     "win N" / "loss N" — выигрыш / проигрыш через N полуходов
+ *   bestmove <ход> [ponder <ход>]     ("bestmove (none)" — ходов нет)
+ *   info string perft D nodes N time MS nps N
+ *
+ * Ходы — полные серии в нотации Models/Notation.h ("c3-d4", "c3:e5:g3"), позиции — FEN ("W:Wa1,Kc3:Bh8").
+ * Поиск — итеративное углубление Logic::find_best_lines; прерванная итерация отбрасывается.
+ * Без ограничений в go глубина берётся из "WhiteBotLevel" / "BlackBotLevel" для стороны хода, а если
+ * у неё задан профиль сложности ("WhiteBotProfile" / "BlackBotProfile", см. Game/Profile.h) — ход ищется по профилю:
+ * одна строка info с узлами профиля и bestmove.
+ * В сборке с CHECKERS_TREE_DUMP при непустом "TreeDumpFile" поиски пишут дерево в этот файл (разбор — checkers_tree);
+ * файл начинается заново, когда пересоздаётся Logic (newgame, setoption), и дописывается при выходе.
+ */
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "../Game/Batch_movegen.h"
+#include "Protocol.h"
+
+namespace
+{
+// предельная глубина итеративного углубления (go infinite / по времени / по узлам)
+const int kMaxDepth = 40;
+
+// параметры секции "Bot", которые можно менять через setoption
+const char *const kOptions[] = {"WhiteBotLevel", "BlackBotLevel", "WhiteBotProfile", "BlackBotProfile",
+                                "BotScoringType", "NnueFile",     "WeightsFile",     "NoRandom",
+                                "Optimization",  "HashMB",        "TreeDumpFile",    "TreeDumpNodes"};
+
+using steady = chrono::steady_clock;
+
+class Engine
+{
+  public:
+    int run()
+    {
+        string line;
+        while (getline(cin, line))
+        {
+            if (!handle(line))
+                break;
+        }
+        stop_search();
+        return 0;
+    }
+
+  private:
+    // false — пора завершаться (quit)
+    bool handle(const string &line)
+    {
+        istringstream in(line);
+        string cmd;
+        if (!(in >> cmd))
+            return true;
+        if (cmd == "checkers")
+        {
+            lock_guard<mutex> out_lock(out_mutex);
+            cout << "id name Checkers\n";
+            for (const char *name : kOptions)
+                cout << option_line(name) << "\n";
+            cout << "option name MultiPV type spin default 1 min 1 max 64\n";
+            cout << "checkersok" << endl;
+        }
+        else if (cmd == "isready")
+            say("readyok"); // только синхронизация: идущий поиск продолжается, опции применяются в position / go
+        else if (cmd == "setoption")
+            set_option(in);
+        else if (cmd == "newgame")
+        {
+            stop_search();
+            logic.reset();
+        }
+        else if (cmd == "position")
+        {
+            stop_search();
+            set_position(in);
+        }
+        else if (cmd == "go")
+        {
+            stop_search();
+            go(in);
+        }
+        else if (cmd == "stop")
+            stop_search();
+        else if (cmd == "ponderhit")
+        {
+            lock_guard<mutex> lock(m);
+            if (pondering)
+            {
+                pondering = false;
+                if (budget_ms >= 0)
+                {
+                    deadline = steady::now() + chrono::milliseconds(budget_ms);
+                    has_deadline = true;
+                }
+                cv.notify_all();
+            }
+        }
+        else if (cmd == "perft")
+        {
+            stop_search();
+            perft(in);
+        }
+        else if (cmd == "quit")
+            return false;
+        else
+            say("info string unknown command " + cmd);
+        return true;
+    }
+
+    void say(const string &text)
+    {
+        lock_guard<mutex> out_lock(out_mutex);
+        cout << text << endl;
+    }
+
+    string option_line(const string &name) const
+    {
+        const json value = config("Bot", name);
+        ostringstream res;
+        res << "option name " << name;
+        if (value.is_boolean())
+            res << " type check default " << (value.get<bool>() ? "true" : "false");
+        else if (value.is_number())
+            res << " type spin default " << value.dump();
+        else
+            res << " type string default " << (value.is_string() ? value.get<string>() : value.dump());
+        return res.str();
+    }
+
+    void set_option(istringstream &in)
+    {
+        string token, name, value;
+        in >> token >> name;
+        if (token != "name" || !(in >> token) || token != "value")
+        {
+            say("info string usage: setoption name <name> value <value>");
+            return;
+        }
+        getline(in >> ws, value);
+        stop_search();
+        if (name == "MultiPV")
+        {
+            multipv = max(1, atoi(value.c_str()));
+            return;
+        }
+        if (find(begin(kOptions), end(kOptions), name) == end(kOptions))
+        {
+            say("info string unknown option " + name);
+            return;
+        }
+        const json old = config("Bot", name);
+        if (old.is_boolean())
+            config.set("Bot", name, value == "true" || value == "1");
+        else if (old.is_number())
+            config.set("Bot", name, atoll(value.c_str()));
+        else
+            config.set("Bot", name, value);
+        // Logic читает настройки в конструкторе — пересоздаём перед следующим поиском
+        logic.reset();
+    }
+
+    void ensure_logic()
+    {
+        if (!logic)
+            logic = make_unique<Logic>(&config);
+    }
+
+    void set_position(istringstream &in)
+    {
+        ensure_logic();
+        string error;
+        if (!parse_position(in, *logic, position, error))
+            say("info string " + error);
+    }
+
+    void perft(istringstream &in)
+    {
+        int depth = 0;
+        if (!(in >> depth) || depth < 1)
+        {
+            say("info string usage: perft <depth>");
+            return;
+        }
+        leaf_batch root;
+        uint32_t wm, wk, bm, bk;
+        BatchEval::pack(position.mtx, wm, wk, bm, bk);
+        root.push(wm, wk, bm, bk);
+        BatchMoveGen gen;
+        for (int d = 1; d <= depth; ++d)
+        {
+            const auto start = steady::now();
+            const uint64_t nodes = gen.perft(root, position.color, d);
+            const auto ms = chrono::duration_cast<chrono::milliseconds>(steady::now() - start).count();
+            say("info string perft " + to_string(d) + " nodes " + to_string(nodes) + " time " + to_string(ms) +
+                " nps " + to_string(ms > 0 ? nodes * 1000 / uint64_t(ms) : nodes * 1000));
+        }
+    }
+
+    void go(istringstream &in)
+    {
+        const go_params p = parse_go(in);
+        ensure_logic();
+        budget_ms = move_budget_ms(p, position.color);
+        int max_depth = p.depth;
+        by_profile = false;
+        if (max_depth <= 0)
+        {
+            const bool limited = p.infinite || p.ponder || budget_ms >= 0 || p.nodes;
+            max_depth = limited ? kMaxDepth : int(config("Bot", position.color ? "BlackBotLevel" : "WhiteBotLevel")) + 1;
+            by_profile = !limited && read_profile(config, config("Bot", position.color ? "BlackBotProfile" : "WhiteBotProfile"),
+                                                  profile);
+        }
+
+        stop = false;
+        search_done = false;
+        infinite = p.infinite;
+        pondering = p.ponder;
+        has_deadline = (budget_ms >= 0 && !p.ponder);
+        if (has_deadline)
+            deadline = steady::now() + chrono::milliseconds(budget_ms);
+        searcher = thread(&Engine::search, this, max_depth, p.nodes, p.depth <= 0 && !p.infinite && !p.ponder);
+        timer = thread(&Engine::watch, this);
+    }
+
+    // выставляет stop, когда истекает время хода (отсчёт начинается после ponderhit)
+    void watch()
+    {
+        unique_lock<mutex> lock(m);
+        while (!search_done)
+        {
+            if (has_deadline && !pondering)
+            {
+                if (cv.wait_until(lock, deadline) == cv_status::timeout && steady::now() >= deadline)
+                {
+                    stop = true;
+                    has_deadline = false;
+                    cv.notify_all();
+                }
+            }
+            else
+                cv.wait(lock);
+        }
+    }
+
+    // early_exit — можно закончить раньше max_depth, если ход вынужден или исход партии уже ясен
+    void search(const int max_depth, const uint64_t node_budget, const bool early_exit)
+    {
+        const auto start = steady::now();
+        logic->history = position.history;
+        logic->king_plies = position.king_plies;
+        vector<analysis_line> best;
+        if (by_profile)
+        {
+            analysis_line line;
+            line.pv.push_back(logic->find_profile_turns(position.color, position.mtx, profile));
+            line.score = logic->last_score;
+            if (!line.pv[0].empty())
+            {
+                const long long ms = chrono::duration_cast<chrono::milliseconds>(steady::now() - start).count();
+                say(info_line(logic->last_depth, 1, line, logic->nodes, ms));
+                best.push_back(line);
+            }
+        }
+        else
+            best = logic->iterative_search(
+                position.color, position.mtx, size_t(multipv), max_depth, node_budget, &stop, early_exit,
+                [&](const int depth, const vector<analysis_line> &lines, const uint64_t nodes) {
+                    const long long ms = chrono::duration_cast<chrono::milliseconds>(steady::now() - start).count();
+                    for (size_t k = 0; k < lines.size(); ++k)
+                        say(info_line(depth, k + 1, lines[k], nodes, ms));
+                });
+
+        // в режимах infinite / ponder ход выдаётся только после stop или ponderhit
+        unique_lock<mutex> lock(m);
+        cv.wait(lock, [this]() { return stop || (!infinite && !pondering); });
+        search_done = true;
+        cv.notify_all();
+        lock.unlock();
+        say(bestmove_line(best));
+    }
+
+    void stop_search()
+    {
+        if (!searcher.joinable())
+            return;
+        {
+            lock_guard<mutex> lock(m);
+            stop = true;
+            infinite = false;
+            pondering = false;
+            cv.notify_all();
+        }
+        searcher.join();
+        timer.join();
+    }
+
+    Config config;
+    unique_ptr<Logic> logic;
+    game_position position;
+    int multipv = 1;
+    // go без ограничений для стороны с профилем сложности
+    bool by_profile = false;
+    search_profile profile;
+
+    // состояние текущего поиска (флаги меняются под m)
+    thread searcher, timer;
+    mutex m, out_mutex;
+    condition_variable cv;
+    atomic<bool> stop{false};
+    bool search_done = true;
+    atomic<bool> infinite{false};
+    atomic<bool> pondering{false};
+    bool has_deadline = false;
+    steady::time_point deadline;
+    long long budget_ms = -1;
+};
+} // namespace
+
+int main()
+{
+    ios::sync_with_stdio(false);
+    try
+    {
+        Engine engine;
+        return engine.run();
+    }
+    catch (const exception &e)
+    {
+        cout << "info string error: " << e.what() << endl;
+        return 1;
+    }
+}
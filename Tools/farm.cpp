@@ -0,0 +1,675 @@
+/**
+ * checkers_farm — матч двух конфигураций бота (как checkers_match) на нескольких процессах и машинах.
+ *
+ * Координатор: checkers_farm [a.<ключ>=<значение> ...] [b.<ключ>=<значение> ...] [параметр=значение ...]
+ *   workers=N         — локальных процессов-исполнителей (по умолчанию число ядер; 0 — только подключившиеся)
+ *   listen=ADDR:PORT  — TCP-адрес координатора (по умолчанию 127.0.0.1:7171; 0.0.0.0:7171 — для других машин)
+ *   exe=PATH          — программа локальных исполнителей (по умолчанию эта же, например — экспериментальная сборка)
+ *   checkpoint=FILE   — журнал сыгранных пар (по умолчанию farm.log): при запуске с теми же параметрами
+ *                       матча сыгранные пары не переигрываются, матч продолжается с места остановки
+ *   timeout=S         — наибольшее время пары в секундах (по умолчанию 0 — без ограничения): пара зависшего
+ *                       исполнителя отдаётся другому, локальный исполнитель завершается
+ *   archive=FILE      — архив сыгранных партий локальных исполнителей (Game/Archive.h); без него партии не пишутся
+ *   pairs, depth, nodes, movetime, plies, elo0, elo1, alpha, beta, seed — как у checkers_match
+ * Исполнитель: checkers_farm worker=HOST:PORT [archive=FILE] — подключается к координатору и играет выданные пары
+ *   по одной. Настройки — settings.json своей машины (рабочего каталога) плюс переопределения a. / b. координатора.
+ *   С archive=FILE сыгранные партии дописываются в архив FILE своей машины.
+ *
+ * Протокол — строки по TCP:
+ *   исполнитель → hello <pid>
+ *   координатор → setup <JSON: a, b, depth, nodes, movetime, plies, seed>
+ *   координатор → pair K                               — сыграть пару K (дебют из seed и K, как в checkers_match)
+ *   исполнитель → result K <очки A белыми> <очки A чёрными> <работа A> <мкс A> <работа B> <мкс B>
+ *   координатор → done                                 — пар больше нет, завершиться
+ * Падение исполнителя не останавливает матч: пара отключившегося исполнителя отдаётся другому,
+ * завершившийся до конца матча локальный исполнитель запускается заново (не чаще раза в секунду).
+ * Журнал — строка setup и строки result в порядке получения; оборванная последняя строка отбрасывается.
+ * Ctrl+C останавливает исполнителей, журнал остаётся для продолжения.
+ */
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <set>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Selfplay.h"
+
+namespace
+{
+// пауза перед повторным запуском упавшего локального исполнителя
+const auto kRestartDelay = chrono::seconds(1);
+
+// сколько ждать завершения исполнителей после done, прежде чем завершить их принудительно
+const auto kShutdownWait = chrono::seconds(2);
+
+using steady = chrono::steady_clock;
+
+volatile sig_atomic_t terminate_requested = 0;
+
+struct farm_options
+{
+    unsigned workers = max(1u, thread::hardware_concurrency());
+    string listen = "127.0.0.1:7171";
+    string exe;
+    string checkpoint = "farm.log";
+    int timeout = 0;
+};
+
+/**
+ * Строки поверх сокета: send — целой строкой, fill — одно чтение, next_line — готовая строка из буфера.
+ */
+struct channel
+{
+    explicit channel(const int fd) : fd(fd)
+    {
+    }
+
+    bool send(const string &line) const
+    {
+        const string text = line + "\n";
+        size_t sent = 0;
+        while (sent < text.size())
+        {
+            const ssize_t n = ::send(fd, text.data() + sent, text.size() - sent, 0);
+            if (n <= 0)
+                return false;
+            sent += size_t(n);
+        }
+        return true;
+    }
+
+    // false — соединение закрыто или ошибка
+    bool fill()
+    {
+        char data[4096];
+        const ssize_t n = ::read(fd, data, sizeof(data));
+        if (n <= 0)
+            return false;
+        buffer.append(data, size_t(n));
+        return true;
+    }
+
+    bool next_line(string &line)
+    {
+        const size_t end = buffer.find('\n');
+        if (end == string::npos)
+            return false;
+        line = buffer.substr(0, end);
+        buffer.erase(0, end + 1);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        return true;
+    }
+
+    int fd;
+    string buffer;
+};
+
+bool split_address(const string &address, string &host, string &port)
+{
+    const size_t colon = address.rfind(':');
+    if (colon == string::npos || colon + 1 == address.size())
+        return false;
+    host = address.substr(0, colon);
+    port = address.substr(colon + 1);
+    return true;
+}
+
+/**
+ * TCP-сокет: для listen — привязанный и слушающий адрес address, иначе — подключённый к нему; -1 — ошибка.
+ */
+int open_tcp(const string &address, const bool listen)
+{
+    string host, port;
+    if (!split_address(address, host, port))
+        return -1;
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = (listen ? AI_PASSIVE : 0);
+    addrinfo *list = nullptr;
+    if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &list) != 0)
+        return -1;
+    int fd = -1;
+    for (addrinfo *ai = list; ai && fd < 0; ai = ai->ai_next)
+    {
+        fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+        const int one = 1;
+        bool ok;
+        if (listen)
+            ok = ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0 &&
+                 ::bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && ::listen(fd, 64) == 0;
+        else
+            ok = ::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+        if (!ok)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ::freeaddrinfo(list);
+    // локальные исполнители не должны наследовать сокеты координатора
+    if (fd >= 0)
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+/**
+ * Параметры матча, от которых зависят партии: их получают исполнители, по ним же журнал
+ * проверяется при продолжении.
+ */
+json match_setup(const engine_side sides[2], const match_options &opt)
+{
+    return json{{"a", sides[0].overrides}, {"b", sides[1].overrides}, {"depth", opt.depth},
+                {"nodes", opt.nodes},      {"movetime", opt.movetime},  {"plies", opt.plies},
+                {"seed", opt.seed}};
+}
+
+// результат пары от исполнителя (строка result)
+struct pair_result
+{
+    int pair = -1;
+    int a_white = 0, a_black = 0;
+    uint64_t work[2]{}, micros[2]{};
+};
+
+bool parse_result(const string &line, pair_result &r)
+{
+    istringstream in(line);
+    string word;
+    return (in >> word >> r.pair >> r.a_white >> r.a_black >> r.work[0] >> r.micros[0] >> r.work[1] >> r.micros[1]) &&
+           word == "result" && r.pair >= 0 && r.a_white >= 0 && r.a_white <= 2 && r.a_black >= 0 && r.a_black <= 2;
+}
+
+string result_line(const pair_result &r)
+{
+    return "result " + to_string(r.pair) + " " + to_string(r.a_white) + " " + to_string(r.a_black) + " " +
+           to_string(r.work[0]) + " " + to_string(r.micros[0]) + " " + to_string(r.work[1]) + " " +
+           to_string(r.micros[1]);
+}
+
+/**
+ * Исполнитель: играет пары координатора address, пока не получит done; партии — в архив archive_file ("" — никуда).
+ */
+int run_worker(const string &address, const string &archive_file)
+{
+    const int fd = open_tcp(address, false);
+    if (fd < 0)
+    {
+        cerr << "can't connect to " << address << "\n";
+        return 1;
+    }
+    channel ch(fd);
+    engine_side sides[2];
+    match_options opt;
+    unique_ptr<player> a, b;
+    unique_ptr<ArchiveWriter> archive;
+    int depths[2][2];
+    int max_turns = 0, draw_plies = 0;
+    string line;
+    bool ok = ch.send("hello " + to_string(::getpid()));
+    while (ok)
+    {
+        if (!ch.next_line(line))
+        {
+            ok = ch.fill();
+            continue;
+        }
+        istringstream in(line);
+        string cmd;
+        in >> cmd;
+        if (cmd == "setup")
+        {
+            const json setup = json::parse(line.substr(cmd.size()), nullptr, false);
+            if (setup.is_discarded())
+                break;
+            for (int s = 0; s < 2; ++s)
+                for (const auto &assignment : setup[s ? "b" : "a"])
+                    apply_override(sides[s], assignment.get<string>());
+            opt.depth = setup["depth"];
+            opt.nodes = setup["nodes"];
+            opt.movetime = setup["movetime"];
+            opt.plies = setup["plies"];
+            opt.seed = setup["seed"];
+            if (opt.movetime > 0)
+                for (auto &side : sides)
+                    side.config.set("Bot", "MctsTimeMS", opt.movetime);
+            a = make_unique<player>(sides[0]);
+            b = make_unique<player>(sides[1]);
+            for (player *p : {a.get(), b.get()})
+                if (p->mcts)
+                    p->mcts->playout_limit = opt.nodes;
+            side_depths(sides, opt, depths);
+            max_turns = sides[0].config("Game", "MaxNumTurns");
+            draw_plies = 2 * int(sides[0].config("Game", "KingMovesDraw"));
+            // партии дописываются в архив машины работника: запись партии — один write, процессам не мешает
+            archive = open_archive(sides[0], archive_file);
+            opt.archive = archive.get();
+        }
+        else if (cmd == "pair" && a)
+        {
+            pair_result r;
+            in >> r.pair;
+            for (auto &side : sides)
+                side.work = side.micros = 0;
+            play_pair(*a, *b, depths, opt, r.pair, max_turns, draw_plies, r.a_white, r.a_black);
+            for (int s = 0; s < 2; ++s)
+            {
+                r.work[s] = sides[s].work;
+                r.micros[s] = sides[s].micros;
+            }
+            ok = ch.send(result_line(r));
+        }
+        else if (cmd == "done")
+        {
+            ::close(fd);
+            return 0;
+        }
+    }
+    ::close(fd);
+    cerr << "lost coordinator " << address << "\n";
+    return 1;
+}
+
+/**
+ * Координатор: раздаёт пары локальным и подключившимся исполнителям, собирает результаты
+ * в журнал и статистику SPRT, перезапускает упавших локальных исполнителей.
+ */
+class Coordinator
+{
+  public:
+    Coordinator(engine_side (&sides)[2], const match_options &opt, const farm_options &farm)
+        : sides(sides), opt(opt), farm(farm), setup(match_setup(sides, opt).dump()),
+          lower(log(opt.beta / (1 - opt.alpha))), upper(log((1 - opt.beta) / opt.alpha))
+    {
+    }
+
+    int run(const char *self)
+    {
+        if (!resume())
+            return 1;
+        const int listen_fd = open_tcp(farm.listen, true);
+        if (listen_fd < 0)
+        {
+            cerr << "can't listen on " << farm.listen << "\n";
+            return 1;
+        }
+        // без журнала этого матча (нет файла или оборвана строка setup) журнал начинается заново
+        journal.open(farm.checkpoint, resumed ? ios::app : ios::trunc);
+        if (!resumed)
+            journal << "setup " << setup << endl;
+        if (!journal)
+        {
+            cerr << "can't write " << farm.checkpoint << "\n";
+            ::close(listen_fd);
+            return 1;
+        }
+        string host, port;
+        split_address(farm.listen, host, port);
+        const bool any = (host.empty() || host == "0.0.0.0" || host == "::" || host == "[::]");
+        worker_arg = "worker=" + (any ? string("localhost") : host) + ":" + port;
+        worker_exe = farm.exe.empty() ? self : farm.exe;
+        archive_arg = opt.archive_file.empty() ? "" : "archive=" + opt.archive_file;
+        print_header(sides, opt,
+                     "listening on " + farm.listen + ", " + to_string(farm.workers) + " local workers, " +
+                         to_string(stats.count()) + " pairs from " + farm.checkpoint);
+        const auto start = steady::now();
+        for (unsigned w = 0; w < farm.workers; ++w)
+            local.push_back(local_worker{spawn(), start});
+
+        vector<pollfd> fds;
+        while (!terminate_requested && !finished())
+        {
+            reap(true);
+            check_timeouts();
+            fds.assign(1, pollfd{listen_fd, POLLIN, 0});
+            for (const auto &c : conns)
+                fds.push_back(pollfd{c.ch.fd, POLLIN, 0});
+            if (::poll(fds.data(), fds.size(), 200) <= 0)
+                continue;
+            if (fds[0].revents & POLLIN)
+            {
+                const int fd = ::accept(listen_fd, nullptr, nullptr);
+                if (fd >= 0)
+                {
+                    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+                    conns.push_back(connection{channel(fd), 0, -1, start});
+                }
+            }
+            // fds[k + 1] — conns[k]; соединения, добавленные выше, ещё не опрашивались
+            for (size_t k = fds.size() - 1; k-- > 0;)
+                if ((fds[k + 1].revents & (POLLIN | POLLHUP | POLLERR)) && !serve(conns[k]))
+                    drop(k);
+        }
+        ::close(listen_fd);
+        shutdown();
+        const double seconds = chrono::duration<double>(steady::now() - start).count();
+        report(seconds);
+        return 0;
+    }
+
+  private:
+    struct connection
+    {
+        channel ch;
+        pid_t pid;
+        int pair;
+        steady::time_point started;
+    };
+
+    struct local_worker
+    {
+        pid_t pid;
+        steady::time_point restart_at;
+    };
+
+    /**
+     * Читает журнал: пары из него считаются сыгранными. Журнал другого матча — ошибка.
+     * Журнал переписывается без оборванной последней строки.
+     */
+    bool resume()
+    {
+        ifstream fin(farm.checkpoint);
+        string line;
+        if (!fin || !getline(fin, line) || fin.eof())
+            return true;
+        if (line != "setup " + setup)
+        {
+            cerr << farm.checkpoint << " is from another match (" << line << "), remove it or use checkpoint=FILE\n";
+            return false;
+        }
+        vector<string> lines{line};
+        pair_result r;
+        while (getline(fin, line) && !fin.eof() && parse_result(line, r))
+            if (done.insert(r.pair).second)
+            {
+                add(r);
+                lines.push_back(line);
+            }
+        fin.close();
+        const string tmp = farm.checkpoint + ".tmp";
+        {
+            ofstream fout(tmp, ios::trunc);
+            for (const auto &l : lines)
+                fout << l << "\n";
+            if (!fout.flush())
+                return false;
+        }
+        resumed = true;
+        return ::rename(tmp.c_str(), farm.checkpoint.c_str()) == 0;
+    }
+
+    void add(const pair_result &r)
+    {
+        stats.add(r.a_white, r.a_black);
+        for (int s = 0; s < 2; ++s)
+        {
+            work[s] += r.work[s];
+            micros[s] += r.micros[s];
+        }
+        llr_value = llr(stats, opt.elo0, opt.elo1);
+    }
+
+    bool decided() const
+    {
+        return llr_value <= lower || llr_value >= upper;
+    }
+
+    bool finished() const
+    {
+        if (decided())
+            return true;
+        if (int(done.size()) < opt.pairs)
+            return false;
+        for (const auto &c : conns)
+            if (c.pair >= 0)
+                return false;
+        return true;
+    }
+
+    // следующая несыгранная и никому не выданная пара; -1 — таких нет
+    int next_pair()
+    {
+        if (!requeued.empty())
+        {
+            const int pair = *requeued.begin();
+            requeued.erase(requeued.begin());
+            return pair;
+        }
+        while (next < opt.pairs && done.count(next))
+            ++next;
+        return next < opt.pairs ? next++ : -1;
+    }
+
+    // выдаёт исполнителю пару или, если пар больше нет, done
+    bool assign(connection &c)
+    {
+        c.pair = decided() ? -1 : next_pair();
+        c.started = steady::now();
+        return c.ch.send(c.pair >= 0 ? "pair " + to_string(c.pair) : "done");
+    }
+
+    // false — соединение нужно закрыть
+    bool serve(connection &c)
+    {
+        if (!c.ch.fill())
+            return false;
+        string line;
+        while (c.ch.next_line(line))
+        {
+            pair_result r;
+            if (line.compare(0, 6, "hello ") == 0)
+            {
+                c.pid = pid_t(atol(line.c_str() + 6));
+                if (!c.ch.send("setup " + setup) || !assign(c))
+                    return false;
+            }
+            else if (parse_result(line, r) && r.pair == c.pair)
+            {
+                c.pair = -1;
+                if (done.insert(r.pair).second)
+                {
+                    journal << line << endl;
+                    add(r);
+                    print_stats(stats, llr_value, lower, upper);
+                }
+                if (!assign(c))
+                    return false;
+            }
+            else
+            {
+                cerr << "unexpected line from worker: " << line << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // закрывает соединение k; его пара возвращается в очередь
+    void drop(const size_t k)
+    {
+        connection &c = conns[k];
+        if (c.pair >= 0)
+            requeued.insert(c.pair);
+        ::close(c.ch.fd);
+        conns.erase(conns.begin() + ptrdiff_t(k));
+    }
+
+    // пары дольше timeout: локальный исполнитель завершается, соединение закрывается
+    void check_timeouts()
+    {
+        if (farm.timeout <= 0)
+            return;
+        const auto now = steady::now();
+        for (size_t k = conns.size(); k-- > 0;)
+        {
+            const connection &c = conns[k];
+            if (c.pair < 0 || now - c.started < chrono::seconds(farm.timeout))
+                continue;
+            cerr << "pair " << c.pair << " timed out on worker " << c.pid << "\n";
+            for (const auto &w : local)
+                if (w.pid == c.pid && w.pid > 0)
+                    ::kill(w.pid, SIGKILL);
+            drop(k);
+        }
+    }
+
+    pid_t spawn()
+    {
+        const pid_t pid = ::fork();
+        if (pid == 0)
+        {
+            ::execl(worker_exe.c_str(), worker_exe.c_str(), worker_arg.c_str(),
+                    archive_arg.empty() ? static_cast<char *>(nullptr) : archive_arg.c_str(), static_cast<char *>(nullptr));
+            _exit(127);
+        }
+        if (pid < 0)
+            cerr << "can't start " << worker_exe << "\n";
+        return pid;
+    }
+
+    /**
+     * Собирает завершившихся локальных исполнителей; при restart упавших запускает заново через kRestartDelay.
+     * Исполнитель, завершившийся по done, и исполнитель, который не удалось запустить, не перезапускаются.
+     */
+    void reap(const bool restart)
+    {
+        const auto now = steady::now();
+        for (auto &w : local)
+        {
+            if (w.pid > 0)
+            {
+                int status = 0;
+                if (::waitpid(w.pid, &status, WNOHANG) != w.pid)
+                    continue;
+                // 0 — пар больше нет (done), 127 — программу не удалось запустить
+                if (WIFEXITED(status) && (WEXITSTATUS(status) == 0 || WEXITSTATUS(status) == 127))
+                {
+                    if (WEXITSTATUS(status) == 127)
+                        cerr << "can't run " << worker_exe << "\n";
+                    w.pid = -1;
+                    w.restart_at = steady::time_point::max();
+                    continue;
+                }
+                if (restart)
+                {
+                    cerr << "worker " << w.pid << " "
+                         << (WIFSIGNALED(status) ? "killed by signal " + to_string(WTERMSIG(status))
+                                                 : "exited with code " + to_string(WEXITSTATUS(status)))
+                         << ", restarting\n";
+                }
+                w.pid = -1;
+                w.restart_at = now + kRestartDelay;
+            }
+            else if (restart && now >= w.restart_at)
+                w.pid = spawn();
+        }
+    }
+
+    // done всем исполнителям; локальные, не завершившиеся за kShutdownWait, завершаются принудительно
+    void shutdown()
+    {
+        for (auto &c : conns)
+        {
+            c.ch.send("done");
+            if (c.pair >= 0)
+                requeued.insert(c.pair);
+            ::close(c.ch.fd);
+        }
+        conns.clear();
+        const auto until = steady::now() + kShutdownWait;
+        auto running = [&]() {
+            reap(false);
+            for (const auto &w : local)
+                if (w.pid > 0)
+                    return true;
+            return false;
+        };
+        while (running() && steady::now() < until)
+            this_thread::sleep_for(chrono::milliseconds(20));
+        for (const auto &w : local)
+            if (w.pid > 0)
+            {
+                ::kill(w.pid, SIGKILL);
+                ::waitpid(w.pid, nullptr, 0);
+            }
+        local.clear();
+    }
+
+    void report(const double seconds) const
+    {
+        print_verdict(sides, opt, stats, llr_value, lower, upper, seconds, work, micros, terminate_requested);
+    }
+
+    engine_side (&sides)[2];
+    const match_options &opt;
+    const farm_options &farm;
+    const string setup;
+    const double lower, upper;
+    string worker_exe, worker_arg, archive_arg;
+
+    ofstream journal;
+    bool resumed = false;
+    vector<connection> conns;
+    vector<local_worker> local;
+    set<int> done, requeued;
+    int next = 0;
+
+    pair_stats stats;
+    double llr_value = 0;
+    uint64_t work[2]{}, micros[2]{};
+};
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    signal(SIGPIPE, SIG_IGN);
+    if ((argc == 2 || (argc == 3 && string(argv[2]).compare(0, 8, "archive=") == 0)) &&
+        string(argv[1]).compare(0, 7, "worker=") == 0)
+        return run_worker(string(argv[1]).substr(7), argc == 3 ? string(argv[2]).substr(8) : "");
+
+    engine_side sides[2];
+    match_options opt;
+    farm_options farm;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (parse_match_arg(sides, opt, argv[i]))
+            continue;
+        const string arg = argv[i];
+        const size_t eq = arg.find('=');
+        const string key = arg.substr(0, eq), value = (eq == string::npos ? "" : arg.substr(eq + 1));
+        bool ok = (eq != string::npos);
+        if (ok && key == "workers")
+            farm.workers = unsigned(max(0, stoi(value)));
+        else if (ok && key == "listen")
+            farm.listen = value;
+        else if (ok && key == "exe")
+            farm.exe = value;
+        else if (ok && key == "checkpoint")
+            farm.checkpoint = value;
+        else if (ok && key == "timeout")
+            farm.timeout = stoi(value);
+        else
+            ok = false;
+        if (!ok)
+        {
+            cerr << "usage: checkers_farm [a.<key>=<value> ...] [b.<key>=<value> ...] [pairs=N] [workers=N] "
+                    "[listen=ADDR:PORT] [exe=PATH] [checkpoint=FILE] [timeout=S] [depth=N] [nodes=N] "
+                    "[movetime=MS] [plies=N] [elo0=E] [elo1=E] [alpha=P] [beta=P] [seed=N] [archive=FILE]\n"
+                    "       checkers_farm worker=HOST:PORT [archive=FILE]\n";
+            return 1;
+        }
+    }
+    signal(SIGINT, [](int) { terminate_requested = 1; });
+    signal(SIGTERM, [](int) { terminate_requested = 1; });
+    Coordinator coordinator(sides, opt, farm);
+    return coordinator.run(argv[0]);
+}
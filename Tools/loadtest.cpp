@@ -0,0 +1,88 @@
+/**
+ * checkers_loadtest — нагрузочный тест сервера движка (checkers_server).
+ *
+ * Запуск: checkers_loadtest [socket] [sessions] [games] [movetime_ms]
+ *   sessions — число одновременных сессий (по потоку на сессию),
+ *   games    — партий на сессию (сервер играет обе стороны),
+ *   movetime — время на ход в go.
+ * Партия идёт до "bestmove (none)" или "MaxNumTurns" полуходов.
+ * Итог: ходов в секунду и задержка ответа на go (p50 / p90 / p99 / max),
+ * плюс счётчики сервера (stats).
+ */
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../Game/Config.h"
+#include "Client.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    const string socket_path = (argc > 1 ? argv[1] : "/tmp/checkers.sock");
+    const int sessions = (argc > 2 ? atoi(argv[2]) : 8);
+    const int games = (argc > 3 ? atoi(argv[3]) : 2);
+    const int movetime = (argc > 4 ? atoi(argv[4]) : 50);
+    Config config;
+    const int max_turns = config("Game", "MaxNumTurns");
+
+    mutex stats_mutex;
+    vector<double> latencies;
+    int failed = 0;
+
+    const auto start = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (int id = 0; id < sessions; ++id)
+    {
+        pool.emplace_back([&]() {
+            EngineClient client;
+            vector<double> local;
+            bool ok = client.connect(socket_path) && client.handshake();
+            for (int game = 0; ok && game < games; ++game)
+            {
+                string moves;
+                for (int ply = 0; ply < max_turns; ++ply)
+                {
+                    const auto t0 = chrono::steady_clock::now();
+                    const string move = client.best_move("startpos" + (moves.empty() ? "" : " moves" + moves),
+                                                         "movetime " + to_string(movetime));
+                    local.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count());
+                    if (move.empty())
+                        ok = false;
+                    if (move.empty() || move == "(none)")
+                        break;
+                    moves += " " + move;
+                }
+            }
+            lock_guard<mutex> lock(stats_mutex);
+            latencies.insert(latencies.end(), local.begin(), local.end());
+            failed += !ok;
+        });
+    }
+    for (auto &th : pool)
+        th.join();
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (latencies.empty())
+    {
+        cerr << "no answers from " << socket_path << "\n";
+        return 1;
+    }
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](const double q) { return latencies[min(latencies.size() - 1, size_t(q * latencies.size()))]; };
+    cout << fixed << setprecision(1);
+    cout << "sessions " << sessions << ", moves " << latencies.size() << ", failed sessions " << failed << "\n";
+    cout << "moves/s " << latencies.size() / seconds << " (" << seconds << " s)\n";
+    cout << "latency ms: p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99)
+         << ", max " << latencies.back() << "\n";
+
+    EngineClient client;
+    if (client.connect(socket_path) && client.send("stats"))
+        cout << client.wait_for("info string stats") << "\n";
+    return failed ? 1 : 0;
+}
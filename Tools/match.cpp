@@ -0,0 +1,94 @@
+/**
+ * checkers_match — матч двух конфигураций бота с последовательным тестом SPRT.
+ *
+ * Запуск: checkers_match [a.<ключ>=<значение> ...] [b.<ключ>=<значение> ...] [параметр=значение ...]
+ *   a.<ключ>, b.<ключ> — переопределение параметра секции "Bot" из settings.json для стороны A / B
+ *                         ("a.BotScoringType=NNUE", "b.WeightsFile=new.json"); "a.<секция>.<ключ>" — другой секции.
+ *                         Значение разбирается как JSON, иначе берётся строкой.
+ *   pairs=N      — наибольшее число пар партий (по умолчанию 1000)
+ *   threads=N    — партий одновременно (по умолчанию число ядер)
+ *   depth=N      — глубина поиска обеих сторон (по умолчанию "WhiteBotLevel" / "BlackBotLevel" + 1 каждой стороны)
+ *   nodes=N      — лимит узлов на ход (итеративное углубление до depth; у MCTS — разыгрываний)
+ *   movetime=MS  — время на ход обеих сторон: alpha-beta углубляется до него (до глубины depth или 40),
+ *                  MCTS ("a.Engine=MCTS") думает столько вместо "MctsTimeMS"
+ *   plies=N      — случайных полуходов в дебюте (по умолчанию 6)
+ *   elo0, elo1   — гипотезы H0 / H1 о преимуществе A над B в Эло (по умолчанию 0 и 10)
+ *   alpha, beta  — ошибки первого и второго рода (по умолчанию 0.05)
+ *   seed=N       — зерно дебютов (одинаковое зерно — одинаковые дебюты)
+ *   archive=FILE — дописывать сыгранные партии в архив FILE (Game/Archive.h, поиск — checkers_archive);
+ *                  без него партии не записываются
+ *
+ * Партии идут парами: из одного случайного дебюта A играет сначала белыми, затем чёрными.
+ * Итог пары (0..2 очка A) даёт пентаномиальную статистику, по ней после каждой пары
+ * считается логарифм отношения правдоподобия (GSPRT); матч останавливается, как только он
+ * выходит за границу: H1 — A сильнее хотя бы на elo1, H0 — преимущества elo1 нет.
+ * Итог: счёт, разница в Эло с 95% интервалом и LLR, скорость каждой стороны (узлов или разыгрываний в секунду).
+ * Партии идут в threads потоков, поэтому MCTS в матче стоит ограничить: "a.MctsThreads=1".
+ */
+#include <mutex>
+
+#include "Selfplay.h"
+
+int main(int argc, char *argv[])
+{
+    engine_side sides[2];
+    match_options opt;
+    for (int i = 1; i < argc; ++i)
+        if (!parse_match_arg(sides, opt, argv[i]))
+        {
+            cerr << "usage: checkers_match [a.<key>=<value> ...] [b.<key>=<value> ...] [pairs=N] [threads=N] "
+                    "[depth=N] [nodes=N] [movetime=MS] [plies=N] [elo0=E] [elo1=E] [alpha=P] [beta=P] [seed=N] "
+                    "[archive=FILE]\n";
+            return 1;
+        }
+    const int max_turns = sides[0].config("Game", "MaxNumTurns");
+    const int draw_plies = 2 * int(sides[0].config("Game", "KingMovesDraw"));
+    const auto archive = open_archive(sides[0], opt.archive_file);
+    opt.archive = archive.get();
+    const double lower = log(opt.beta / (1 - opt.alpha)), upper = log((1 - opt.beta) / opt.alpha);
+    print_header(sides, opt, to_string(opt.threads) + " threads");
+
+    mutex stats_mutex;
+    pair_stats stats;
+    atomic<int> next_pair{0};
+    atomic<bool> decided{false};
+    double llr_value = 0;
+
+    if (opt.movetime > 0)
+        for (auto &side : sides)
+            side.config.set("Bot", "MctsTimeMS", opt.movetime);
+
+    auto worker = [&]() {
+        player a(sides[0]), b(sides[1]);
+        for (player *p : {&a, &b})
+            if (p->mcts)
+                p->mcts->playout_limit = opt.nodes;
+        int depths[2][2];
+        side_depths(sides, opt, depths);
+        int pair;
+        while (!decided && (pair = next_pair++) < opt.pairs)
+        {
+            int a_white, a_black;
+            play_pair(a, b, depths, opt, pair, max_turns, draw_plies, a_white, a_black);
+
+            lock_guard<mutex> lock(stats_mutex);
+            stats.add(a_white, a_black);
+            llr_value = llr(stats, opt.elo0, opt.elo1);
+            if (!decided)
+                print_stats(stats, llr_value, lower, upper);
+            if (llr_value <= lower || llr_value >= upper)
+                decided = true;
+        }
+    };
+    const auto start = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (unsigned t = 0; t < opt.threads; ++t)
+        pool.emplace_back(worker);
+    for (auto &th : pool)
+        th.join();
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    const uint64_t work[2] = {sides[0].work, sides[1].work}, micros[2] = {sides[0].micros, sides[1].micros};
+    print_verdict(sides, opt, stats, llr_value, lower, upper, seconds, work, micros);
+    return 0;
+}
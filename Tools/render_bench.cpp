@@ -0,0 +1,286 @@
+/**
+ * checkers_render_bench — бенчмарк отрисовки Board без дисплея и видеокарты.
+ *
+ * Запуск: checkers_render_bench [sizes=640x640,1024x1024,...] [games=N] [file=<games.txt>] [seed=N] [variant=<имя>]
+ *   sizes   — размеры окна, для каждого — отдельный прогон (по умолчанию 480x480, 800x800, 1200x1200, 1920x1080)
+ *   games   — число случайных партий (по умолчанию 20), если не задан file
+ *   file    — записанные партии: по партии в строке, ходы в нотации Models/Notation.h (как в book.txt; только 8x8)
+ *   seed    — зерно случайных партий
+ *   variant — правила ("Russian", "English", "International"), по умолчанию "Game" → "Variant" из settings.json
+ *
+ * SDL запускается с видеодрайвером dummy и программным рендерером, так что бенчмарк идёт
+ * на серверах сборки без X11/Wayland и GPU. Частота кадров не ограничивается: каждый update() рисует.
+ * Для каждого размера окна воспроизводится одно и то же:
+ *   highlight — подсветка фигур, которыми можно ходить, и выбор фигуры (как в Game::player_turn);
+ *   move      — ход по прыжкам (Board::move_piece) со снятием подсветки;
+ *   resize    — смена размера окна туда и обратно (reset_window_size, пересоздание текстур, полный кадр).
+ * Время каждого кадра — изменение состояния и update(); итог — перцентили времени кадра и кадры в секунду.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include "../Game/Board.h"
+#include "../Game/Logic.h"
+#include "../Models/Notation.h"
+
+namespace
+{
+// предел длины случайной партии в полуходах
+const int kMaxPlies = 200;
+
+// смен размера окна на каждый размер
+const int kResizes = 20;
+
+struct bench_options
+{
+    vector<pair<int, int>> sizes{{480, 480}, {800, 800}, {1200, 1200}, {1920, 1080}};
+    int games = 20;
+    string file;
+    unsigned seed = 1;
+    string variant;
+};
+
+// записанная партия: позиции не нужны, только ходы по прыжкам и клетки для подсветки перед каждым ходом
+struct recorded_turn
+{
+    vector<pair<POS_T, POS_T>> movable;
+    vector<move_pos> steps;
+};
+using recorded_game = vector<recorded_turn>;
+
+// времена кадров одного вида (микросекунды)
+struct frame_times
+{
+    vector<double> us;
+
+    template <class F> void measure(F &&frame)
+    {
+        const auto start = chrono::steady_clock::now();
+        frame();
+        us.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    }
+
+    double percentile(const double p) const
+    {
+        if (us.empty())
+            return 0;
+        vector<double> sorted = us;
+        const size_t k = min(sorted.size() - 1, size_t(p * double(sorted.size() - 1) + 0.5));
+        nth_element(sorted.begin(), sorted.begin() + ptrdiff_t(k), sorted.end());
+        return sorted[k];
+    }
+
+    double total() const
+    {
+        double sum = 0;
+        for (const double t : us)
+            sum += t;
+        return sum;
+    }
+};
+
+/**
+ * Ходы стороны color в позиции mtx — клетки фигур, которыми можно ходить.
+ */
+template <class Rules>
+vector<pair<POS_T, POS_T>> movable_cells(BasicLogic<Rules> &logic, const bool color, const vector<vector<POS_T>> &mtx)
+{
+    logic.find_turns(color, mtx);
+    vector<pair<POS_T, POS_T>> cells;
+    for (const auto &turn : logic.turns)
+        if (find(cells.begin(), cells.end(), make_pair(turn.x, turn.y)) == cells.end())
+            cells.emplace_back(turn.x, turn.y);
+    return cells;
+}
+
+/**
+ * Партии для воспроизведения: из файла (ходы в нотации) или случайные с зерном seed.
+ */
+template <class Rules> vector<recorded_game> record_games(BasicLogic<Rules> &logic, const bench_options &opt)
+{
+    constexpr int N = Rules::size;
+    vector<recorded_game> games;
+    if (!opt.file.empty())
+    {
+        ifstream fin(opt.file);
+        string line;
+        while (N == 8 && getline(fin, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            istringstream in(line);
+            auto mtx = start_position(N);
+            bool color = false;
+            recorded_game game;
+            string token;
+            while (in >> token)
+            {
+                const auto movable = movable_cells(logic, color, mtx);
+                const auto steps = logic.resolve_series(color, mtx, parse_series(token));
+                if (steps.empty())
+                    break;
+                for (const auto &step : steps)
+                    mtx = logic.make_turn(mtx, step);
+                game.push_back({movable, steps});
+                color = !color;
+            }
+            if (!game.empty())
+                games.push_back(game);
+        }
+        return games;
+    }
+    mt19937 rng(opt.seed);
+    for (int g = 0; g < opt.games; ++g)
+    {
+        auto mtx = start_position(N);
+        bool color = false;
+        recorded_game game;
+        for (int ply = 0; ply < kMaxPlies; ++ply)
+        {
+            const auto movable = movable_cells(logic, color, mtx);
+            if (logic.turns.empty())
+                break;
+            const move_pos turn = logic.turns[rng() % logic.turns.size()];
+            game.push_back({movable, logic.series_steps(mtx, turn)});
+            mtx = logic.make_turn(mtx, turn);
+            color = !color;
+        }
+        games.push_back(game);
+    }
+    return games;
+}
+
+void print_row(const string &what, const frame_times &t)
+{
+    cout << "  " << left << setw(10) << what << right << setw(8) << t.us.size() << fixed << setprecision(3)
+         << setw(10) << t.percentile(0.5) / 1000 << setw(10) << t.percentile(0.9) / 1000 << setw(10)
+         << t.percentile(0.99) / 1000 << setw(10) << t.percentile(1.0) / 1000 << setprecision(0) << setw(10)
+         << (t.total() > 0 ? double(t.us.size()) * 1e6 / t.total() : 0.0) << "\n";
+}
+
+/**
+ * Прогон для окна w x h: партии (подсветка, выбор, ходы) и смены размера окна.
+ */
+template <class Rules> bool run_size(const vector<recorded_game> &games, const int w, const int h)
+{
+    Board board(w, h, Rules::size);
+    if (board.start_draw())
+    {
+        cerr << "can't start SDL (see log.txt)\n";
+        return false;
+    }
+    board.set_frame_interval(chrono::steady_clock::duration::zero());
+    frame_times highlight, move, resize;
+    for (const auto &game : games)
+    {
+        board.redraw();
+        board.update();
+        int beat_series = 0;
+        for (const auto &turn : game)
+        {
+            highlight.measure([&]() {
+                board.highlight_cells(turn.movable);
+                board.update();
+            });
+            highlight.measure([&]() {
+                board.clear_highlight();
+                board.set_active(turn.steps[0].x, turn.steps[0].y);
+                board.highlight_cells({{turn.steps[0].x2, turn.steps[0].y2}});
+                board.update();
+            });
+            for (const auto &step : turn.steps)
+            {
+                move.measure([&]() {
+                    board.clear_active();
+                    board.clear_highlight();
+                    beat_series += (step.xb != -1);
+                    board.move_piece(step, beat_series, step.crown);
+                    board.update();
+                });
+            }
+            beat_series = 0;
+        }
+    }
+    for (int k = 0; k < kResizes; ++k)
+    {
+        resize.measure([&]() {
+            board.resize_window(k % 2 ? w : w * 3 / 4, k % 2 ? h : h * 3 / 4);
+            board.update();
+        });
+    }
+    cout << w << "x" << h << " (" << board.W << "x" << board.H << ")\n"
+         << "  frame       frames   p50 ms    p90 ms    p99 ms    max ms       fps\n";
+    print_row("highlight", highlight);
+    print_row("move", move);
+    print_row("resize", resize);
+    board.quit();
+    return true;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    bench_options opt;
+    for (int i = 1; i < argc; ++i)
+    {
+        const string arg = argv[i];
+        const size_t eq = arg.find('=');
+        const string key = arg.substr(0, eq), value = (eq == string::npos ? "" : arg.substr(eq + 1));
+        if (key == "sizes")
+        {
+            opt.sizes.clear();
+            istringstream in(value);
+            string size;
+            while (getline(in, size, ','))
+            {
+                int w = 0, h = 0;
+                char x = 0;
+                istringstream(size) >> w >> x >> h;
+                if (w > 0 && h > 0 && x == 'x')
+                    opt.sizes.emplace_back(w, h);
+            }
+        }
+        else if (key == "games")
+            opt.games = stoi(value);
+        else if (key == "file")
+            opt.file = value;
+        else if (key == "seed")
+            opt.seed = unsigned(stoul(value));
+        else if (key == "variant")
+            opt.variant = value;
+        else
+        {
+            cerr << "usage: checkers_render_bench [sizes=WxH,...] [games=N] [file=<games.txt>] [seed=N] "
+                    "[variant=Russian|English|International]\n";
+            return 1;
+        }
+    }
+    // без дисплея, GPU и звука: драйверы-заглушки и программный рендерер (уже заданные переменные окружения не меняются);
+    // Board::start_draw инициализирует все подсистемы SDL, поэтому и звук
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    SDL_setenv("SDL_RENDER_DRIVER", "software", 0);
+
+    Config config;
+    if (opt.variant.empty())
+        opt.variant = string(config("Game", "Variant"));
+    bool ok = true;
+    with_variant(opt.variant, [&](auto rules) {
+        using Rules = decltype(rules);
+        BasicLogic<Rules> logic(&config);
+        const auto games = record_games(logic, opt);
+        size_t frames = 0;
+        for (const auto &game : games)
+            for (const auto &turn : game)
+                frames += 2 + turn.steps.size();
+        cout << Rules::name << ": " << games.size() << " games, " << frames << " frames per window size\n";
+        for (const auto &size : opt.sizes)
+            ok = run_size<Rules>(games, size.first, size.second) && ok;
+    });
+    return ok ? 0 : 1;
+}
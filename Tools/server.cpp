@@ -0,0 +1,472 @@
+/**
+ * checkers_server — долгоживущий сервер движка для многих партий одновременно.
+ *
+ * Запуск: checkers_server [socket] [workers] [hash_mb]
+ *   socket  — путь Unix-сокета (по умолчанию /tmp/checkers.sock),
+ *   workers — число потоков поиска (по умолчанию — число ядер),
+ *   hash_mb — размер общей таблицы транспозиций (по умолчанию "HashMB" из settings.json).
+ *
+ * Каждое соединение — сессия со своей позицией; протокол тот же, что у checkers_engine
+ * (Tools/engine.cpp): checkers, isready, setoption (MultiPV, OwnBook), newgame, position, go, stop, quit,
+ * плюс stats — счётчики сервера. go infinite / ponder не поддерживаются: поиск ограничен временем.
+ *
+ * Планирование: у сессии не больше одного поиска, поэтому одна сессия не может занять
+ * несколько потоков; очередь поисков упорядочена по сроку (earliest deadline first).
+ * Срок — момент прихода go плюс время на ход (movetime / часы, иначе kMaxMoveMs = 10 с),
+ * время ожидания в очереди входит в срок. Поиск, чей срок истёк, останавливается после
+ * глубины 1 (она выполняется всегда, чтобы был ход).
+ *
+ * Общие для всех сессий: таблица транспозиций (без блокировок, см. Game/Transposition.h)
+ * и дебютная книга "BookFile" — ход из книги отдаётся сразу, без очереди.
+ */
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../Game/Book.h"
+#include "Protocol.h"
+
+namespace
+{
+// предельная глубина итеративного углубления
+const int kMaxDepth = 40;
+
+// время на ход, если в go нет ни movetime, ни часов
+const long long kMaxMoveMs = 10000;
+
+// опоздание ответа, после которого срок считается пропущенным (статистика stats)
+const auto kDeadlineSlack = chrono::milliseconds(10);
+
+using steady = chrono::steady_clock;
+
+volatile sig_atomic_t terminate_requested = 0;
+
+struct Session;
+
+// один запрос go
+struct Job
+{
+    shared_ptr<Session> session;
+    game_position position;
+    size_t multipv = 1;
+    int max_depth = kMaxDepth;
+    uint64_t nodes = 0;
+    bool early_exit = true;
+    steady::time_point arrival, deadline;
+    uint64_t seq = 0;
+    atomic<bool> stop{false};
+};
+
+struct Session
+{
+    explicit Session(const int fd) : fd(fd), rng(unsigned(fd) * 7919u + unsigned(steady::now().time_since_epoch().count()))
+    {
+    }
+
+    /**
+     * Отправляет строку клиенту; после закрытия сессии ничего не делает.
+     */
+    void send(const string &line)
+    {
+        lock_guard<mutex> lock(out_mutex);
+        if (closed)
+            return;
+        const string data = line + "\n";
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                return;
+            sent += size_t(n);
+        }
+    }
+
+    void close()
+    {
+        {
+            lock_guard<mutex> lock(job_mutex);
+            if (job)
+                job->stop = true;
+        }
+        lock_guard<mutex> lock(out_mutex);
+        if (!closed)
+            ::close(fd);
+        closed = true;
+    }
+
+    const int fd;
+    mutex out_mutex;
+    bool closed = false;
+
+    // текущий поиск сессии (nullptr — сессия свободна)
+    mutex job_mutex;
+    shared_ptr<Job> job;
+
+    // состояние, которое меняет только поток ввода-вывода
+    string input;
+    game_position position;
+    size_t multipv = 1;
+    bool own_book = true;
+    mt19937 rng;
+};
+
+/**
+ * Пул потоков поиска с очередью по сроку и сторожем времени.
+ */
+class Scheduler
+{
+  public:
+    Scheduler(Config &config, shared_ptr<TranspositionTable> tt, const unsigned workers) : config(config), tt(tt)
+    {
+        for (unsigned i = 0; i < workers; ++i)
+            pool.emplace_back(&Scheduler::work, this);
+        watchdog = thread(&Scheduler::watch, this);
+    }
+
+    ~Scheduler()
+    {
+        {
+            lock_guard<mutex> lock(m);
+            shutting_down = true;
+            for (auto &job : running)
+                job->stop = true;
+        }
+        cv.notify_all();
+        for (auto &th : pool)
+            th.join();
+        watchdog.join();
+    }
+
+    void submit(const shared_ptr<Job> &job)
+    {
+        {
+            lock_guard<mutex> lock(m);
+            job->seq = next_seq++;
+            queue.push(job);
+        }
+        cv.notify_all();
+    }
+
+    string stats()
+    {
+        lock_guard<mutex> lock(m);
+        return "info string stats searches " + to_string(done) + " queued " + to_string(queue.size()) + " running " +
+               to_string(running.size()) + " nodes " + to_string(nodes) + " missed_deadlines " +
+               to_string(missed);
+    }
+
+  private:
+    struct later
+    {
+        bool operator()(const shared_ptr<Job> &a, const shared_ptr<Job> &b) const
+        {
+            return a->deadline != b->deadline ? a->deadline > b->deadline : a->seq > b->seq;
+        }
+    };
+
+    void work()
+    {
+        // у каждого потока свой Logic (рабочие буферы поиска), таблица транспозиций — общая
+        Logic logic(&config, tt);
+        while (true)
+        {
+            shared_ptr<Job> job;
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [this]() { return shutting_down || !queue.empty(); });
+                if (shutting_down)
+                    return;
+                job = queue.top();
+                queue.pop();
+                if (steady::now() >= job->deadline)
+                    job->stop = true;
+                running.push_back(job);
+            }
+            cv.notify_all();
+
+            const auto start = steady::now();
+            logic.history = job->position.history;
+            logic.king_plies = job->position.king_plies;
+            const auto lines = logic.iterative_search(
+                job->position.color, job->position.mtx, job->multipv, job->max_depth, job->nodes, &job->stop, job->early_exit,
+                [&](const int depth, const vector<analysis_line> &result, const uint64_t total) {
+                    const long long ms = chrono::duration_cast<chrono::milliseconds>(steady::now() - start).count();
+                    for (size_t k = 0; k < result.size(); ++k)
+                        job->session->send(info_line(depth, k + 1, result[k], total, ms));
+                });
+
+            {
+                lock_guard<mutex> lock(m);
+                running.erase(find(running.begin(), running.end(), job));
+                ++done;
+                nodes += logic.nodes;
+                missed += (steady::now() > job->deadline + kDeadlineSlack);
+            }
+            // сессия освобождается до ответа: клиент может сразу прислать следующий go
+            {
+                lock_guard<mutex> lock(job->session->job_mutex);
+                job->session->job.reset();
+            }
+            job->session->send(bestmove_line(lines));
+        }
+    }
+
+    // останавливает поиски, у которых истёк срок
+    void watch()
+    {
+        unique_lock<mutex> lock(m);
+        while (!shutting_down)
+        {
+            auto wake = steady::time_point::max();
+            const auto now = steady::now();
+            for (auto &job : running)
+            {
+                if (job->deadline <= now)
+                    job->stop = true;
+                else
+                    wake = min(wake, job->deadline);
+            }
+            if (wake == steady::time_point::max())
+                cv.wait(lock);
+            else
+                cv.wait_until(lock, wake);
+        }
+    }
+
+    Config &config;
+    shared_ptr<TranspositionTable> tt;
+    vector<thread> pool;
+    thread watchdog;
+
+    mutex m;
+    condition_variable cv;
+    priority_queue<shared_ptr<Job>, vector<shared_ptr<Job>>, later> queue;
+    vector<shared_ptr<Job>> running;
+    bool shutting_down = false;
+    uint64_t next_seq = 0;
+    uint64_t done = 0, nodes = 0, missed = 0;
+};
+
+class Server
+{
+  public:
+    Server(Config &config, shared_ptr<TranspositionTable> tt, const Book &book, const unsigned workers)
+        : config(config), book(book), logic(&config, tt), scheduler(config, tt, workers)
+    {
+    }
+
+    /**
+     * Принимает соединения и команды до SIGINT / SIGTERM.
+     */
+    int run(const string &socket_path)
+    {
+        const int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (listen_fd < 0 || socket_path.size() >= sizeof(addr.sun_path))
+        {
+            cerr << "can't create socket " << socket_path << "\n";
+            return 1;
+        }
+        socket_path.copy(addr.sun_path, socket_path.size());
+        ::unlink(socket_path.c_str());
+        if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(listen_fd, 128) != 0)
+        {
+            cerr << "can't listen on " << socket_path << "\n";
+            ::close(listen_fd);
+            return 1;
+        }
+        cerr << "listening on " << socket_path << "\n";
+
+        map<int, shared_ptr<Session>> sessions;
+        vector<pollfd> fds;
+        while (!terminate_requested)
+        {
+            fds.assign(1, pollfd{listen_fd, POLLIN, 0});
+            for (const auto &[fd, session] : sessions)
+                fds.push_back(pollfd{fd, POLLIN, 0});
+            if (::poll(fds.data(), fds.size(), 200) <= 0)
+                continue;
+            if (fds[0].revents & POLLIN)
+            {
+                const int fd = ::accept(listen_fd, nullptr, nullptr);
+                if (fd >= 0)
+                    sessions[fd] = make_shared<Session>(fd);
+            }
+            for (size_t i = 1; i < fds.size(); ++i)
+            {
+                if (!fds[i].revents)
+                    continue;
+                auto session = sessions[fds[i].fd];
+                char chunk[4096];
+                const ssize_t n = ::recv(fds[i].fd, chunk, sizeof(chunk), 0);
+                bool open = n > 0;
+                if (open)
+                {
+                    session->input.append(chunk, size_t(n));
+                    size_t end;
+                    while (open && (end = session->input.find('\n')) != string::npos)
+                    {
+                        const string line = session->input.substr(0, end);
+                        session->input.erase(0, end + 1);
+                        open = handle(session, line);
+                    }
+                }
+                if (!open)
+                {
+                    session->close();
+                    sessions.erase(fds[i].fd);
+                }
+            }
+        }
+        for (auto &[fd, session] : sessions)
+            session->close();
+        ::close(listen_fd);
+        ::unlink(socket_path.c_str());
+        return 0;
+    }
+
+  private:
+    // false — закрыть сессию
+    bool handle(const shared_ptr<Session> &self, const string &line)
+    {
+        Session &s = *self;
+        istringstream in(line);
+        string cmd;
+        if (!(in >> cmd))
+            return true;
+        if (cmd == "checkers")
+        {
+            s.send("id name Checkers server");
+            s.send("option name MultiPV type spin default 1 min 1 max 64");
+            s.send("option name OwnBook type check default true");
+            s.send("checkersok");
+        }
+        else if (cmd == "isready")
+            s.send("readyok");
+        else if (cmd == "setoption")
+        {
+            string token, name, value;
+            in >> token >> name >> token;
+            getline(in >> ws, value);
+            if (name == "MultiPV")
+                s.multipv = size_t(max(1, atoi(value.c_str())));
+            else if (name == "OwnBook")
+                s.own_book = (value == "true" || value == "1");
+            else
+                s.send("info string option " + name + " is set on the server side");
+        }
+        else if (cmd == "newgame")
+        {
+            s.position = game_position();
+        }
+        else if (cmd == "position")
+        {
+            string error;
+            if (!parse_position(in, logic, s.position, error))
+                s.send("info string " + error);
+        }
+        else if (cmd == "go")
+            go(s, self, parse_go(in));
+        else if (cmd == "stop")
+        {
+            lock_guard<mutex> lock(s.job_mutex);
+            if (s.job)
+                s.job->stop = true;
+        }
+        else if (cmd == "stats")
+            s.send(scheduler.stats() + " book_hits " + to_string(book_hits) + " book_positions " +
+                   to_string(book.size()));
+        else if (cmd == "quit")
+            return false;
+        else
+            s.send("info string unknown command " + cmd);
+        return true;
+    }
+
+    void go(Session &s, const shared_ptr<Session> &self, const go_params &p)
+    {
+        lock_guard<mutex> lock(s.job_mutex);
+        if (s.job)
+        {
+            s.send("info string search already running");
+            return;
+        }
+        if (s.own_book && !p.nodes && p.depth <= 0)
+        {
+            const auto series = book.choose(s.position.mtx, s.position.color, s.rng, !config("Bot", "NoRandom"));
+            if (!series.empty())
+            {
+                ++book_hits;
+                analysis_line line;
+                line.pv.push_back(series);
+                s.send("info string book");
+                s.send(bestmove_line({line}));
+                return;
+            }
+        }
+        auto job = make_shared<Job>();
+        job->session = self;
+        job->position = s.position;
+        job->multipv = s.multipv;
+        job->nodes = p.nodes;
+        job->max_depth = (p.depth > 0 ? p.depth : kMaxDepth);
+        job->early_exit = (p.depth <= 0);
+        job->arrival = steady::now();
+        const long long budget = move_budget_ms(p, s.position.color);
+        job->deadline = job->arrival + chrono::milliseconds(budget >= 0 ? budget : kMaxMoveMs);
+        s.job = job;
+        scheduler.submit(job);
+    }
+
+    Config &config;
+    const Book &book;
+    // разбор ходов в position (только поток ввода-вывода)
+    Logic logic;
+    Scheduler scheduler;
+    uint64_t book_hits = 0;
+};
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        Config config;
+        const string socket_path = (argc > 1 ? argv[1] : "/tmp/checkers.sock");
+        const unsigned workers = (argc > 2 ? unsigned(atoi(argv[2])) : max(1u, thread::hardware_concurrency()));
+        const size_t hash_mb = (argc > 3 ? size_t(atoll(argv[3])) : size_t(config("Bot", "HashMB")));
+
+        auto tt = make_shared<TranspositionTable>(hash_mb);
+        Book book;
+        Logic loader(&config, tt);
+        const string book_file = config("Bot", "BookFile");
+        if (!book.load(project_path + book_file, loader))
+            cerr << "can't load book " << book_file << ", searching from the first move\n";
+
+        signal(SIGINT, [](int) { terminate_requested = 1; });
+        signal(SIGTERM, [](int) { terminate_requested = 1; });
+        signal(SIGPIPE, SIG_IGN);
+
+        Server server(config, tt, book, max(1u, workers));
+        return server.run(socket_path);
+    }
+    catch (const exception &e)
+    {
+        cerr << "error: " << e.what() << "\n";
+        return 1;
+    }
+}
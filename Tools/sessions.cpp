@@ -0,0 +1,197 @@
+/**
+ * checkers_sessions — много партий в одном процессе на маленьком пуле потоков (Game/Session.h).
+ *
+ * Запуск: checkers_sessions [games=N] [threads=N] [level=N] [profile=<имя>] [think=MS] [seed=N]
+ *   games   — партий одновременно (по умолчанию 1000)
+ *   threads — потоков пула (по умолчанию число ядер)
+ *   level   — уровень движка (как "WhiteBotLevel"; по умолчанию 2)
+ *   profile — профиль сложности движка из "Profiles" вместо уровня (Game/Profile.h)
+ *   think   — наибольшая задержка ответа удалённого игрока, мс (по умолчанию 200)
+ *   seed    — зерно удалённых игроков
+ *
+ * Во всех партиях движок играет белыми, чёрными — «удалённый игрок»: случайный допустимый ход
+ * после случайной задержки до think мс. Удалённых игроков изображает один поток таймера, как
+ * сетевые клиенты: пока игрок думает, партия ждёт, не занимая поток пула.
+ * Итог: результаты, время, партий и ходов в секунду, наибольшее число партий, ждавших ход одновременно,
+ * узлы поиска на ход движка — в среднем и наибольшее (для профиля оно не больше его бюджета).
+ */
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <random>
+
+#include "../Game/Session.h"
+
+namespace
+{
+using steady = chrono::steady_clock;
+
+/**
+ * Удалённые игроки: отвечают на запросы с задержкой, все — из одного потока.
+ */
+class RemotePlayers
+{
+  public:
+    RemotePlayers(const int think_ms, const unsigned seed) : think_ms(think_ms), rng(seed), timer([this]() { run(); })
+    {
+    }
+
+    ~RemotePlayers()
+    {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        timer.join();
+    }
+
+    void request(const shared_ptr<Session> &session, const turn_request &req)
+    {
+        {
+            lock_guard<mutex> lock(m);
+            const move_pos turn = req.turns[rng() % req.turns.size()];
+            const auto at = steady::now() + chrono::milliseconds(think_ms > 0 ? rng() % unsigned(think_ms + 1) : 0);
+            replies.push(reply{at, session, req.ticket, turn});
+            waiting = max(waiting, replies.size());
+        }
+        cv.notify_one();
+    }
+
+    // наибольшее число партий, одновременно ждавших ответа
+    size_t peak() const
+    {
+        lock_guard<mutex> lock(m);
+        return waiting;
+    }
+
+  private:
+    struct reply
+    {
+        steady::time_point at;
+        shared_ptr<Session> session;
+        uint64_t ticket;
+        move_pos turn;
+
+        bool operator<(const reply &other) const
+        {
+            return at > other.at;
+        }
+    };
+
+    void run()
+    {
+        unique_lock<mutex> lock(m);
+        while (!stopping)
+        {
+            if (replies.empty())
+            {
+                cv.wait(lock);
+                continue;
+            }
+            if (cv.wait_until(lock, replies.top().at) != cv_status::timeout && steady::now() < replies.top().at)
+                continue;
+            const reply r = replies.top();
+            replies.pop();
+            lock.unlock();
+            r.session->deliver(r.ticket, r.turn);
+            lock.lock();
+        }
+    }
+
+    const int think_ms;
+    mt19937 rng;
+    mutable mutex m;
+    condition_variable cv;
+    priority_queue<reply> replies;
+    size_t waiting = 0;
+    bool stopping = false;
+    thread timer;
+};
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int games = 1000, level = 2, think = 200;
+    string profile_name;
+    unsigned threads = max(1u, thread::hardware_concurrency()), seed = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        const string arg = argv[i];
+        const size_t eq = arg.find('=');
+        const string key = arg.substr(0, eq), value = (eq == string::npos ? "" : arg.substr(eq + 1));
+        if (key == "games")
+            games = stoi(value);
+        else if (key == "threads")
+            threads = unsigned(max(1, stoi(value)));
+        else if (key == "level")
+            level = stoi(value);
+        else if (key == "profile")
+            profile_name = value;
+        else if (key == "think")
+            think = stoi(value);
+        else if (key == "seed")
+            seed = unsigned(stoul(value));
+        else
+        {
+            cerr << "usage: checkers_sessions [games=N] [threads=N] [level=N] [profile=<name>] [think=MS] [seed=N]\n";
+            return 1;
+        }
+    }
+    Config config;
+    search_profile profile;
+    if (!profile_name.empty() && !read_profile(config, profile_name, profile))
+    {
+        cerr << "unknown profile " << profile_name << "\n";
+        return 1;
+    }
+    const int max_turns = config("Game", "MaxNumTurns");
+    const int draw_plies = 2 * int(config("Game", "KingMovesDraw"));
+
+    mutex done_mutex;
+    condition_variable done_cv;
+    int finished = 0;
+    int results[3] = {};
+    size_t plies = 0;
+    {
+        // пул — раньше пула потоков, удалённые игроки — позже: потоки останавливаются в обратном порядке
+        LogicPool logics(&config);
+        Scheduler scheduler(threads);
+        RemotePlayers remote(think, seed);
+        auto engine = (profile_name.empty() ? make_shared<EngineSource>(scheduler, logics, level)
+                                            : make_shared<EngineSource>(scheduler, logics, profile));
+        auto player = make_shared<RemoteSource>(
+            [&remote](const shared_ptr<Session> &session, const turn_request &req) { remote.request(session, req); });
+
+        const auto start = steady::now();
+        for (int g = 0; g < games; ++g)
+        {
+            auto session = make_shared<Session>(scheduler, logics, engine, player, max_turns, draw_plies, [&](Session &s) {
+                const auto moves = s.moves();
+                lock_guard<mutex> lock(done_mutex);
+                ++results[s.result()];
+                plies += moves.size();
+                ++finished;
+                done_cv.notify_all();
+            });
+            session->start();
+        }
+        {
+            unique_lock<mutex> lock(done_mutex);
+            done_cv.wait(lock, [&]() { return finished == games; });
+        }
+        const double seconds = chrono::duration<double>(steady::now() - start).count();
+        cout << games << " games on " << scheduler.threads() << " threads: engine (white) +" << results[1] << " ="
+             << results[0] << " -" << results[2] << "\n"
+             << fixed << setprecision(2) << seconds << " s, " << setprecision(1) << games / seconds << " games/s, "
+             << double(plies) / seconds << " plies/s, up to " << remote.peak()
+             << " games waiting for a remote move at once\n"
+             << "engine nodes per move: mean " << setprecision(0) << double(engine->total_nodes()) / max<size_t>(1, (plies + 1) / 2)
+             << ", max " << engine->max_nodes();
+        if (!profile_name.empty())
+            cout << " (budget " << profile.nodes << ")";
+        cout << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,388 @@
+/**
+ * checkers_tree — разбор дампа дерева поиска (Models/Tree_dump.h): где и насколько хорошо срабатывают отсечения.
+ *
+ * Дамп пишет поиск сборки с опцией CMake CHECKERS_TREE_DUMP при непустом "TreeDumpFile" (не больше
+ * "TreeDumpNodes" узлов), например checkers_engine: position ... / go depth N / quit.
+ *
+ * Режимы:
+ *   checkers_tree stats <dump> [search]
+ *       без search — список поисков дампа (глубина, цвет, узлы); с search — ходы корня этого поиска:
+ *       окно, оценка, размер поддерева и его доля. Затем по глубинам: узлы, перебранные узлы, отсечения,
+ *       доля отсечений первым ходом, средний номер отсекающего хода, повторные поиски PVS, попадания в таблицу.
+ *   checkers_tree failures <dump> [search] [top]
+ *       top (по умолчанию 20) худших ошибок порядка ходов: отсечение не первым ходом или лучший ход
+ *       узла с открытым окном не первый; «лишние» узлы — поддеревья ходов, просмотренных до него.
+ *   checkers_tree export <dump> <search> <path> [levels] [dot]
+ *       поддерево поиска search по пути ходов от корня ("c3-d4,f6-e5"; "root" — весь поиск) на levels
+ *       уровней (по умолчанию 2) текстом или в формате Graphviz (dot).
+ * Номера поисков — с нуля, по порядку в файле.
+ */
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include "../Models/Tree_dump.h"
+#include "Protocol.h"
+
+namespace
+{
+const size_t kNone = size_t(-1);
+
+/**
+ * Дерево дампа: записи идут после своих поддеревьев, поэтому поддерево записи i — отрезок
+ * [i - size[i] + 1, i], а её дети — последняя запись перед ней и дальше назад через поддеревья.
+ */
+struct dump_tree
+{
+    tree_dump_header header;
+    vector<tree_record> records;
+    vector<size_t> size, parent;
+    // границы поисков: записи SEARCH (если первый поиск без неё — kNone) и конец каждого
+    vector<size_t> search_begin, search_end;
+
+    bool load(const string &path)
+    {
+        if (!read_tree_dump(path, header, records))
+            return false;
+        size.assign(records.size(), 1);
+        parent.assign(records.size(), kNone);
+        vector<size_t> stack;
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            if (records[i].kind() == tree_kind::SEARCH)
+            {
+                if (i > 0)
+                    search_end.push_back(i);
+                search_begin.push_back(i);
+                stack.clear();
+                continue;
+            }
+            if (search_begin.empty())
+                search_begin.push_back(kNone);
+            while (!stack.empty() && records[stack.back()].depth > records[i].depth)
+            {
+                size[i] += size[stack.back()];
+                parent[stack.back()] = i;
+                stack.pop_back();
+            }
+            stack.push_back(i);
+        }
+        if (!search_begin.empty())
+            search_end.push_back(records.size());
+        return true;
+    }
+
+    size_t searches() const
+    {
+        return search_begin.size();
+    }
+
+    size_t first(const size_t s) const
+    {
+        return search_begin[s] == kNone ? 0 : search_begin[s] + 1;
+    }
+
+    // узлы поиска s верхнего уровня (ходы корня, а при обрезанном дампе — и недописанные поддеревья)
+    vector<size_t> roots(const size_t s) const
+    {
+        return children_in(first(s), search_end[s]);
+    }
+
+    vector<size_t> children(const size_t i) const
+    {
+        return children_in(i + 1 - size[i], i);
+    }
+
+    string square(const uint8_t sq) const
+    {
+        return string(1, char('a' + (sq & 15))) + to_string(int(header.board) - (sq >> 4));
+    }
+
+    string move(const tree_record &r) const
+    {
+        return square(r.from) + ((r.flags & tree_record::CAPTURE) ? ":" : "-") + square(r.to);
+    }
+
+    string path(size_t i) const
+    {
+        string res;
+        for (; i != kNone; i = parent[i])
+            res = move(records[i]) + (res.empty() ? "" : "," + res);
+        return res;
+    }
+
+  private:
+    // узлы верхнего уровня отрезка [begin, end), по порядку
+    vector<size_t> children_in(const size_t begin, size_t end) const
+    {
+        vector<size_t> res;
+        while (end > begin)
+        {
+            res.push_back(end - 1);
+            end -= size[end - 1];
+        }
+        reverse(res.begin(), res.end());
+        return res;
+    }
+};
+
+int usage()
+{
+    cerr << "usage:\n"
+            "  checkers_tree stats <dump> [search]\n"
+            "  checkers_tree failures <dump> [search] [top]\n"
+            "  checkers_tree export <dump> <search> <path|root> [levels] [dot]\n";
+    return 1;
+}
+
+string bound_name(const SCORE_T v)
+{
+    return v < 0 ? "-inf" : v > INF ? "+inf" : score_name(v);
+}
+
+// окно узла: "(alpha, beta)" или "null alpha" для нулевого окна проверки PVS
+string window_name(const tree_record &r)
+{
+    if (r.flags & tree_record::NULL_WINDOW)
+        return "null " + bound_name(r.alpha);
+    return "(" + bound_name(r.alpha) + ", " + bound_name(r.beta) + ")";
+}
+
+const char *kind_name(const tree_kind kind)
+{
+    static const char *const names[] = {"node", "leaf", "batch", "tt", "draw", "mate", "end", "aborted", "search"};
+    return size_t(kind) < size(names) ? names[size_t(kind)] : "?";
+}
+
+bool load(const string &path, dump_tree &tree)
+{
+    if (!tree.load(path))
+    {
+        cerr << "can't read search tree dump " << path << "\n";
+        return false;
+    }
+    cout << tree.records.size() << " records, " << tree.header.dropped << " nodes dropped (limit "
+         << tree.header.limit << "), " << tree.searches() << " searches\n";
+    return true;
+}
+
+bool check_search(const dump_tree &tree, const long s)
+{
+    if (s >= 0 && size_t(s) < tree.searches())
+        return true;
+    cerr << "no search " << s << " (0.." << long(tree.searches()) - 1 << ")\n";
+    return false;
+}
+
+// счётчики одной глубины
+struct depth_stats
+{
+    uint64_t nodes = 0, expanded = 0, cuts = 0, first_cuts = 0, cut_index_sum = 0, researches = 0, tt = 0;
+};
+
+void add_depths(const dump_tree &tree, const size_t s, map<int, depth_stats> &depths)
+{
+    for (size_t i = tree.first(s); i < tree.search_end[s]; ++i)
+    {
+        const tree_record &r = tree.records[i];
+        depth_stats &d = depths[r.depth];
+        ++d.nodes;
+        d.expanded += (r.kind() == tree_kind::NODE);
+        d.tt += (r.kind() == tree_kind::TT);
+        d.researches += ((r.flags & tree_record::RESEARCH) != 0);
+        if (r.cut != tree_record::NONE)
+        {
+            ++d.cuts;
+            d.first_cuts += (r.cut == 0);
+            d.cut_index_sum += r.cut;
+        }
+    }
+}
+
+int run_stats(const string &path, const long search)
+{
+    dump_tree tree;
+    if (!load(path, tree))
+        return 1;
+    map<int, depth_stats> depths;
+    if (search < 0)
+    {
+        for (size_t s = 0; s < tree.searches(); ++s)
+        {
+            const size_t b = tree.search_begin[s];
+            cout << "search " << s;
+            if (b != kNone)
+                cout << ": depth " << int(tree.records[b].depth) << ", " << (tree.records[b].from ? "black" : "white");
+            cout << ", " << tree.search_end[s] - tree.first(s) << " nodes\n";
+            add_depths(tree, s, depths);
+        }
+    }
+    else
+    {
+        if (!check_search(tree, search))
+            return 1;
+        const size_t s = size_t(search);
+        const double total = double(max<size_t>(1, tree.search_end[s] - tree.first(s)));
+        cout << "search " << s << ", " << tree.search_end[s] - tree.first(s) << " nodes\n";
+        cout << "  move      window                 score          nodes      share\n";
+        for (const size_t i : tree.roots(s))
+        {
+            const tree_record &r = tree.records[i];
+            cout << "  " << left << setw(9) << tree.move(r) << " " << setw(22)
+                 << window_name(r) << " " << setw(14)
+                 << bound_name(r.score) << right << setw(6) << tree.size[i] << fixed << setprecision(1) << setw(10)
+                 << 100.0 * double(tree.size[i]) / total << "%"
+                 << ((r.flags & tree_record::RESEARCH) ? "  research" : "")
+                 << (r.kind() != tree_kind::NODE ? string("  ") + kind_name(r.kind()) : "") << "\n";
+        }
+        add_depths(tree, s, depths);
+    }
+    cout << "depth      nodes   expanded       cuts  first-cut  mean-cut  researches         tt\n";
+    for (const auto &[depth, d] : depths)
+        cout << setw(5) << depth << setw(11) << d.nodes << setw(11) << d.expanded << setw(11) << d.cuts << fixed
+             << setprecision(1) << setw(10) << (d.cuts ? 100.0 * double(d.first_cuts) / double(d.cuts) : 0.0) << "%"
+             << setprecision(2) << setw(10) << (d.cuts ? double(d.cut_index_sum) / double(d.cuts) : 0.0)
+             << setw(12) << d.researches << setw(11) << d.tt << "\n";
+    return 0;
+}
+
+int run_failures(const string &path, const long search, const size_t top)
+{
+    dump_tree tree;
+    if (!load(path, tree))
+        return 1;
+    if (search >= 0 && !check_search(tree, search))
+        return 1;
+    struct failure
+    {
+        size_t search, node, wasted;
+    };
+    vector<failure> failures;
+    for (size_t s = 0; s < tree.searches(); ++s)
+    {
+        if (search >= 0 && s != size_t(search))
+            continue;
+        for (size_t i = tree.first(s); i < tree.search_end[s]; ++i)
+        {
+            const tree_record &r = tree.records[i];
+            const bool open = (r.beta - r.alpha > 1);
+            // ход, который должен был идти первым: отсекающий или лучший в узле с открытым окном
+            const uint8_t key = (r.cut != tree_record::NONE ? r.cut : open ? r.best : tree_record::NONE);
+            if (r.kind() != tree_kind::NODE || key == tree_record::NONE || key == 0)
+                continue;
+            size_t wasted = 0;
+            for (const size_t c : tree.children(i))
+                if (tree.records[c].order < key)
+                    wasted += tree.size[c];
+            failures.push_back({s, i, wasted});
+        }
+    }
+    sort(failures.begin(), failures.end(), [](const failure &a, const failure &b) { return a.wasted > b.wasted; });
+    size_t wasted_total = 0;
+    for (const auto &f : failures)
+        wasted_total += f.wasted;
+    cout << failures.size() << " ordering failures, " << wasted_total << " nodes before the right move\n";
+    for (size_t k = 0; k < failures.size() && k < top; ++k)
+    {
+        const auto &f = failures[k];
+        const tree_record &r = tree.records[f.node];
+        cout << "search " << f.search << " depth " << int(r.depth) << " "
+             << (r.cut != tree_record::NONE ? "cut by move " + to_string(r.cut) : "best move " + to_string(r.best))
+             << " of " << int(r.moves) << ", wasted " << f.wasted << " of " << tree.size[f.node]
+             << " nodes, path " << tree.path(f.node) << "\n";
+    }
+    return 0;
+}
+
+void export_text(const dump_tree &tree, const size_t i, const int levels, const int indent)
+{
+    const tree_record &r = tree.records[i];
+    cout << string(size_t(indent) * 2, ' ') << tree.move(r) << " #" << int(r.order) << " " << kind_name(r.kind())
+         << " " << window_name(r) << " score " << bound_name(r.score) << " nodes "
+         << tree.size[i];
+    if (r.cut != tree_record::NONE)
+        cout << " cut " << int(r.cut);
+    if (r.best != tree_record::NONE)
+        cout << " best " << int(r.best);
+    if (r.flags & tree_record::RESEARCH)
+        cout << " research";
+    cout << "\n";
+    if (levels > 0)
+        for (const size_t c : tree.children(i))
+            export_text(tree, c, levels - 1, indent + 1);
+}
+
+void export_dot(const dump_tree &tree, const size_t i, const int levels)
+{
+    const tree_record &r = tree.records[i];
+    cout << "  n" << i << " [label=\"" << tree.move(r) << "\\n" << bound_name(r.score) << "\\n" << tree.size[i]
+         << " nodes\"" << (r.cut != tree_record::NONE ? ", color=red" : "")
+         << ((r.flags & tree_record::NULL_WINDOW) ? ", style=dashed" : "") << "];\n";
+    if (levels <= 0)
+        return;
+    for (const size_t c : tree.children(i))
+    {
+        export_dot(tree, c, levels - 1);
+        cout << "  n" << i << " -> n" << c << " [label=\"" << int(tree.records[c].order) << "\"];\n";
+    }
+}
+
+int run_export(const string &path, const long search, const string &moves, const int levels, const bool dot)
+{
+    dump_tree tree;
+    if (!load(path, tree) || !check_search(tree, search))
+        return 1;
+    // узлы текущего уровня пути: по последнему (после повторного поиска) узлу с нужным ходом
+    vector<size_t> level = tree.roots(size_t(search));
+    string rest = (moves == "root" ? "" : moves);
+    while (!rest.empty())
+    {
+        const size_t comma = rest.find(',');
+        const auto cells = parse_series(rest.substr(0, comma));
+        rest = (comma == string::npos ? "" : rest.substr(comma + 1));
+        size_t found = kNone;
+        for (const size_t i : level)
+        {
+            const tree_record &r = tree.records[i];
+            if (cells.size() >= 2 && r.from == ((cells.front().first << 4) | cells.front().second) &&
+                r.to == ((cells.back().first << 4) | cells.back().second))
+                found = i;
+        }
+        if (found == kNone)
+        {
+            cerr << "no such move in the dump: " << moves << "\n";
+            return 1;
+        }
+        level = {found};
+        if (!rest.empty())
+            level = tree.children(found);
+    }
+    if (dot)
+        cout << "digraph search {\n  node [shape=box];\n";
+    for (const size_t i : level)
+    {
+        if (dot)
+            export_dot(tree, i, levels);
+        else
+            export_text(tree, i, levels, 0);
+    }
+    if (dot)
+        cout << "}\n";
+    return 0;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+        return usage();
+    const string mode = argv[1];
+    if (mode == "stats")
+        return run_stats(argv[2], argc > 3 ? stol(argv[3]) : -1);
+    if (mode == "failures")
+        return run_failures(argv[2], argc > 3 ? stol(argv[3]) : -1, argc > 4 ? size_t(stoul(argv[4])) : 20);
+    if (mode == "export" && argc > 4)
+        return run_export(argv[2], stol(argv[3]), argv[4], argc > 5 ? stoi(argv[5]) : 2,
+                          argc > 6 && string(argv[6]) == "dot");
+    return usage();
+}
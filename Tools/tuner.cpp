@@ -0,0 +1,707 @@
+/**
+ * checkers_tuner — подбор весов оценки "NumberAndPotential" (Texel tuning) и обучение сети NNUE.
+ *
+ * Режимы:
+ *   checkers_tuner selfplay <out.bin> <games> [depth] [threads] [archive]
+ *       партии бот против бота; позиции без обязательных взятий пишутся
+ *       в out.bin с меткой итога партии; сами партии — в архив archive (Game/Archive.h), если он задан.
+ *   checkers_tuner pdn <in.pdn> <out.bin>
+ *       импорт партий из PDN (алгебраическая нотация русских шашек).
+ *   checkers_tuner tune <data.bin> <weights.json> [epochs] [threads] [lr]
+ *       подбор весов градиентным спуском (Adam) по логистической функции потерь
+ *       (p - sigmoid(K * e))^2, где e = ln(W / B) — оценка calc_score с точки зрения белых.
+ *       Начальные веса — из файла "WeightsFile" в settings.json.
+ *   checkers_tuner nnue <data.bin> <out.nnue> [epochs] [threads] [lr]
+ *       обучение сети для BotScoringType = "NNUE" (Game/Nnue.h) на тех же данных: выход сети учится
+ *       в шкале e оценки tune (K — по весам "WeightsFile"), Adam по пакетам позиций; последние 5% позиций —
+ *       проверочные. Сеть квантуется в int16/int8 и пишется в out.nnue ("NnueFile" в settings.json).
+ *
+ * Данные читаются потоково блоками, каждый поток обрабатывает свой диапазон записей.
+ */
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "../Game/Archive.h"
+#include "../Game/Logic.h"
+#include "../Models/Notation.h"
+#include "../Models/Packed_position.h"
+
+namespace
+{
+// количество первых случайных полуходов в самоигре (разнообразие дебютов)
+const int kRandomPlies = 6;
+
+// блок чтения данных одним потоком
+const size_t kChunk = 1 << 16;
+
+// число подбираемых параметров: man[1..6] и king (man[0] = 1 фиксирует масштаб)
+const int kParams = 7;
+
+// 1 — ничья, 2 — победа белых, 0 — победа чёрных; -1 — неизвестно
+int parse_result(const string &token)
+{
+    if (token == "1-0" || token == "2-0")
+        return 2;
+    if (token == "0-1" || token == "0-2")
+        return 0;
+    if (token == "1/2-1/2" || token == "1-1")
+        return 1;
+    return -1;
+}
+
+unsigned default_threads()
+{
+    return max(1u, thread::hardware_concurrency());
+}
+
+// ==== SELFPLAY ====
+
+int run_selfplay(const string &out_path, const int games, const int depth, const unsigned threads,
+                 const string &archive_file)
+{
+    Config config;
+    const int max_turns = config("Game", "MaxNumTurns");
+    PositionWriter writer(out_path);
+    if (!writer.ok())
+    {
+        cerr << "can't open " << out_path << "\n";
+        return 1;
+    }
+    mutex writer_mutex;
+    ArchiveWriter archive(&config);
+    if (!archive_file.empty() && !archive.open(archive_file))
+        cerr << "can't open game archive " << archive_file << "\n";
+    atomic<int> next_game{0};
+    const unsigned seed = unsigned(chrono::steady_clock::now().time_since_epoch().count());
+
+    auto worker = [&](const unsigned id) {
+        Logic logic(&config);
+        logic.Max_depth = depth;
+        mt19937 rng(seed + id);
+        int game;
+        while ((game = next_game++) < games)
+        {
+            auto mtx = start_position();
+            vector<packed_position> positions;
+            vector<vector<vector<POS_T>>> played{mtx};
+            int result = 1;
+            for (int turn = 0; turn < max_turns; ++turn)
+            {
+                const bool color = turn % 2;
+                logic.find_turns(color, mtx);
+                if (logic.turns.empty())
+                {
+                    result = (color ? 2 : 0);
+                    break;
+                }
+                if (!logic.have_beats)
+                    positions.push_back(packed_position::pack(mtx, color, 0));
+                if (turn >= kRandomPlies)
+                {
+                    for (const auto &step : logic.find_best_turns(color, mtx))
+                        mtx = logic.make_turn(mtx, step);
+                    played.push_back(mtx);
+                    continue;
+                }
+                // случайный ход (серия взятий — целиком)
+                mtx = logic.make_turn(mtx, logic.turns[rng() % logic.turns.size()]);
+                played.push_back(mtx);
+            }
+            if (archive.is_open())
+                archive.append_positions(played, false, result == 1 ? 0 : (result == 2 ? 1 : 2));
+            lock_guard<mutex> lock(writer_mutex);
+            for (auto &pos : positions)
+            {
+                pos.meta = uint8_t((pos.meta & ~3) | result);
+                writer.add(pos);
+            }
+            if ((game + 1) % 100 == 0)
+                cout << "games: " << game + 1 << ", positions: " << writer.count << endl;
+        }
+    };
+    vector<thread> pool;
+    for (unsigned t = 0; t < threads; ++t)
+        pool.emplace_back(worker, t);
+    for (auto &th : pool)
+        th.join();
+    cout << "written " << writer.count << " positions to " << out_path << "\n";
+    return writer.ok() ? 0 : 1;
+}
+
+// ==== PDN ====
+
+int run_pdn(const string &in_path, const string &out_path)
+{
+    ifstream fin(in_path);
+    if (!fin)
+    {
+        cerr << "can't open " << in_path << "\n";
+        return 1;
+    }
+    const string text((istreambuf_iterator<char>(fin)), istreambuf_iterator<char>());
+    PositionWriter writer(out_path);
+    Config config;
+    Logic logic(&config);
+
+    string fen;
+    vector<string> moves;
+    int result = -1, games = 0, broken = 0;
+
+    auto finish_game = [&]() {
+        if (result != -1 && !moves.empty())
+        {
+            vector<vector<POS_T>> mtx = start_position();
+            bool color = false;
+            if (!fen.empty() && !parse_fen(fen, mtx, color))
+                moves.clear();
+            vector<packed_position> positions;
+            for (const auto &move : moves)
+            {
+                const auto series = logic.resolve_series(color, mtx, parse_series(move));
+                if (series.empty())
+                {
+                    ++broken;
+                    break;
+                }
+                if (series[0].xb == -1)
+                    positions.push_back(packed_position::pack(mtx, color, result));
+                for (const auto &step : series)
+                    mtx = logic.make_turn(mtx, step);
+                color = !color;
+            }
+            for (const auto &pos : positions)
+                writer.add(pos);
+            ++games;
+        }
+        fen.clear();
+        moves.clear();
+        result = -1;
+    };
+
+    size_t i = 0;
+    bool in_movetext = false;
+    while (i < text.size())
+    {
+        const char c = text[i];
+        if (isspace((unsigned char)c))
+        {
+            ++i;
+        }
+        else if (c == '{')
+        {
+            i = min(text.size(), text.find('}', i) + 1);
+        }
+        else if (c == '(')
+        {
+            for (int level = 0; i < text.size(); ++i)
+            {
+                level += (text[i] == '(') - (text[i] == ')');
+                if (!level)
+                    break;
+            }
+            ++i;
+        }
+        else if (c == '[')
+        {
+            if (in_movetext)
+                finish_game();
+            in_movetext = false;
+            const size_t end = min(text.size(), text.find(']', i));
+            istringstream tag(text.substr(i + 1, end - i - 1));
+            string name, value;
+            tag >> name;
+            getline(tag, value);
+            const size_t q1 = value.find('"'), q2 = value.rfind('"');
+            value = (q1 != string::npos && q2 > q1) ? value.substr(q1 + 1, q2 - q1 - 1) : "";
+            if (name == "FEN")
+                fen = value;
+            else if (name == "Result")
+                result = parse_result(value);
+            i = end + 1;
+        }
+        else
+        {
+            in_movetext = true;
+            size_t end = i;
+            while (end < text.size() && !isspace((unsigned char)text[end]) && !strchr("{([", text[end]))
+                ++end;
+            string token = text.substr(i, end - i);
+            i = end;
+            // номер хода, возможно слитный с ходом: "12.", "12...", "12.c3-d4"
+            size_t skip = 0;
+            while (skip < token.size() && isdigit((unsigned char)token[skip]))
+                ++skip;
+            if (skip < token.size() && token[skip] == '.')
+            {
+                while (skip < token.size() && token[skip] == '.')
+                    ++skip;
+                token = token.substr(skip);
+            }
+            if (token.empty())
+                continue;
+            if (parse_result(token) != -1 || token == "*")
+            {
+                if (parse_result(token) != -1)
+                    result = parse_result(token);
+                finish_game();
+                in_movetext = false;
+                continue;
+            }
+            moves.push_back(token);
+        }
+    }
+    finish_game();
+    cout << "games: " << games << ", broken: " << broken << ", positions: " << writer.count << "\n";
+    return writer.ok() ? 0 : 1;
+}
+
+// ==== TUNE ====
+
+// количество единичных битов в полубайте
+const array<uint8_t, 16> kNibbleCount = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+inline int popcount32(uint32_t v)
+{
+    int res = 0;
+    for (; v; v >>= 4)
+        res += kNibbleCount[v & 15];
+    return res;
+}
+
+struct batch_stats
+{
+    double loss = 0;
+    size_t count = 0;
+    array<double, kParams> grad{};
+};
+
+/**
+ * Потери и (при need_grad) градиент по диапазону записей [first, last).
+ */
+void accumulate(const string &path, const size_t first, const size_t last, const EvalWeights &w, const double K,
+                const bool need_grad, batch_stats &stats)
+{
+    PositionReader reader(path);
+    vector<packed_position> chunk;
+    for (size_t pos = first; pos < last; pos += kChunk)
+    {
+        const size_t cnt = reader.read(pos, min(kChunk, last - pos), chunk);
+        for (size_t k = 0; k < cnt; ++k)
+        {
+            const packed_position &p = chunk[k];
+            const uint32_t wm = p.white & ~p.kings, bm = p.black & ~p.kings;
+            // число шашек по продвижению (a = 0..6) и дамок каждой стороны
+            array<int, 7> nw{}, nb{};
+            for (int row = 0; row < 8; ++row)
+            {
+                const int cw = kNibbleCount[(wm >> (4 * row)) & 15], cb = kNibbleCount[(bm >> (4 * row)) & 15];
+                if (cw)
+                    nw[min(6, 7 - row)] += cw;
+                if (cb)
+                    nb[min(6, row)] += cb;
+            }
+            const int kw = popcount32(p.white & p.kings), kb = popcount32(p.black & p.kings);
+            double W = w.king * kw, B = w.king * kb;
+            for (int a = 0; a < 7; ++a)
+            {
+                W += w.man[a] * nw[a];
+                B += w.man[a] * nb[a];
+            }
+            if (W <= 0 || B <= 0)
+                continue;
+            const double e = log(W) - log(B);
+            const double prob = 1.0 / (1.0 + exp(-K * e));
+            const double target = p.result() / 2.0;
+            stats.loss += (target - prob) * (target - prob);
+            ++stats.count;
+            if (!need_grad)
+                continue;
+            const double de = -2.0 * (target - prob) * prob * (1 - prob) * K;
+            for (int a = 1; a < 7; ++a)
+                stats.grad[a - 1] += de * (nw[a] / W - nb[a] / B);
+            stats.grad[6] += de * (kw / W - kb / B);
+        }
+    }
+}
+
+batch_stats parallel_pass(const string &path, const size_t total, const EvalWeights &w, const double K,
+                          const bool need_grad, const unsigned threads)
+{
+    vector<batch_stats> part(threads);
+    vector<thread> pool;
+    for (unsigned t = 0; t < threads; ++t)
+        pool.emplace_back(accumulate, cref(path), total * t / threads, total * (t + 1) / threads, cref(w), K,
+                          need_grad, ref(part[t]));
+    for (auto &th : pool)
+        th.join();
+    batch_stats res;
+    for (const auto &p : part)
+    {
+        res.loss += p.loss;
+        res.count += p.count;
+        for (int k = 0; k < kParams; ++k)
+            res.grad[k] += p.grad[k];
+    }
+    if (res.count)
+    {
+        res.loss /= double(res.count);
+        for (auto &g : res.grad)
+            g /= double(res.count);
+    }
+    return res;
+}
+
+/**
+ * Подбор масштаба K (золотое сечение) на первых записях при начальных весах.
+ */
+double fit_k(const string &path, const size_t total, const EvalWeights &w, const unsigned threads)
+{
+    const size_t sample = min<size_t>(total, 1 << 20);
+    double lo = 0.05, hi = 20;
+    const double ratio = (sqrt(5.0) - 1) / 2;
+    for (int it = 0; it < 30; ++it)
+    {
+        const double k1 = hi - ratio * (hi - lo), k2 = lo + ratio * (hi - lo);
+        if (parallel_pass(path, sample, w, k1, false, threads).loss < parallel_pass(path, sample, w, k2, false, threads).loss)
+            hi = k2;
+        else
+            lo = k1;
+    }
+    return (lo + hi) / 2;
+}
+
+int run_tune(const string &data_path, const string &out_path, const int epochs, const unsigned threads, const double lr)
+{
+    PositionReader reader(data_path);
+    if (!reader.ok() || !reader.total)
+    {
+        cerr << "can't read positions from " << data_path << "\n";
+        return 1;
+    }
+    const size_t total = reader.total;
+    Config config;
+    EvalWeights w;
+    const string weights_file = config("Bot", "WeightsFile");
+    w.load(project_path + weights_file);
+
+    const double K = fit_k(data_path, total, w, threads);
+    cout << "positions: " << total << ", K = " << K << "\n";
+
+    // Adam
+    array<double, kParams> m{}, v{};
+    const double beta1 = 0.9, beta2 = 0.999, eps = 1e-8;
+    double loss = 0;
+    for (int epoch = 1; epoch <= epochs; ++epoch)
+    {
+        auto start = chrono::steady_clock::now();
+        const batch_stats stats = parallel_pass(data_path, total, w, K, true, threads);
+        loss = stats.loss;
+        for (int k = 0; k < kParams; ++k)
+        {
+            m[k] = beta1 * m[k] + (1 - beta1) * stats.grad[k];
+            v[k] = beta2 * v[k] + (1 - beta2) * stats.grad[k] * stats.grad[k];
+            const double step = lr * (m[k] / (1 - pow(beta1, epoch))) / (sqrt(v[k] / (1 - pow(beta2, epoch))) + eps);
+            double &param = (k < 6 ? w.man[k + 1] : w.king);
+            param = max(0.01, param - step);
+        }
+        auto end = chrono::steady_clock::now();
+        if (epoch == 1 || epoch % 10 == 0 || epoch == epochs)
+            cout << "epoch " << epoch << ": loss " << loss << " ("
+                 << (int)chrono::duration<double, milli>(end - start).count() << " millisec)" << endl;
+    }
+    if (!w.save(out_path, {{"K", K}, {"Loss", loss}, {"Positions", total}}))
+    {
+        cerr << "can't write " << out_path << "\n";
+        return 1;
+    }
+    cout << "weights written to " << out_path << "\n";
+    return 0;
+}
+
+// ==== NNUE ====
+
+// позиций в шаге Adam при обучении сети
+const size_t kNnueBatch = 4096;
+
+// последняя 1/kNnueHoldout часть файла (позиции других партий) — проверочная, в обучении не участвует
+const size_t kNnueHoldout = 20;
+
+// пределы весов, при которых сеть квантуется без переполнения (Nnue::quantize):
+// аккумулятор — до 24 фигур × kMaxFeature × kClip в int16, выход — в int8 при out_scale >= 1
+const float kMaxFeature = 8.0f, kMaxOut = 12.0f;
+
+// позиция для обучения сети: активные входы (Nnue::feature) и итог для белых (0, 0.5, 1)
+struct nnue_sample
+{
+    uint8_t n = 0;
+    uint8_t features[24];
+    float target = 0;
+};
+
+nnue_sample make_sample(const packed_position &p)
+{
+    nnue_sample s;
+    for (int sq = 0; sq < 32 && s.n < 24; ++sq)
+    {
+        const uint32_t bit = 1u << sq;
+        if ((p.white | p.black) & bit)
+        {
+            const POS_T type = POS_T(((p.white & bit) ? 1 : 2) + ((p.kings & bit) ? 2 : 0));
+            s.features[s.n++] = uint8_t(Nnue::feature(type, sq));
+        }
+    }
+    s.target = float(p.result()) / 2;
+    return s;
+}
+
+/**
+ * Параметры сети в float (или градиенты по ним) одним массивом: первый слой [kInputs][kHidden],
+ * смещения скрытого слоя, веса выхода, смещение выхода.
+ */
+struct nnue_params
+{
+    static constexpr size_t kBias = size_t(Nnue::kInputs) * Nnue::kHidden;
+    static constexpr size_t kOut = kBias + Nnue::kHidden;
+    static constexpr size_t kOutBias = kOut + Nnue::kHidden;
+    static constexpr size_t kSize = kOutBias + 1;
+
+    vector<float> p = vector<float>(kSize);
+
+    // предел параметра k, при котором сеть квантуется без переполнения
+    static float limit(const size_t k)
+    {
+        return k < kOut ? kMaxFeature : kMaxOut;
+    }
+};
+
+/**
+ * Выход сети e для позиции s (в шкале ln(W / B)); hidden — значения скрытых нейронов до clamp.
+ */
+float nnue_forward(const nnue_params &net, const nnue_sample &s, float *hidden)
+{
+    const float *p = net.p.data();
+    for (int h = 0; h < Nnue::kHidden; ++h)
+        hidden[h] = p[nnue_params::kBias + h];
+    for (int k = 0; k < s.n; ++k)
+    {
+        const float *w = p + size_t(s.features[k]) * Nnue::kHidden;
+        for (int h = 0; h < Nnue::kHidden; ++h)
+            hidden[h] += w[h];
+    }
+    float e = p[nnue_params::kOutBias];
+    for (int h = 0; h < Nnue::kHidden; ++h)
+        e += min(1.0f, max(0.0f, hidden[h])) * p[nnue_params::kOut + h];
+    return e;
+}
+
+/**
+ * Сумма потерь (target - sigmoid(K * e))^2 по позициям [first, last); при grad != nullptr
+ * к grad прибавляется их градиент.
+ */
+double nnue_pass(const nnue_params &net, const vector<nnue_sample> &data, const size_t first, const size_t last,
+                 const double K, nnue_params *grad)
+{
+    float hidden[Nnue::kHidden];
+    double loss = 0;
+    for (size_t k = first; k < last; ++k)
+    {
+        const nnue_sample &s = data[k];
+        const double prob = 1.0 / (1.0 + exp(-K * nnue_forward(net, s, hidden)));
+        loss += (s.target - prob) * (s.target - prob);
+        if (!grad)
+            continue;
+        float *g = grad->p.data();
+        const float de = float(-2.0 * (s.target - prob) * prob * (1 - prob) * K);
+        g[nnue_params::kOutBias] += de;
+        for (int h = 0; h < Nnue::kHidden; ++h)
+        {
+            const bool active = hidden[h] > 0.0f && hidden[h] < 1.0f;
+            g[nnue_params::kOut + h] += de * min(1.0f, max(0.0f, hidden[h]));
+            // дальше hidden — градиент по входу нейрона
+            hidden[h] = (active ? de * net.p[nnue_params::kOut + h] : 0.0f);
+            g[nnue_params::kBias + h] += hidden[h];
+        }
+        for (int f = 0; f < s.n; ++f)
+        {
+            float *gw = g + size_t(s.features[f]) * Nnue::kHidden;
+            for (int h = 0; h < Nnue::kHidden; ++h)
+                gw[h] += hidden[h];
+        }
+    }
+    return loss;
+}
+
+/**
+ * Сумма потерь по data[first, last) в threads потоках; при grads != nullptr в (*grads)[0] — сумма градиентов.
+ */
+double nnue_parallel(const nnue_params &net, const vector<nnue_sample> &data, const size_t first, const size_t last,
+                     const double K, const unsigned threads, vector<nnue_params> *grads)
+{
+    vector<double> part(threads);
+    vector<thread> pool;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        nnue_params *grad = nullptr;
+        if (grads)
+        {
+            grad = &(*grads)[t];
+            fill(grad->p.begin(), grad->p.end(), 0.0f);
+        }
+        pool.emplace_back([&, t, grad]() {
+            part[t] = nnue_pass(net, data, first + (last - first) * t / threads,
+                                first + (last - first) * (t + 1) / threads, K, grad);
+        });
+    }
+    for (auto &th : pool)
+        th.join();
+    if (grads)
+        for (unsigned t = 1; t < threads; ++t)
+            for (size_t k = 0; k < nnue_params::kSize; ++k)
+                (*grads)[0].p[k] += (*grads)[t].p[k];
+    double loss = 0;
+    for (const double p : part)
+        loss += p;
+    return loss;
+}
+
+/**
+ * Обучение сети Nnue (128 входов → kHidden → 1) на тех же данных, что tune: выход сети — оценка e
+ * в шкале ln(W / B) с подобранным по весам "WeightsFile" K, потери — (p - sigmoid(K * e))^2,
+ * Adam по пакетам kNnueBatch позиций. Сеть квантуется (Nnue::quantize) и пишется в формате Nnue::save.
+ */
+int run_nnue(const string &data_path, const string &out_path, const int epochs, const unsigned threads, const double lr)
+{
+    PositionReader reader(data_path);
+    if (!reader.ok() || !reader.total)
+    {
+        cerr << "can't read positions from " << data_path << "\n";
+        return 1;
+    }
+    const size_t total = reader.total;
+    Config config;
+    EvalWeights w;
+    const string weights_file = config("Bot", "WeightsFile");
+    w.load(project_path + weights_file);
+    // тот же K, что у tune: calc_nnue_score переводит выход сети в шкалу поиска как exp(e), e ~ ln(W / B)
+    const double K = fit_k(data_path, total, w, threads);
+
+    vector<nnue_sample> train, check;
+    vector<packed_position> chunk;
+    for (size_t pos = 0; pos < total; pos += kChunk)
+    {
+        const size_t cnt = reader.read(pos, kChunk, chunk);
+        for (size_t k = 0; k < cnt; ++k)
+            if (chunk[k].white && chunk[k].black)
+                (pos + k < total - total / kNnueHoldout ? train : check).push_back(make_sample(chunk[k]));
+    }
+    cout << "positions: " << train.size() << " train, " << check.size() << " check, K = " << K << "\n";
+
+    mt19937 rng(1);
+    uniform_real_distribution<float> init(-0.05f, 0.05f);
+    nnue_params net;
+    for (size_t k = 0; k < nnue_params::kSize; ++k)
+        net.p[k] = (k >= nnue_params::kBias && k < nnue_params::kOut ? 0.5f : init(rng));
+    net.p[nnue_params::kOutBias] = 0;
+
+    // Adam
+    nnue_params m, v;
+    vector<nnue_params> grads(threads);
+    const double beta1 = 0.9, beta2 = 0.999, eps = 1e-8;
+    int64_t step = 0;
+    for (int epoch = 1; epoch <= epochs; ++epoch)
+    {
+        auto start = chrono::steady_clock::now();
+        shuffle(train.begin(), train.end(), rng);
+        double loss = 0;
+        for (size_t first = 0; first < train.size(); first += kNnueBatch)
+        {
+            const size_t last = min(train.size(), first + kNnueBatch);
+            loss += nnue_parallel(net, train, first, last, K, threads, &grads);
+            ++step;
+            const double c1 = 1 - pow(beta1, double(step)), c2 = 1 - pow(beta2, double(step));
+            for (size_t k = 0; k < nnue_params::kSize; ++k)
+            {
+                const double g = grads[0].p[k] / double(last - first);
+                m.p[k] = float(beta1 * m.p[k] + (1 - beta1) * g);
+                v.p[k] = float(beta2 * v.p[k] + (1 - beta2) * g * g);
+                const float limit = nnue_params::limit(k);
+                net.p[k] = min(limit, max(-limit, float(net.p[k] - lr * (m.p[k] / c1) / (sqrt(v.p[k] / c2) + eps))));
+            }
+        }
+        auto end = chrono::steady_clock::now();
+        cout << "epoch " << epoch << ": loss " << loss / double(max<size_t>(1, train.size())) << ", check "
+             << nnue_parallel(net, check, 0, check.size(), K, threads, nullptr) / double(max<size_t>(1, check.size()))
+             << " (" << (int)chrono::duration<double, milli>(end - start).count() << " millisec)" << endl;
+    }
+
+    const float *p = net.p.data();
+    const auto nnue = Nnue::quantize(p + nnue_params::kBias, p, p + nnue_params::kOut, p[nnue_params::kOutBias]);
+    if (!nnue)
+    {
+        cerr << "network weights don't fit the int16/int8 format\n";
+        return 1;
+    }
+    // квантованная сеть на проверочных позициях — тем же путём, что в поиске (refresh + evaluate)
+    double quantized = 0;
+    for (const auto &s : check)
+    {
+        packed_position pos;
+        for (int k = 0; k < s.n; ++k)
+        {
+            const int type = s.features[k] / Nnue::kSquares + 1, sq = s.features[k] % Nnue::kSquares;
+            ((type % 2) ? pos.white : pos.black) |= 1u << sq;
+            if (type > 2)
+                pos.kings |= 1u << sq;
+        }
+        const double e = nnue->evaluate(nnue->refresh(pos.unpack())) / 1000.0;
+        const double prob = 1.0 / (1.0 + exp(-K * e));
+        quantized += (s.target - prob) * (s.target - prob);
+    }
+    const double material = parallel_pass(data_path, total, w, K, false, threads).loss;
+    cout << "check loss: quantized network " << quantized / double(max<size_t>(1, check.size()))
+         << ", weights from " << weights_file << " (all positions) " << material << "\n";
+    if (!nnue->save(out_path))
+    {
+        cerr << "can't write " << out_path << "\n";
+        return 1;
+    }
+    cout << "network written to " << out_path << "\n";
+    return 0;
+}
+
+int usage()
+{
+    cerr << "usage:\n"
+            "  checkers_tuner selfplay <out.bin> <games> [depth=2] [threads] [archive]\n"
+            "  checkers_tuner pdn <in.pdn> <out.bin>\n"
+            "  checkers_tuner tune <data.bin> <weights.json> [epochs=200] [threads] [lr=0.01]\n"
+            "  checkers_tuner nnue <data.bin> <out.nnue> [epochs=30] [threads] [lr=0.001]\n";
+    return 2;
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4)
+        return usage();
+    const string mode = argv[1];
+    if (mode == "selfplay")
+        return run_selfplay(argv[2], stoi(argv[3]), argc > 4 ? stoi(argv[4]) : 2,
+                            argc > 5 ? unsigned(stoi(argv[5])) : default_threads(), argc > 6 ? argv[6] : "");
+    if (mode == "pdn")
+        return run_pdn(argv[2], argv[3]);
+    if (mode == "tune")
+        return run_tune(argv[2], argv[3], argc > 4 ? stoi(argv[4]) : 200,
+                        argc > 5 ? unsigned(stoi(argv[5])) : default_threads(), argc > 6 ? stod(argv[6]) : 0.01);
+    if (mode == "nnue")
+        return run_nnue(argv[2], argv[3], argc > 4 ? stoi(argv[4]) : 30,
+                        argc > 5 ? unsigned(stoi(argv[5])) : default_threads(), argc > 6 ? stod(argv[6]) : 0.001);
+    return usage();
+}
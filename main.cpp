@@ -2,8 +2,14 @@
 
 int main(int argc, char* argv[])
 {
-    Game g;
-    g.play();
+    TRACE_THREAD("main");
+    // правила и размер доски — из settings.json ("Game" → "Variant"), для каждого варианта свой движок
+    with_variant(Config()("Game", "Variant"), [](auto rules) {
+        BasicGame<decltype(rules)> g;
+        g.play();
+    });
+    // сборка с CHECKERS_TRACE: интервалы игрового цикла для chrome://tracing / ui.perfetto.dev
+    TRACE_WRITE(project_path + "trace.json");
 
     return 0;
 }